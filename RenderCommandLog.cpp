@@ -0,0 +1,63 @@
+#include "stdafx.h"
+
+unsigned int RenderCommandLog::HashName(const char * const name)
+{
+   return (unsigned int)StringHash(name);
+}
+
+unsigned int RenderCommandLog::HashData(const void * const data, const unsigned int size)
+{
+   XXH64Stream hash;
+   hash.Update(data, size);
+   return (unsigned int)hash.Digest();
+}
+
+void RenderCommandLog::EndFrame(const unsigned int triangles)
+{
+   FrameSummary frame;
+   ZeroMemory(frame.m_counts, sizeof(frame.m_counts));
+   for (size_t i = 0; i < m_commands.size(); ++i)
+      frame.m_counts[m_commands[i].m_type]++;
+   frame.m_triangles = triangles;
+
+   XXH64Stream hash;
+   if (!m_commands.empty())
+      hash.Update(&m_commands[0], m_commands.size() * sizeof(Command));
+   frame.m_hash = hash.Digest();
+   if (m_frames.size() < MAX_LOGGED_FRAMES)
+      m_frames.push_back(frame);
+   else
+      m_frames[m_numFrames % MAX_LOGGED_FRAMES] = frame;
+   m_numFrames++;
+
+   m_lastFrame.swap(m_commands);
+   m_commands.clear(); // keeps the capacity, so recording does not allocate anymore after the first frames
+}
+
+void RenderCommandLog::Dump(const char * const filename) const
+{
+   FILE *f;
+   if (fopen_s(&f, filename, "w") != 0 || !f)
+      return;
+
+   static const char * const names[CMD_COUNT] = { "Draw", "DrawIndexed", "RenderState", "SamplerState", "Texture", "Technique", "Parameter", "Lock", "RenderTarget", "Clear" };
+
+   fprintf(f, "frame");
+   for (unsigned int t = 0; t < CMD_COUNT; ++t)
+      fprintf(f, " %s", names[t]);
+   fprintf(f, " Triangles Hash\n");
+   for (unsigned int i = m_numFrames - (unsigned int)m_frames.size(); i < m_numFrames; ++i) // oldest kept frame first
+   {
+      const FrameSummary &frame = m_frames[i % MAX_LOGGED_FRAMES];
+      fprintf(f, "%u", i);
+      for (unsigned int t = 0; t < CMD_COUNT; ++t)
+         fprintf(f, " %u", frame.m_counts[t]);
+      fprintf(f, " %u %016llx\n", frame.m_triangles, frame.m_hash);
+   }
+
+   fprintf(f, "\nlast frame:\n");
+   for (size_t i = 0; i < m_lastFrame.size(); ++i)
+      fprintf(f, "%s %u %u %u\n", names[m_lastFrame[i].m_type], m_lastFrame[i].m_a, m_lastFrame[i].m_b, m_lastFrame[i].m_c);
+
+   fclose(f);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#define MAX_LOGGED_FRAMES (60*60*10) // 10 minutes at 60 fps, ~2MB
+
+// In-memory log of everything that goes through RenderDevice/Shader during a frame (draw calls, render/sampler states,
+// texture binds, shader techniques/parameters, buffer locks), to profile/regression test the CPU side of the render path.
+// Only stable values are stored (no pointers), so the per frame hash of two runs of the same table/input can be compared.
+// Enabled via Player/RecordRenderCommands, written to RenderLog.txt on exit.
+// Only the summaries of the last MAX_LOGGED_FRAMES frames are kept, so long sessions do not grow the log.
+class RenderCommandLog
+{
+public:
+   enum CommandType
+   {
+      CMD_DRAW,          // a: primitive type, b: primitive count, c: fvf
+      CMD_DRAW_INDEXED,  // dto.
+      CMD_RENDER_STATE,  // a: state, b: value
+      CMD_SAMPLER_STATE, // a: sampler, b: state, c: value
+      CMD_TEXTURE,       // a: slot, b: width, c: height (0 if unbound)
+      CMD_TECHNIQUE,     // a: hash of the name
+      CMD_PARAMETER,     // a: hash of the name, b: hash of the data
+      CMD_LOCK,          // a: 0 = vertex buffer, 1 = index buffer, b: size, c: flags
+      CMD_RENDER_TARGET, // a: width, b: height
+      CMD_CLEAR,         // a: flags, b: color
+      CMD_COUNT
+   };
+
+   struct Command
+   {
+      unsigned int m_type;
+      unsigned int m_a, m_b, m_c;
+   };
+
+   struct FrameSummary
+   {
+      unsigned int m_counts[CMD_COUNT];
+      unsigned int m_triangles;
+      unsigned long long m_hash;
+   };
+
+   RenderCommandLog() : m_enabled(false), m_numFrames(0) { }
+
+   void Record(const CommandType type, const unsigned int a, const unsigned int b = 0, const unsigned int c = 0)
+   {
+      if (m_enabled)
+      {
+         const Command cmd = { (unsigned int)type, a, b, c };
+         m_commands.push_back(cmd);
+      }
+   }
+
+   void RecordNamed(const CommandType type, const char * const name, const void * const data = NULL, const unsigned int size = 0)
+   {
+      if (m_enabled)
+         Record(type, HashName(name), data ? HashData(data, size) : 0);
+   }
+
+   void EndFrame(const unsigned int triangles); // called on Flip()
+   void Dump(const char * const filename) const;
+
+   bool m_enabled;
+
+private:
+   static unsigned int HashName(const char * const name);
+   static unsigned int HashData(const void * const data, const unsigned int size);
+
+   std::vector<Command> m_commands;      // current frame
+   std::vector<Command> m_lastFrame;     // last complete frame, dumped in full
+   std::vector<FrameSummary> m_frames;   // ring buffer, frame i is at i % MAX_LOGGED_FRAMES
+   unsigned int m_numFrames;             // frames ended so far
+};
@@ -187,14 +187,19 @@ void ReportError(const char *errorText, const HRESULT hr, const char *file, cons
 }
 
 static unsigned m_curLockCalls, m_frameLockCalls; //!! meh
+static RenderCommandLog *m_lockLog; //!! meh, dto.
 void VertexBuffer::lock(const unsigned int offsetToLock, const unsigned int sizeToLock, void **dataBuffer, const DWORD flags)
 {
     m_curLockCalls++;
+    if (m_lockLog)
+       m_lockLog->Record(RenderCommandLog::CMD_LOCK, 0, sizeToLock, flags);
     CHECKD3D(this->Lock(offsetToLock, sizeToLock, dataBuffer, flags));
 }
 void IndexBuffer::lock(const unsigned int offsetToLock, const unsigned int sizeToLock, void **dataBuffer, const DWORD flags)
 {
     m_curLockCalls++;
+    if (m_lockLog)
+       m_lockLog->Record(RenderCommandLog::CMD_LOCK, 1, sizeToLock, flags);
     CHECKD3D(this->Lock(offsetToLock, sizeToLock, dataBuffer, flags));
 }
 unsigned int RenderDevice::Perf_GetNumLockCalls() const { return m_frameLockCalls; }
@@ -235,6 +240,7 @@ void TextureManager::UnloadTexture(BaseTexture* memtex)
    const Iter it = m_map.find(memtex);
    if (it != m_map.end())
    {
+      m_rd.ForgetTexture(it->second.d3dtex);
       SAFE_RELEASE(it->second.d3dtex);
       m_map.erase(it);
    }
@@ -243,7 +249,10 @@ void TextureManager::UnloadTexture(BaseTexture* memtex)
 void TextureManager::UnloadAll()
 {
    for (Iter it = m_map.begin(); it != m_map.end(); ++it)
+   {
+      m_rd.ForgetTexture(it->second.d3dtex);
       SAFE_RELEASE(it->second.d3dtex);
+   }
 
    m_map.clear();
 }
@@ -370,6 +379,12 @@ RenderDevice::RenderDevice(const HWND hwnd, const int width, const int height, c
 
    D3DDEVTYPE devtype = D3DDEVTYPE_HAL;
 
+   // null device: full D3D9 API/runtime, but nothing is rasterized, so the CPU side of the render path can be profiled without a GPU
+   // (needs the debug runtime/reference rasterizer from the DirectX SDK to be installed)
+   m_nullDevice = !!GetRegIntWithDefault("Player", "NullDevice", 0);
+   if (m_nullDevice)
+      devtype = D3DDEVTYPE_NULLREF;
+
    // Look for 'NVIDIA PerfHUD' adapter
    // If it is present, override default settings
    // This only takes effect if run under NVPerfHud, otherwise does nothing
@@ -377,7 +392,7 @@ RenderDevice::RenderDevice(const HWND hwnd, const int width, const int height, c
    {
       D3DADAPTER_IDENTIFIER9 Identifier;
       m_pD3D->GetAdapterIdentifier(adapter, 0, &Identifier);
-      if (strstr(Identifier.Description, "PerfHUD") != 0)
+      if (!m_nullDevice && strstr(Identifier.Description, "PerfHUD") != 0)
       {
          m_adapter = adapter;
          devtype = D3DDEVTYPE_REF;
@@ -489,7 +504,7 @@ RenderDevice::RenderDevice(const HWND hwnd, const int width, const int height, c
       params.MultiSampleQuality = min(params.MultiSampleQuality, MultiSampleQualityLevels);
 
    const int softwareVP = GetRegIntWithDefault("Player", "SoftwareVertexProcessing", 0);
-   const DWORD flags = softwareVP ? D3DCREATE_SOFTWARE_VERTEXPROCESSING : D3DCREATE_HARDWARE_VERTEXPROCESSING;
+   const DWORD flags = (softwareVP || m_nullDevice) ? D3DCREATE_SOFTWARE_VERTEXPROCESSING : D3DCREATE_HARDWARE_VERTEXPROCESSING;
 
    // Create the D3D device. This optionally goes to the proper fullscreen mode.
    // It also creates the default swap chain (front and back buffer).
@@ -637,9 +652,18 @@ RenderDevice::RenderDevice(const HWND hwnd, const int width, const int height, c
    m_curTextureChanges = m_frameTextureChanges = 0;
    m_curParameterChanges = m_frameParameterChanges = 0;
    m_curTextureUpdates = m_frameTextureUpdates = 0;
+   m_curTechniqueChanges = m_frameTechniqueChanges = 0;
+   m_curRedundantStateChanges = m_frameRedundantStateChanges = 0;
+   m_curRedundantTextureChanges = m_frameRedundantTextureChanges = 0;
+   m_curRedundantParameterChanges = m_frameRedundantParameterChanges = 0;
+   m_curRedundantTechniqueChanges = m_frameRedundantTechniqueChanges = 0;
 
    m_curLockCalls = m_frameLockCalls = 0; //!! meh
 
+   m_commandLog.m_enabled = !!GetRegIntWithDefault("Player", "RecordRenderCommands", 0);
+   if (m_commandLog.m_enabled)
+      m_lockLog = &m_commandLog;
+
    bool shaderCompilationOkay = true;
 
    basicShader = new Shader(this);
@@ -808,8 +832,35 @@ void RenderDevice::FreeShader()
 #endif
 }
 
+void RenderDevice::ForgetTexture(const D3DTexture * const tex)
+{
+   if (basicShader)
+      basicShader->ForgetTexture(tex);
+   if (DMDShader)
+      DMDShader->ForgetTexture(tex);
+   if (FBShader)
+      FBShader->ForgetTexture(tex);
+   if (flasherShader)
+      flasherShader->ForgetTexture(tex);
+   if (lightShader)
+      lightShader->ForgetTexture(tex);
+#ifdef SEPARATE_CLASSICLIGHTSHADER
+   if (classicLightShader)
+      classicLightShader->ForgetTexture(tex);
+#endif
+}
+
 RenderDevice::~RenderDevice()
 {
+   if (m_commandLog.m_enabled)
+   {
+      char szLog[MAX_PATH];
+      sprintf_s(szLog, "%sRenderLog.txt", g_pvp->m_szMyPath);
+      m_commandLog.Dump(szLog);
+   }
+   if (m_lockLog == &m_commandLog)
+      m_lockLog = NULL;
+
    m_quadVertexBuffer->release();
    //m_quadDynVertexBuffer->release();
 
@@ -958,18 +1009,27 @@ void RenderDevice::Flip(const bool vsync)
    m_curDrawCalls = m_curStateChanges = m_curTextureChanges = m_curParameterChanges = 0;
    m_frameTextureUpdates = m_curTextureUpdates;
    m_curTextureUpdates = 0;
+   m_frameTechniqueChanges = m_curTechniqueChanges;
+   m_frameRedundantStateChanges = m_curRedundantStateChanges;
+   m_frameRedundantTextureChanges = m_curRedundantTextureChanges;
+   m_frameRedundantParameterChanges = m_curRedundantParameterChanges;
+   m_frameRedundantTechniqueChanges = m_curRedundantTechniqueChanges;
+   m_curTechniqueChanges = m_curRedundantStateChanges = m_curRedundantTextureChanges = m_curRedundantParameterChanges = m_curRedundantTechniqueChanges = 0;
 
    m_frameLockCalls = m_curLockCalls;
    m_curLockCalls = 0;
+
+   if (m_commandLog.m_enabled)
+      m_commandLog.EndFrame(m_stats_drawn_triangles);
 }
 
-RenderTarget* RenderDevice::DuplicateRenderTarget(RenderTarget* src)
+RenderTarget* RenderDevice::DuplicateRenderTarget(RenderTarget* src, const bool lockable)
 {
    D3DSURFACE_DESC desc;
    src->GetDesc(&desc);
    IDirect3DSurface9 *dup;
    CHECKD3D(m_pD3DDevice->CreateRenderTarget(desc.Width, desc.Height, desc.Format,
-      desc.MultiSampleType, desc.MultiSampleQuality, FALSE /* lockable */, &dup, NULL));
+      desc.MultiSampleType, desc.MultiSampleQuality, lockable, &dup, NULL));
    return dup;
 }
 
@@ -1187,13 +1247,23 @@ void RenderDevice::CopyDepth(D3DTexture* dest, void* src)
       CopyDepth(dest, (RenderTarget*)src);
 }
 
+static D3DFORMAT GetTextureFormat(const BaseTexture::Format basetexformat, const int texwidth, const int texheight, const bool compress)
+{
+   if (basetexformat == BaseTexture::RGB_FP)
+      return D3DFMT_A32B32G32R32F;
+   else if (basetexformat == BaseTexture::RGB_FP16)
+      return D3DFMT_A16B16G16R16F;
+   else
+      return (compress && ((texwidth & 3) == 0) && ((texheight & 3) == 0) && (texwidth > 256) && (texheight > 256)) ? D3DFMT_DXT5 : D3DFMT_A8R8G8B8;
+}
+
 D3DTexture* RenderDevice::CreateSystemTexture(BaseTexture* const surf, const bool linearRGB)
 {
    const int texwidth = surf->width();
    const int texheight = surf->height();
    const BaseTexture::Format basetexformat = surf->m_format;
 
-   const D3DFORMAT texformat = (m_compress_textures && ((texwidth & 3) == 0) && ((texheight & 3) == 0) && (texwidth > 256) && (texheight > 256) && (basetexformat != BaseTexture::RGB_FP)) ? D3DFMT_DXT5 : ((basetexformat == BaseTexture::RGB_FP) ? D3DFMT_A32B32G32R32F : D3DFMT_A8R8G8B8);
+   const D3DFORMAT texformat = GetTextureFormat(basetexformat, texwidth, texheight, m_compress_textures);
 
    IDirect3DTexture9 *sysTex;
    HRESULT hr;
@@ -1226,22 +1296,58 @@ D3DTexture* RenderDevice::CreateSystemTexture(BaseTexture* const surf, const boo
 
       CHECKD3D(sysTex->UnlockRect(0));
    }
+   else if (texformat == D3DFMT_A16B16G16R16F)
+   {
+      // already stored in the final layout
+      D3DLOCKED_RECT locked;
+      CHECKD3D(sysTex->LockRect(0, &locked, NULL, 0));
+
+      BYTE * const pdest = (BYTE*)locked.pBits;
+      const BYTE * const psrc = surf->data();
+      const int pitch = surf->pitch();
+      for (int y = 0; y < texheight; ++y)
+         memcpy(pdest + y*locked.Pitch, psrc + y*pitch, pitch);
+
+      CHECKD3D(sysTex->UnlockRect(0));
+   }
+   else if (texformat != D3DFMT_DXT5 && sysTex->GetLevelCount() == 1)
+   {
+      // only level 0 (the mipmaps are autogenerated), so nothing to prepare
+      D3DLOCKED_RECT locked;
+      CHECKD3D(sysTex->LockRect(0, &locked, NULL, 0));
+
+      BYTE * const pdest = (BYTE*)locked.pBits;
+      const BYTE * const psrc = surf->data();
+      const int pitch = surf->pitch();
+      for (int y = 0; y < texheight; ++y)
+         memcpy(pdest + y*locked.Pitch, psrc + y*pitch, pitch);
+
+      CHECKD3D(sysTex->UnlockRect(0));
+   }
    else
    {
-      IDirect3DSurface9* sysSurf;
-      CHECKD3D(sysTex->GetSurfaceLevel(0, &sysSurf));
-      RECT sysRect;
-      sysRect.top = 0;
-      sysRect.left = 0;
-      sysRect.right = texwidth;
-      sysRect.bottom = texheight;
-      CHECKD3D(D3DXLoadSurfaceFromMemory(sysSurf, NULL, NULL, surf->data(), D3DFMT_A8R8G8B8, surf->pitch(), NULL, &sysRect, D3DX_FILTER_NONE, 0));
-      SAFE_RELEASE_NO_RCC(sysSurf);
+      // mip chain and DXT5 compression are done by our own (multithreaded and cached) code, the data then only needs to be copied
+      const std::shared_ptr<const TextureMipChain> chain = m_mipChainCache.Get(surf, linearRGB, texformat == D3DFMT_DXT5, sysTex->GetLevelCount());
+
+      for (unsigned int l = 0; l < chain->NumLevels(); ++l)
+      {
+         D3DLOCKED_RECT locked;
+         CHECKD3D(sysTex->LockRect(l, &locked, NULL, 0));
+
+         // uncompressed level 0 comes straight from the texture
+         BYTE * const pdest = (BYTE*)locked.pBits;
+         const BYTE * const psrc = chain->LevelData(l) ? chain->LevelData(l) : surf->data();
+         const unsigned int pitch = chain->LevelPitch(l);
+         for (unsigned int y = 0; y < chain->LevelRows(l); ++y)
+            memcpy(pdest + y*locked.Pitch, psrc + y*pitch, pitch);
+
+         CHECKD3D(sysTex->UnlockRect(l));
+      }
    }
 
-   if (!(texformat != D3DFMT_DXT5 && m_autogen_mipmap))
-      // normal maps or float textures are already in linear space!
-      CHECKD3D(D3DXFilterTexture(sysTex, NULL, D3DX_DEFAULT, (texformat == D3DFMT_A32B32G32R32F || linearRGB) ? D3DX_FILTER_TRIANGLE : (D3DX_FILTER_TRIANGLE | D3DX_FILTER_SRGB)));
+   if ((texformat == D3DFMT_A32B32G32R32F || texformat == D3DFMT_A16B16G16R16F) && !m_autogen_mipmap)
+      // float textures are already in linear space!
+      CHECKD3D(D3DXFilterTexture(sysTex, NULL, D3DX_DEFAULT, D3DX_FILTER_TRIANGLE));
 
    return sysTex;
 }
@@ -1258,7 +1364,7 @@ D3DTexture* RenderDevice::UploadTexture(BaseTexture* const surf, int * const pTe
 
    IDirect3DTexture9 *sysTex = CreateSystemTexture(surf, linearRGB);
 
-   const D3DFORMAT texformat = (m_compress_textures && ((texwidth & 3) == 0) && ((texheight & 3) == 0) && (texwidth > 256) && (texheight > 256) && (basetexformat != BaseTexture::RGB_FP)) ? D3DFMT_DXT5 : ((basetexformat == BaseTexture::RGB_FP) ? D3DFMT_A32B32G32R32F : D3DFMT_A8R8G8B8);
+   const D3DFORMAT texformat = GetTextureFormat(basetexformat, texwidth, texheight, m_compress_textures);
 
    IDirect3DTexture9 *tex;
    HRESULT hr = m_pD3DDevice->CreateTexture(texwidth, texheight, (texformat != D3DFMT_DXT5 && m_autogen_mipmap) ? 0 : sysTex->GetLevelCount(), (texformat != D3DFMT_DXT5 && m_autogen_mipmap) ? D3DUSAGE_AUTOGENMIPMAP : 0, texformat, D3DPOOL_DEFAULT, &tex, NULL);
@@ -1344,9 +1450,12 @@ void RenderDevice::SetSamplerState(const DWORD Sampler, const D3DSAMPLERSTATETYP
    {
       CHECKD3D(m_pD3DDevice->SetSamplerState(Sampler, Type, Value));
       textureSamplerCache[Sampler][Type] = Value;
+      m_commandLog.Record(RenderCommandLog::CMD_SAMPLER_STATE, Sampler, Type, Value);
 
       m_curStateChanges++;
    }
+   else
+      m_curRedundantStateChanges++;
 }
 
 void RenderDevice::SetTextureFilter(const DWORD texUnit, DWORD mode)
@@ -1408,6 +1517,7 @@ void RenderDevice::SetTextureStageState(const DWORD p1, const D3DTEXTURESTAGESTA
       if (textureStateCache[p1][p2] == p3)
       {
          // texture stage state hasn't changed since last call of this function -> do nothing here
+         m_curRedundantStateChanges++;
          return;
       }
       textureStateCache[p1][p2] = p3;
@@ -1420,6 +1530,13 @@ void RenderDevice::SetTextureStageState(const DWORD p1, const D3DTEXTURESTAGESTA
 void RenderDevice::SetRenderTarget(RenderTarget* surf)
 {
    CHECKD3D(m_pD3DDevice->SetRenderTarget(0, surf));
+
+   if (m_commandLog.m_enabled)
+   {
+      D3DSURFACE_DESC desc;
+      surf->GetDesc(&desc);
+      m_commandLog.Record(RenderCommandLog::CMD_RENDER_TARGET, desc.Width, desc.Height);
+   }
 }
 
 void RenderDevice::SetZBuffer(RenderTarget* surf)
@@ -1434,6 +1551,7 @@ void RenderDevice::SetRenderState(const RenderStates p1, DWORD p2)
       if (renderStateCache[p1] == p2)
       {
          // this render state is already set -> don't do anything then
+         m_curRedundantStateChanges++;
          return;
       }
       renderStateCache[p1] = p2;
@@ -1450,6 +1568,7 @@ void RenderDevice::SetRenderState(const RenderStates p1, DWORD p2)
    CHECKD3D(m_pD3DDevice->SetRenderState((D3DRENDERSTATETYPE)p1, p2));
 
    m_curStateChanges++;
+   m_commandLog.Record(RenderCommandLog::CMD_RENDER_STATE, p1, p2);
 }
 
 void RenderDevice::SetTextureAddressMode(const DWORD texUnit, const TextureAddressMode mode)
@@ -1560,6 +1679,7 @@ void RenderDevice::DrawPrimitive(const D3DPRIMITIVETYPE type, const DWORD fvf, c
    m_curVertexBuffer = 0;      // DrawPrimitiveUP sets the VB to NULL
 
    m_curDrawCalls++;
+   m_commandLog.Record(RenderCommandLog::CMD_DRAW, type, np, fvf);
 }
 
 void RenderDevice::DrawTexturedQuad(const Vertex3D_TexelOnly* vertices)
@@ -1607,6 +1727,7 @@ void RenderDevice::DrawPrimitiveVB(const D3DPRIMITIVETYPE type, const DWORD fvf,
       ReportError("Fatal Error: DrawPrimitive failed!", hr, __FILE__, __LINE__);
 
    m_curDrawCalls++;
+   m_commandLog.Record(RenderCommandLog::CMD_DRAW, type, np, fvf);
 }
 
 void RenderDevice::DrawIndexedPrimitiveVB(const D3DPRIMITIVETYPE type, const DWORD fvf, VertexBuffer* vb, const DWORD startVertex, const DWORD vertexCount, IndexBuffer* ib, const DWORD startIndex, const DWORD indexCount)
@@ -1634,6 +1755,7 @@ void RenderDevice::DrawIndexedPrimitiveVB(const D3DPRIMITIVETYPE type, const DWO
    CHECKD3D(m_pD3DDevice->DrawIndexedPrimitive(type, startVertex, 0, vertexCount, startIndex, np));
 
    m_curDrawCalls++;
+   m_commandLog.Record(RenderCommandLog::CMD_DRAW_INDEXED, type, np, fvf);
 }
 
 void RenderDevice::SetTransform(const TransformStateType p1, const D3DMATRIX * p2)
@@ -1649,6 +1771,7 @@ void RenderDevice::GetTransform(const TransformStateType p1, D3DMATRIX* p2)
 void RenderDevice::Clear(const DWORD numRects, const D3DRECT* rects, const DWORD flags, const D3DCOLOR color, const D3DVALUE z, const DWORD stencil)
 {
    CHECKD3D(m_pD3DDevice->Clear(numRects, rects, flags, color, z, stencil));
+   m_commandLog.Record(RenderCommandLog::CMD_CLEAR, flags, color);
 }
 
 void RenderDevice::SetViewport(const ViewPort* p1)
@@ -1670,7 +1793,10 @@ Shader::Shader(RenderDevice *renderDevice)
    m_renderDevice = renderDevice;
    m_shader = 0;
    for (unsigned int i = 0; i < TEXTURESET_STATE_CACHE_SIZE; ++i)
+   {
       currentTexture[i] = 0;
+      currentD3DTexture[i] = 0;
+   }
    currentAlphaTestValue = -FLT_MAX;
    currentDisableLighting =
    currentFlasherData =
@@ -1747,6 +1873,78 @@ bool Shader::Load(const BYTE* shaderCodeName, UINT codeSize)
 void Shader::Unload()
 {
    SAFE_RELEASE(m_shader);
+
+   currentParameters.clear();
+   m_parameterSlot.clear();
+   m_parameterHandleSlot.clear();
+}
+
+// a released texture could be followed by a new one at the same address, which must then not be taken as already set
+void Shader::ForgetTexture(const D3DTexture * const tex)
+{
+   for (unsigned int i = 0; i < TEXTURESET_STATE_CACHE_SIZE; ++i)
+      if (currentD3DTexture[i] == tex)
+      {
+         currentTexture[i] = NULL;
+         currentD3DTexture[i] = NULL;
+      }
+}
+
+// returns true if the parameter is already set to this value, otherwise updates the shadow copy
+bool Shader::IsParameterRedundant(const D3DXHANDLE hParameter, const void * const pData, const unsigned int size)
+{
+   if (size > sizeof(ParameterShadow::data))
+      return false;
+
+   unsigned long long hash = 14695981039346656037ull; // FNV-1a
+   for (const char *c = hParameter; *c; ++c)
+      hash = (hash ^ (unsigned char)*c) * 1099511628211ull;
+
+   int slot;
+   const std::map<unsigned long long, ParameterName>::const_iterator it = m_parameterSlot.find(hash);
+   if (it != m_parameterSlot.end())
+   {
+      if (it->second.name != hParameter) // different name with the same hash, just don't filter it
+         return false;
+      slot = it->second.slot;
+   }
+   else
+   {
+      // first use of this name: map it to the effect parameter
+      const D3DXHANDLE handle = m_shader->GetParameterByName(NULL, hParameter);
+      if (handle == NULL)
+         slot = -1;
+      else
+      {
+         const std::map<D3DXHANDLE, int>::const_iterator ith = m_parameterHandleSlot.find(handle);
+         if (ith != m_parameterHandleSlot.end())
+            slot = ith->second;
+         else
+         {
+            slot = (int)currentParameters.size();
+            ParameterShadow p;
+            p.size = 0;
+            currentParameters.push_back(p);
+            m_parameterHandleSlot[handle] = slot;
+         }
+      }
+      ParameterName &name = m_parameterSlot[hash];
+      name.name = hParameter;
+      name.slot = slot;
+   }
+
+   if (slot < 0)
+      return false;
+
+   ParameterShadow &p = currentParameters[slot];
+   if (p.size == size && memcmp(p.data, pData, size) == 0)
+   {
+      m_renderDevice->m_curRedundantParameterChanges++;
+      return true;
+   }
+   p.size = size;
+   memcpy(p.data, pData, size);
+   return false;
 }
 
 void Shader::SetTexture(const D3DXHANDLE texelName, Texture *texel, const bool linearRGB)
@@ -1756,10 +1954,12 @@ void Shader::SetTexture(const D3DXHANDLE texelName, Texture *texel, const bool l
 
    if (!texel || !texel->m_pdsBuffer) {
       currentTexture[idx] = NULL; // invalidate the cache
+      currentD3DTexture[idx] = NULL;
 
       CHECKD3D(m_shader->SetTexture(texelName, NULL));
 
       m_renderDevice->m_curTextureChanges++;
+      m_renderDevice->m_commandLog.Record(RenderCommandLog::CMD_TEXTURE, idx);
 
       return;
    }
@@ -1767,10 +1967,14 @@ void Shader::SetTexture(const D3DXHANDLE texelName, Texture *texel, const bool l
    if (texel->m_pdsBuffer != currentTexture[idx])
    {
       currentTexture[idx] = texel->m_pdsBuffer;
-      CHECKD3D(m_shader->SetTexture(texelName, m_renderDevice->m_texMan.LoadTexture(texel->m_pdsBuffer, linearRGB)));
+      currentD3DTexture[idx] = m_renderDevice->m_texMan.LoadTexture(texel->m_pdsBuffer, linearRGB);
+      CHECKD3D(m_shader->SetTexture(texelName, currentD3DTexture[idx]));
 
       m_renderDevice->m_curTextureChanges++;
+      m_renderDevice->m_commandLog.Record(RenderCommandLog::CMD_TEXTURE, idx, texel->m_pdsBuffer->width(), texel->m_pdsBuffer->height());
    }
+   else
+      m_renderDevice->m_curRedundantTextureChanges++;
 }
 
 void Shader::SetTexture(const D3DXHANDLE texelName, D3DTexture *texel)
@@ -1780,9 +1984,23 @@ void Shader::SetTexture(const D3DXHANDLE texelName, D3DTexture *texel)
 
    currentTexture[idx] = NULL; // direct set of device tex invalidates the cache
 
+   if (texel != NULL && texel == currentD3DTexture[idx])
+   {
+      m_renderDevice->m_curRedundantTextureChanges++;
+      return;
+   }
+   currentD3DTexture[idx] = texel;
+
    CHECKD3D(m_shader->SetTexture(texelName, texel));
 
    m_renderDevice->m_curTextureChanges++;
+   if (m_renderDevice->m_commandLog.m_enabled)
+   {
+      D3DSURFACE_DESC desc = {};
+      if (texel)
+         texel->GetLevelDesc(0, &desc);
+      m_renderDevice->m_commandLog.Record(RenderCommandLog::CMD_TEXTURE, idx, desc.Width, desc.Height);
+   }
 }
 
 void Shader::SetMaterial(const Material * const mat)
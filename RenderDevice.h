@@ -5,6 +5,7 @@
 #include <d3dx9.h>
 #include "Material.h"
 #include "Texture.h"
+#include "RenderCommandLog.h"
 
 #define CHECKD3D(s) { const HRESULT hrTmp = (s); if (FAILED(hrTmp)) ReportFatalError(hrTmp, __FILE__, __LINE__); }
 
@@ -183,7 +184,7 @@ public:
    D3DTexture* GetBloomBufferTexture() const { return m_pBloomBufferTexture; }
    D3DTexture* GetBloomTmpBufferTexture() const { return m_pBloomTmpBufferTexture; }
 
-   RenderTarget* DuplicateRenderTarget(RenderTarget* src);
+   RenderTarget* DuplicateRenderTarget(RenderTarget* src, const bool lockable = false);
    D3DTexture* DuplicateTexture(RenderTarget* src);
    D3DTexture* DuplicateTextureSingleChannel(RenderTarget* src);
    D3DTexture* DuplicateDepthTexture(RenderTarget* src);
@@ -243,8 +244,15 @@ public:
    unsigned int Perf_GetNumParameterChanges() const { return m_frameParameterChanges; }
    unsigned int Perf_GetNumTextureUploads() const { return m_frameTextureUpdates; }
    unsigned int Perf_GetNumLockCalls() const;
+   unsigned int Perf_GetNumTechniqueChanges() const { return m_frameTechniqueChanges; }
+   // calls dropped as they would not change anything
+   unsigned int Perf_GetNumRedundantStateChanges() const     { return m_frameRedundantStateChanges; }
+   unsigned int Perf_GetNumRedundantTextureChanges() const   { return m_frameRedundantTextureChanges; }
+   unsigned int Perf_GetNumRedundantParameterChanges() const { return m_frameRedundantParameterChanges; }
+   unsigned int Perf_GetNumRedundantTechniqueChanges() const { return m_frameRedundantTechniqueChanges; }
 
    void FreeShader();
+   void ForgetTexture(const D3DTexture * const tex); // drops tex from the texture caches of all shaders, before it is released
 
    inline void CreateVertexDeclaration(const VertexElement * const element, VertexDeclaration ** declaration)
    {
@@ -260,6 +268,8 @@ public:
 
          m_curStateChanges++;
       }
+      else
+         m_curRedundantStateChanges++;
    }
 
    inline IDirect3DDevice9* GetCoreDevice() const
@@ -332,6 +342,14 @@ public:
    unsigned m_curTextureChanges, m_frameTextureChanges;
    unsigned m_curParameterChanges, m_frameParameterChanges;
    unsigned m_curTextureUpdates, m_frameTextureUpdates;
+   unsigned m_curTechniqueChanges, m_frameTechniqueChanges;
+   unsigned m_curRedundantStateChanges, m_frameRedundantStateChanges;
+   unsigned m_curRedundantTextureChanges, m_frameRedundantTextureChanges;
+   unsigned m_curRedundantParameterChanges, m_frameRedundantParameterChanges;
+   unsigned m_curRedundantTechniqueChanges, m_frameRedundantTechniqueChanges;
+
+   RenderCommandLog m_commandLog;
+   bool m_nullDevice; // D3DDEVTYPE_NULLREF, nothing is rasterized (Player/NullDevice)
 
    Shader *basicShader;
    Shader *DMDShader;
@@ -347,6 +365,7 @@ public:
    //Shader* m_curShader; // for caching
 
    TextureManager m_texMan;
+   TextureMipChainCache m_mipChainCache;
 
    unsigned int m_stats_drawn_triangles;
 
@@ -364,6 +383,7 @@ public:
 
    bool Load(const BYTE* shaderCodeName, UINT codeSize);
    void Unload();
+   void ForgetTexture(const D3DTexture * const tex);
 
    ID3DXEffect *Core() const
    {
@@ -470,46 +490,70 @@ public:
          strcpy_s(currentTechnique, technique);
          //m_renderDevice->m_curShader = this;
          CHECKD3D(m_shader->SetTechnique(technique));
+         m_renderDevice->m_curTechniqueChanges++;
+         m_renderDevice->m_commandLog.RecordNamed(RenderCommandLog::CMD_TECHNIQUE, technique);
       }
+      else
+         m_renderDevice->m_curRedundantTechniqueChanges++;
    }
 
    void SetMatrix(const D3DXHANDLE hParameter, const D3DXMATRIX* pMatrix)
    {
+      if (IsParameterRedundant(hParameter, pMatrix, sizeof(D3DXMATRIX)))
+         return;
       /*CHECKD3D(*/m_shader->SetMatrix(hParameter, pMatrix)/*)*/; // leads to invalid calls when setting some of the matrices (as hlsl compiler optimizes some down to less than 4x4)
       m_renderDevice->m_curParameterChanges++;
+      m_renderDevice->m_commandLog.RecordNamed(RenderCommandLog::CMD_PARAMETER, hParameter, pMatrix, sizeof(D3DXMATRIX));
    }
 
    void SetVector(const D3DXHANDLE hParameter, const D3DXVECTOR4* pVector)
    {
+      if (IsParameterRedundant(hParameter, pVector, sizeof(D3DXVECTOR4)))
+         return;
       CHECKD3D(m_shader->SetVector(hParameter, pVector));
       m_renderDevice->m_curParameterChanges++;
+      m_renderDevice->m_commandLog.RecordNamed(RenderCommandLog::CMD_PARAMETER, hParameter, pVector, sizeof(D3DXVECTOR4));
    }
 
    void SetFloat(const D3DXHANDLE hParameter, const float f)
    {
+      if (IsParameterRedundant(hParameter, &f, sizeof(float)))
+         return;
       CHECKD3D(m_shader->SetFloat(hParameter, f));
       m_renderDevice->m_curParameterChanges++;
+      m_renderDevice->m_commandLog.RecordNamed(RenderCommandLog::CMD_PARAMETER, hParameter, &f, sizeof(float));
    }
 
    void SetInt(const D3DXHANDLE hParameter, const int i)
    {
+      if (IsParameterRedundant(hParameter, &i, sizeof(int)))
+         return;
       CHECKD3D(m_shader->SetInt(hParameter, i));
       m_renderDevice->m_curParameterChanges++;
+      m_renderDevice->m_commandLog.RecordNamed(RenderCommandLog::CMD_PARAMETER, hParameter, &i, sizeof(int));
    }
 
    void SetBool(const D3DXHANDLE hParameter, const bool b)
    {
+      if (IsParameterRedundant(hParameter, &b, sizeof(bool)))
+         return;
       CHECKD3D(m_shader->SetBool(hParameter, b));
       m_renderDevice->m_curParameterChanges++;
+      m_renderDevice->m_commandLog.RecordNamed(RenderCommandLog::CMD_PARAMETER, hParameter, &b, sizeof(bool));
    }
 
    void SetValue(const D3DXHANDLE hParameter, const void* pData, const unsigned int Bytes)
    {
+      if (IsParameterRedundant(hParameter, pData, Bytes))
+         return;
       CHECKD3D(m_shader->SetValue(hParameter, pData, Bytes));
       m_renderDevice->m_curParameterChanges++;
+      m_renderDevice->m_commandLog.RecordNamed(RenderCommandLog::CMD_PARAMETER, hParameter, pData, Bytes);
    }
 
 private:
+   bool IsParameterRedundant(const D3DXHANDLE hParameter, const void * const pData, const unsigned int size);
+
    ID3DXEffect* m_shader;
    RenderDevice *m_renderDevice;
 
@@ -521,6 +565,7 @@ private:
 
    static const DWORD TEXTURESET_STATE_CACHE_SIZE = 5; // current convention: SetTexture gets "TextureX", where X 0..4
    BaseTexture *currentTexture[TEXTURESET_STATE_CACHE_SIZE];
+   D3DTexture *currentD3DTexture[TEXTURESET_STATE_CACHE_SIZE]; // what is actually bound (also for the BaseTexture path)
    float   currentAlphaTestValue;
    char    currentTechnique[64];
 
@@ -532,4 +577,20 @@ private:
    D3DXVECTOR4 currentLightData;
    unsigned int currentLightImageMode;
    unsigned int currentLightBackglassMode;
+
+   // shadow of all parameter values last set (names are mapped to the effect handle/slot first, by their content, as the same name can come from
+   // different string addresses and the same address can hold different names, e.g. a reused buffer)
+   struct ParameterShadow
+   {
+      unsigned int size; // 0 = not set yet
+      BYTE data[sizeof(D3DXMATRIX)];
+   };
+   struct ParameterName
+   {
+      std::string name;
+      int slot;          // index into currentParameters, -1 if unknown to the effect
+   };
+   std::vector<ParameterShadow> currentParameters;
+   std::map<unsigned long long, ParameterName> m_parameterSlot; // hash of the name -> slot
+   std::map<D3DXHANDLE, int> m_parameterHandleSlot;
 };
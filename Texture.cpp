@@ -2,6 +2,58 @@
 #include "Texture.h"
 #include "freeimage.h"
 
+static bool HasF16C()
+{
+   int regs[4];
+   __cpuid(regs, 1);
+   if ((regs[2] & (1 << 29)) == 0)
+      return false;
+   // F16C is VEX encoded, so the OS must also save the SSE and AVX registers (OSXSAVE and XCR0 bits 1 and 2)
+   if ((regs[2] & (1 << 27)) == 0)
+      return false;
+   return (_xgetbv(0) & 6) == 6;
+}
+
+// converts a row of RGB floats to RGBA halfs (alpha = 1)
+static void ConvertRGBFToRGBA16F(const float * const __restrict src, unsigned short * const __restrict dst, const unsigned int count, const bool f16c)
+{
+   if (count == 0)
+      return;
+
+   const __m128 rgbmask = _mm_castsi128_ps(_mm_set_epi32(0, -1, -1, -1));
+   const __m128 one = _mm_set_ps(1.f, 0.f, 0.f, 0.f);
+
+   // the unaligned 4 float load would read past the end for the last pixel, so that one is done separately
+   unsigned int i = 0;
+   if (f16c)
+   {
+      for (; i + 1 < count; ++i)
+      {
+         const __m128 rgba = _mm_or_ps(_mm_and_ps(_mm_loadu_ps(src + i * 3), rgbmask), one);
+         _mm_storel_epi64((__m128i*)(dst + i * 4), _mm_cvtps_ph(rgba, 0));
+      }
+   }
+   else
+   {
+      for (; i + 2 < count; i += 2)
+      {
+         const __m128i h0 = float2half_sse2(_mm_or_ps(_mm_and_ps(_mm_loadu_ps(src + i * 3), rgbmask), one));
+         const __m128i h1 = float2half_sse2(_mm_or_ps(_mm_and_ps(_mm_loadu_ps(src + i * 3 + 3), rgbmask), one));
+         // sign extend so that the saturating pack keeps all 16 bits
+         const __m128i packed = _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(h0, 16), 16), _mm_srai_epi32(_mm_slli_epi32(h1, 16), 16));
+         _mm_storeu_si128((__m128i*)(dst + i * 4), packed);
+      }
+   }
+
+   for (; i < count; ++i)
+   {
+      dst[i * 4    ] = float2half(src[i * 3    ]);
+      dst[i * 4 + 1] = float2half(src[i * 3 + 1]);
+      dst[i * 4 + 2] = float2half(src[i * 3 + 2]);
+      dst[i * 4 + 3] = 0x3C00; // 1.0
+   }
+}
+
 BaseTexture* BaseTexture::CreateFromFreeImage(FIBITMAP* dib)
 {
    // check if Textures exceed the maximum texture dimension
@@ -41,7 +93,7 @@ BaseTexture* BaseTexture::CreateFromFreeImage(FIBITMAP* dib)
    const bool rgbf = (img_type == FIT_FLOAT) || (img_type == FIT_DOUBLE) || (img_type == FIT_RGBF) || (img_type == FIT_RGBAF); //(FreeImage_GetBPP(dibResized) > 32);
    FIBITMAP* dib32 = rgbf ? FreeImage_ConvertToRGBF(dibResized) : FreeImage_ConvertTo32Bits(dibResized);
 
-   BaseTexture* tex = new BaseTexture(FreeImage_GetWidth(dib32), FreeImage_GetHeight(dib32), rgbf ? RGB_FP : RGBA);
+   BaseTexture* tex = new BaseTexture(FreeImage_GetWidth(dib32), FreeImage_GetHeight(dib32), rgbf ? RGB_FP16 : RGBA);
    tex->m_realWidth = pictureWidth;
    tex->m_realHeight = pictureHeight;
 
@@ -49,8 +101,19 @@ BaseTexture* BaseTexture::CreateFromFreeImage(FIBITMAP* dib)
    const int pitchdst = FreeImage_GetPitch(dib32), pitchsrc = tex->pitch();
    const int height = tex->height();
 
-   for (int y = 0; y < height; ++y)
-      memcpy(pdst + (height - y - 1)*pitchdst, psrc + y*pitchsrc, pitchsrc);
+   if (rgbf)
+   {
+      // HDR images are kept as half floats (RGBA16F), as float RGB wastes lots of memory for big environment/light maps
+      const unsigned long long start_usec = usec();
+      const bool f16c = HasF16C();
+      for (int y = 0; y < height; ++y)
+         ConvertRGBFToRGBA16F((const float*)(psrc + y*pitchdst), (unsigned short*)(pdst + (height - y - 1)*pitchsrc), tex->width(), f16c);
+      slintf("HDR texture %dx%d: %.1f MB as half float instead of %.1f MB, converted in %.3f ms%s\n", tex->width(), height,
+         (double)tex->m_data.size() / (1024.*1024.), (double)tex->width()*height * 3 * 4 / (1024.*1024.), (double)(usec() - start_usec) / 1000., f16c ? " (F16C)" : "");
+   }
+   else
+      for (int y = 0; y < height; ++y)
+         memcpy(pdst + (height - y - 1)*pitchdst, psrc + y*pitchsrc, pitchsrc);
 
    FreeImage_Unload(dib32);
    if (dibResized != dib)      // did we allocate a rescaled copy?
@@ -120,6 +183,86 @@ BaseTexture* BaseTexture::CreateFromHBitmap(const HBITMAP hbm)
 
 ////////////////////////////////////////////////////////////////////////////////
 
+// raw images are stored (BITY/BITX) with each row delta coded against the pixel to its left (bytewise, like the PNG Sub filter),
+// and then as chunked deflate, so that inflating and undoing the filter both run in parallel (the legacy BITS uses LZW)
+struct ImageRowsJob
+{
+   BYTE *image;
+   int pitch;
+   BYTE *filtered;
+   int rowBytes;
+};
+
+static void FilterImageRows(void *param, const unsigned int begin, const unsigned int end)
+{
+   const ImageRowsJob * const job = (ImageRowsJob*)param;
+   for (unsigned int y = begin; y < end; ++y)
+   {
+      const BYTE * const __restrict src = job->image + (size_t)y * job->pitch;
+      BYTE * const __restrict dst = job->filtered + (size_t)y * job->rowBytes;
+      int x = 0;
+      for (; x < 4 && x < job->rowBytes; ++x)
+         dst[x] = src[x];
+      for (; x + 16 <= job->rowBytes; x += 16)
+         _mm_storeu_si128((__m128i*)(dst + x), _mm_sub_epi8(_mm_loadu_si128((const __m128i*)(src + x)), _mm_loadu_si128((const __m128i*)(src + x - 4))));
+      for (; x < job->rowBytes; ++x)
+         dst[x] = src[x] - src[x - 4];
+   }
+}
+
+static void UnfilterImageRows(void *param, const unsigned int begin, const unsigned int end)
+{
+   const ImageRowsJob * const job = (ImageRowsJob*)param;
+   for (unsigned int y = begin; y < end; ++y)
+   {
+      const BYTE * const __restrict src = job->filtered + (size_t)y * job->rowBytes;
+      BYTE * const __restrict dst = job->image + (size_t)y * job->pitch;
+      // prefix sum over 4 pixels at once, then add the last pixel of the previous 4
+      __m128i prev = _mm_setzero_si128();
+      int x = 0;
+      for (; x + 16 <= job->rowBytes; x += 16)
+      {
+         __m128i v = _mm_loadu_si128((const __m128i*)(src + x));
+         v = _mm_add_epi8(v, _mm_slli_si128(v, 4));
+         v = _mm_add_epi8(v, _mm_slli_si128(v, 8));
+         v = _mm_add_epi8(v, prev);
+         _mm_storeu_si128((__m128i*)(dst + x), v);
+         prev = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+      }
+      for (; x < job->rowBytes; ++x)
+         dst[x] = (x < 4) ? src[x] : (BYTE)(src[x] + dst[x - 4]);
+   }
+}
+
+// legacy images may have no alpha at all
+static void FixZeroAlpha(BaseTexture * const tex, const int width, const int height)
+{
+   const int lpitch = tex->pitch();
+
+   // Assume our 32 bit color structure
+   // Find out if all alpha values are zero
+   BYTE * const pch = (BYTE *)tex->data();
+   bool allAlphaZero = true;
+   for (int i = 0; i < height; i++)
+   {
+      for (int l = 0; l < width; l++)
+      {
+         if (pch[i*lpitch + 4 * l + 3] != 0)
+         {
+            allAlphaZero = false;
+            goto endAlphaCheck;
+         }
+      }
+   }
+endAlphaCheck:
+
+   // all alpha values are 0: set them all to 0xff
+   if (allAlphaZero)
+      for (int i = 0; i < height; i++)
+         for (int l = 0; l < width; l++)
+            pch[i*lpitch + 4 * l + 3] = 0xff;
+}
+
 
 Texture::Texture()
 {
@@ -127,6 +270,7 @@ Texture::Texture()
    m_hbmGDIVersion = NULL;
    m_ppb = NULL;
    m_alphaTestValue = 1.0f;
+   m_compressedSize = 0;
    memset(m_szName, 0, MAXTOKEN);
 }
 
@@ -148,11 +292,20 @@ HRESULT Texture::SaveToStream(IStream *pstream, PinTable *pt)
 
    if (!m_ppb)
    {
-      bw.WriteTag(FID(BITS));
-
       // 32-bit picture
-      LZWWriter lzwwriter(pstream, (int *)m_pdsBuffer->data(), m_width * 4, m_height, m_pdsBuffer->pitch());
-      lzwwriter.CompressBits(8 + 1);
+      ImageRowsJob job;
+      std::vector<BYTE> filtered((size_t)m_width * 4 * m_height);
+      job.image = m_pdsBuffer->data();
+      job.pitch = m_pdsBuffer->pitch();
+      job.filtered = filtered.data();
+      job.rowBytes = m_width * 4;
+      ParallelFor(FilterImageRows, &job, m_height, GetNumCPUCores());
+
+      std::vector<unsigned char> c;
+      if (!ChunkedDeflate(filtered.data(), filtered.size(), pt->m_compressionLevel, c))
+         ShowError("Could not compress image data");
+      bw.WriteInt(FID(BITY), (int)c.size());
+      bw.WriteStruct(FID(BITX), c.data(), (int)c.size());
    }
    else // JPEG (or other binary format)
    {
@@ -232,39 +385,49 @@ BOOL Texture::LoadToken(int id, BiffReader *pbr)
       m_pdsBuffer = new BaseTexture(m_width, m_height);
 
       // 32-bit picture
-      LZWReader lzwreader(pbr->m_pistream, (int *)m_pdsBuffer->data(), m_width * 4, m_height, m_pdsBuffer->pitch());
+      LZWReader lzwreader(pbr->GetStream(), (int *)m_pdsBuffer->data(), m_width * 4, m_height, m_pdsBuffer->pitch());
       lzwreader.Decoder();
 
-      const int lpitch = m_pdsBuffer->pitch();
       SetSizeFrom(m_pdsBuffer);
+      FixZeroAlpha(m_pdsBuffer, m_width, m_height);
+   }
+   else if (id == FID(BITY))
+   {
+      pbr->GetInt(&m_compressedSize);
+   }
+   else if (id == FID(BITX))
+   {
+      if (m_pdsBuffer)
+         FreeStuff();
+
+      const unsigned long long start_usec = usec();
 
-      // Assume our 32 bit color structure
-      // Find out if all alpha values are zero
-      BYTE * const pch = (BYTE *)m_pdsBuffer->data();
-      bool allAlphaZero = true;
-      for (int i = 0; i < m_height; i++)
+      m_pdsBuffer = new BaseTexture(m_width, m_height);
+
+      std::vector<BYTE> c(m_compressedSize);
+      pbr->GetStruct(c.data(), m_compressedSize);
+      std::vector<BYTE> filtered((size_t)m_width * 4 * m_height);
+      if (!ChunkedInflate(c.data(), c.size(), filtered.data(), filtered.size()))
+         ShowError("Could not uncompress image data");
+      else
       {
-         for (int l = 0; l < m_width; l++)
-         {
-            if (pch[i*lpitch + 4 * l + 3] != 0)
-            {
-               allAlphaZero = false;
-               goto endAlphaCheck;
-            }
-         }
+         ImageRowsJob job;
+         job.image = m_pdsBuffer->data();
+         job.pitch = m_pdsBuffer->pitch();
+         job.filtered = filtered.data();
+         job.rowBytes = m_width * 4;
+         ParallelFor(UnfilterImageRows, &job, m_height, GetNumCPUCores());
       }
-   endAlphaCheck:
 
-      // all alpha values are 0: set them all to 0xff
-      if (allAlphaZero)
-         for (int i = 0; i < m_height; i++)
-            for (int l = 0; l < m_width; l++)
-               pch[i*lpitch + 4 * l + 3] = 0xff;
+      SetSizeFrom(m_pdsBuffer);
+      FixZeroAlpha(m_pdsBuffer, m_width, m_height);
+
+      slintf("Texture::LoadToken: %s %dx%d decoded in %.1f ms\n", m_szName, m_width, m_height, (double)(usec() - start_usec) / 1000.);
    }
    else if (id == FID(JPEG))
    {
       m_ppb = new PinBinary();
-      m_ppb->LoadFromStream(pbr->m_pistream, pbr->m_version);
+      m_ppb->LoadFromStream(pbr->GetStream(), pbr->m_version);
       // m_ppb->m_szPath has the original filename
       // m_ppb->m_pdata() is the buffer
       // m_ppb->m_cdata() is the filesize
@@ -381,7 +544,7 @@ void Texture::CreateTextureOffscreen(const int width, const int height)
 
 void BaseTexture::SetOpaque()
 {
-   if (m_format == BaseTexture::RGB_FP)
+   if (IsHDR())
       return;
 
    // Assume our 32 bit color structure
@@ -395,3 +558,400 @@ void BaseTexture::SetOpaque()
       pch += pitch();
    }
 }
+
+//
+// In-house mip chain and BC3/DXT5 encoder
+//
+
+static float s_srgbToLinear[256];
+static BYTE s_linearToSrgb[4096];
+
+static void InitSrgbTables()
+{
+   static bool init = false;
+   if (init)
+      return;
+
+   for (int i = 0; i < 256; ++i)
+   {
+      const float c = (float)i * (float)(1.0 / 255.0);
+      s_srgbToLinear[i] = (c <= 0.04045f) ? c * (float)(1.0 / 12.92) : powf((c + 0.055f) * (float)(1.0 / 1.055), 2.4f);
+   }
+   for (int i = 0; i < 4096; ++i)
+   {
+      const float l = (float)i * (float)(1.0 / 4095.0);
+      const float c = (l <= 0.0031308f) ? l * 12.92f : 1.055f * powf(l, (float)(1.0 / 2.4)) - 0.055f;
+      s_linearToSrgb[i] = (BYTE)(clamp(c, 0.f, 1.f) * 255.f + 0.5f);
+   }
+   init = true;
+}
+
+struct MipDownsampleJob
+{
+   const DWORD *src;
+   DWORD *dst;
+   unsigned int sw, sh, dw, dh;
+   bool linearRGB;
+};
+
+// average of n texels, color in linear space unless linearRGB (alpha is always linear)
+static __forceinline DWORD MipAverage(const DWORD * const p, const unsigned int n, const bool linearRGB)
+{
+   const __m128i zero = _mm_setzero_si128();
+
+   __m128i s = zero;
+   for (unsigned int i = 0; i < n; ++i)
+      s = _mm_add_epi16(s, _mm_unpacklo_epi8(_mm_cvtsi32_si128(p[i]), zero));
+
+   DWORD out;
+   if (n == 4)
+   {
+      s = _mm_srli_epi16(_mm_add_epi16(s, _mm_set1_epi16(2)), 2);
+      out = (DWORD)_mm_cvtsi128_si32(_mm_packus_epi16(s, s));
+   }
+   else // only the odd size borders
+   {
+      unsigned short sum[8];
+      _mm_storeu_si128((__m128i*)sum, s);
+      out = 0;
+      for (unsigned int c = 0; c < 4; ++c)
+         out |= (DWORD)((sum[c] + n / 2) / n) << (8 * c);
+   }
+
+   if (!linearRGB)
+   {
+      __m128 l = _mm_setzero_ps();
+      for (unsigned int i = 0; i < n; ++i)
+         l = _mm_add_ps(l, _mm_set_ps(0.f, s_srgbToLinear[(p[i] >> 16) & 0xFF], s_srgbToLinear[(p[i] >> 8) & 0xFF], s_srgbToLinear[p[i] & 0xFF]));
+      const __m128i idx = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(l, _mm_set1_ps(1.f / (float)n)), _mm_set1_ps(4095.f)), _mm_set1_ps(0.5f)));
+      DWORD idx4[4];
+      _mm_storeu_si128((__m128i*)idx4, idx);
+      out = (out & 0xFF000000u) | ((DWORD)s_linearToSrgb[min(idx4[2], 4095u)] << 16) | ((DWORD)s_linearToSrgb[min(idx4[1], 4095u)] << 8) | (DWORD)s_linearToSrgb[min(idx4[0], 4095u)];
+   }
+
+   return out;
+}
+
+// 2x2 box filter; for odd sizes the last row/column of the destination also takes in the last source row/column
+// (a 3 texel wide footprint), so nothing of the source is dropped
+static void MipDownsample(void *param, const unsigned int begin, const unsigned int end)
+{
+   const MipDownsampleJob * const job = (const MipDownsampleJob*)param;
+   const bool oddx = (job->sw & 1) && job->sw > 1;
+   const bool oddy = (job->sh & 1) && job->sh > 1;
+
+   for (unsigned int y = begin; y < end; ++y)
+   {
+      const DWORD *rows[3];
+      rows[0] = job->src + min(2 * y, job->sh - 1)*job->sw;
+      rows[1] = job->src + min(2 * y + 1, job->sh - 1)*job->sw;
+      const unsigned int ny = (oddy && y == job->dh - 1) ? 3 : 2;
+      rows[2] = job->src + (job->sh - 1)*job->sw;
+      DWORD * const d = job->dst + y*job->dw;
+
+      for (unsigned int x = 0; x < job->dw; ++x)
+      {
+         const unsigned int x0 = min(2 * x, job->sw - 1);
+         const unsigned int x1 = min(2 * x + 1, job->sw - 1);
+         if (ny == 2 && !(oddx && x == job->dw - 1))
+         {
+            const DWORD p[4] = { rows[0][x0], rows[0][x1], rows[1][x0], rows[1][x1] };
+            d[x] = MipAverage(p, 4, job->linearRGB);
+         }
+         else
+         {
+            const unsigned int nx = (oddx && x == job->dw - 1) ? 3 : 2;
+            const unsigned int xs[3] = { x0, x1, job->sw - 1 };
+            DWORD p[9];
+            unsigned int n = 0;
+            for (unsigned int j = 0; j < ny; ++j)
+               for (unsigned int i = 0; i < nx; ++i)
+                  p[n++] = rows[j][xs[i]];
+            d[x] = MipAverage(p, n, job->linearRGB);
+         }
+      }
+   }
+}
+
+static inline unsigned int To565(const int r, const int g, const int b)
+{
+   return ((unsigned int)(r >> 3) << 11) | ((unsigned int)(g >> 2) << 5) | (unsigned int)(b >> 3);
+}
+
+static inline void From565(const unsigned int c, int rgb[3])
+{
+   const int r = (c >> 11) & 31, g = (c >> 5) & 63, b = c & 31;
+   rgb[0] = (r << 3) | (r >> 2);
+   rgb[1] = (g << 2) | (g >> 4);
+   rgb[2] = (b << 3) | (b >> 2);
+}
+
+// encodes one 4x4 block of BGRA pixels (bbox endpoints with inset, like the common real-time DXT compressors)
+static void EncodeBC3Block(const DWORD px[16], BYTE * const out)
+{
+   // alpha: 8 value mode spanning min..max
+   int amin = 255, amax = 0;
+   int cmin[3] = { 255, 255, 255 }, cmax[3] = { 0, 0, 0 };
+   int col[16][3];
+   for (int i = 0; i < 16; ++i)
+   {
+      const int a = px[i] >> 24;
+      amin = min(amin, a);
+      amax = max(amax, a);
+      col[i][0] = (px[i] >> 16) & 0xFF; // r
+      col[i][1] = (px[i] >> 8) & 0xFF;  // g
+      col[i][2] = px[i] & 0xFF;         // b
+      for (int c = 0; c < 3; ++c)
+      {
+         cmin[c] = min(cmin[c], col[i][c]);
+         cmax[c] = max(cmax[c], col[i][c]);
+      }
+   }
+
+   out[0] = (BYTE)amax;
+   out[1] = (BYTE)amin;
+   unsigned long long aidx = 0;
+   if (amax > amin)
+   {
+      const int range = amax - amin;
+      for (int i = 0; i < 16; ++i)
+      {
+         const int k = (((int)(px[i] >> 24) - amin) * 7 + range / 2) / range; // 0 = amin .. 7 = amax
+         const unsigned long long idx = (k == 7) ? 0 : (k == 0) ? 1 : (unsigned long long)(8 - k);
+         aidx |= idx << (3 * i);
+      }
+   }
+   for (int i = 0; i < 6; ++i)
+      out[2 + i] = (BYTE)(aidx >> (8 * i));
+
+   // color: pick the bbox diagonal that matches the dominant correlation of red/blue with green
+   int cov[3] = { 0, 0, 0 };
+   int mean[3];
+   for (int c = 0; c < 3; ++c)
+      mean[c] = (cmin[c] + cmax[c]) / 2;
+   for (int i = 0; i < 16; ++i)
+   {
+      const int dg = col[i][1] - mean[1];
+      cov[0] += (col[i][0] - mean[0]) * dg;
+      cov[2] += (col[i][2] - mean[2]) * dg;
+   }
+   int c0[3], c1[3];
+   for (int c = 0; c < 3; ++c)
+   {
+      const int inset = (cmax[c] - cmin[c]) >> 4;
+      c0[c] = cmax[c] - inset;
+      c1[c] = cmin[c] + inset;
+   }
+   if (cov[0] < 0) std::swap(c0[0], c1[0]);
+   if (cov[2] < 0) std::swap(c0[2], c1[2]);
+
+   unsigned int e0 = To565(c0[0], c0[1], c0[2]);
+   unsigned int e1 = To565(c1[0], c1[1], c1[2]);
+   if (e0 < e1)
+      std::swap(e0, e1);
+
+   unsigned int cidx = 0;
+   if (e0 != e1) // otherwise 4 color mode is not possible, but all indices 0 are fine then
+   {
+      int pal[4][3];
+      From565(e0, pal[0]);
+      From565(e1, pal[1]);
+      for (int c = 0; c < 3; ++c)
+      {
+         pal[2][c] = (2 * pal[0][c] + pal[1][c]) / 3;
+         pal[3][c] = (pal[0][c] + 2 * pal[1][c]) / 3;
+      }
+      for (int i = 0; i < 16; ++i)
+      {
+         unsigned int best = 0;
+         int bestd = INT_MAX;
+         for (unsigned int p = 0; p < 4; ++p)
+         {
+            const int dr = col[i][0] - pal[p][0], dg = col[i][1] - pal[p][1], db = col[i][2] - pal[p][2];
+            const int d = dr*dr + dg*dg + db*db;
+            if (d < bestd)
+            {
+               bestd = d;
+               best = p;
+            }
+         }
+         cidx |= best << (2 * i);
+      }
+   }
+   out[8] = (BYTE)e0;
+   out[9] = (BYTE)(e0 >> 8);
+   out[10] = (BYTE)e1;
+   out[11] = (BYTE)(e1 >> 8);
+   out[12] = (BYTE)cidx;
+   out[13] = (BYTE)(cidx >> 8);
+   out[14] = (BYTE)(cidx >> 16);
+   out[15] = (BYTE)(cidx >> 24);
+}
+
+struct BC3EncodeJob
+{
+   const DWORD *src;
+   BYTE *dst;
+   unsigned int w, h;
+};
+
+static void BC3EncodeRows(void *param, const unsigned int begin, const unsigned int end)
+{
+   const BC3EncodeJob * const job = (const BC3EncodeJob*)param;
+   const unsigned int bw = (job->w + 3) / 4;
+
+   for (unsigned int by = begin; by < end; ++by)
+      for (unsigned int bx = 0; bx < bw; ++bx)
+      {
+         DWORD px[16];
+         for (unsigned int y = 0; y < 4; ++y)
+            for (unsigned int x = 0; x < 4; ++x) // small mip levels repeat their border pixels
+               px[y * 4 + x] = job->src[min(by * 4 + y, job->h - 1)*job->w + min(bx * 4 + x, job->w - 1)];
+         EncodeBC3Block(px, job->dst + (by*bw + bx) * 16);
+      }
+}
+
+// upload-ready chains are kept up to this many bytes
+#define MIP_CHAIN_CACHE_SIZE (128*1024*1024)
+
+TextureMipChainCache::TextureMipChainCache()
+{
+   InitializeCriticalSection(&m_cs);
+   m_size = 0;
+}
+
+TextureMipChainCache::~TextureMipChainCache()
+{
+   Clear();
+   DeleteCriticalSection(&m_cs);
+}
+
+void TextureMipChainCache::Clear()
+{
+   EnterCriticalSection(&m_cs);
+   m_map.clear();
+   m_lru.clear();
+   m_size = 0;
+   LeaveCriticalSection(&m_cs);
+}
+
+std::shared_ptr<const TextureMipChain> TextureMipChainCache::Get(BaseTexture * const surf, const bool linearRGB, const bool compressBC3, const unsigned int numLevels)
+{
+   const unsigned int header[5] = { (unsigned int)surf->width(), (unsigned int)surf->height(), linearRGB, compressBC3, numLevels };
+   XXH64Stream hash;
+   hash.Update(header, sizeof(header));
+   hash.Update(surf->data(), surf->m_data.size());
+   const unsigned long long key = hash.Digest();
+
+   EnterCriticalSection(&m_cs);
+   std::map<unsigned long long, Entry>::iterator it = m_map.find(key);
+   if (it != m_map.end())
+   {
+      m_lru.splice(m_lru.begin(), m_lru, it->second.lru);
+      const std::shared_ptr<const TextureMipChain> chain = it->second.chain;
+      LeaveCriticalSection(&m_cs);
+      return chain;
+   }
+   LeaveCriticalSection(&m_cs);
+
+   // created unlocked, so that other uploads are not held up by it
+   const std::shared_ptr<const TextureMipChain> chain(new TextureMipChain(surf, linearRGB, compressBC3, numLevels));
+
+   EnterCriticalSection(&m_cs);
+   if (m_map.find(key) == m_map.end()) // else someone else was quicker with the same texels
+   {
+      m_lru.push_front(key);
+      Entry &entry = m_map[key];
+      entry.chain = chain;
+      entry.lru = m_lru.begin();
+      m_size += chain->SizeInBytes();
+
+      // evict the least recently used ones, but never the one just added
+      while (m_size > MIP_CHAIN_CACHE_SIZE && m_lru.size() > 1)
+      {
+         const std::map<unsigned long long, Entry>::iterator oldest = m_map.find(m_lru.back());
+         m_size -= oldest->second.chain->SizeInBytes();
+         m_map.erase(oldest);
+         m_lru.pop_back();
+      }
+   }
+   LeaveCriticalSection(&m_cs);
+
+   return chain;
+}
+
+size_t TextureMipChain::SizeInBytes() const
+{
+   size_t size = 0;
+   for (size_t l = 0; l < m_levels.size(); ++l)
+      size += m_levels[l].size() * sizeof(DWORD);
+   return size;
+}
+
+TextureMipChain::TextureMipChain(BaseTexture * const surf, const bool linearRGB, const bool compressBC3, const unsigned int numLevels)
+{
+   const unsigned long long start_usec = usec();
+
+   InitSrgbTables();
+
+   const unsigned int num_bands = GetNumCPUCores();
+   const unsigned int levels = max(numLevels, 1u);
+
+   m_levels.resize(levels);
+   m_pitch.resize(levels);
+   m_rows.resize(levels);
+
+   // the uncompressed levels are stored directly, if compressed they are only needed until encoded
+   std::vector< std::vector<DWORD> > rgba;
+   if (compressBC3)
+      rgba.resize(levels);
+   std::vector< std::vector<DWORD> > &uncompressed = compressBC3 ? rgba : m_levels;
+
+   // level 0 is read from the texture itself
+   const DWORD *src = (const DWORD*)surf->data();
+   unsigned int w = surf->width(), h = surf->height();
+   for (unsigned int l = 0; l < levels; ++l)
+   {
+      if (l > 0)
+      {
+         MipDownsampleJob job;
+         job.src = src;
+         job.sw = w;
+         job.sh = h;
+         w = max(w / 2, 1u);
+         h = max(h / 2, 1u);
+         uncompressed[l].resize(w * h);
+         job.dst = uncompressed[l].data();
+         job.dw = w;
+         job.dh = h;
+         job.linearRGB = linearRGB;
+         ParallelFor(MipDownsample, &job, h, (w * h >= 128 * 128) ? num_bands : 1);
+         src = job.dst;
+      }
+
+      if (compressBC3)
+      {
+         const unsigned int bw = (w + 3) / 4, bh = (h + 3) / 4;
+         m_levels[l].resize(bw * bh * 4); // 16 bytes per block
+         m_pitch[l] = bw * 16;
+         m_rows[l] = bh;
+
+         BC3EncodeJob job;
+         job.src = src;
+         job.dst = (BYTE*)m_levels[l].data();
+         job.w = w;
+         job.h = h;
+         ParallelFor(BC3EncodeRows, &job, bh, (bw * bh >= 32 * 32) ? num_bands : 1);
+
+         if (l > 0)
+            std::vector<DWORD>().swap(rgba[l - 1]); // not needed for the next level anymore
+      }
+      else
+      {
+         m_pitch[l] = w * sizeof(DWORD);
+         m_rows[l] = h;
+      }
+   }
+
+   slintf("TextureMipChain: %dx%d, %u levels%s in %.3f ms\n", surf->width(), surf->height(), levels, compressBC3 ? " (BC3)" : "", (double)(usec() - start_usec) / 1000.);
+}
@@ -1,30 +1,38 @@
 #pragma once
 
+#include <map>
+#include <list>
+#include <memory>
+
 #define MIN_TEXTURE_SIZE 8
 
 struct FIBITMAP;
 
-// texture stored in main memory in 32bit ARGB uchar format or 96bit RGB float
+// texture stored in main memory in 32bit ARGB uchar format, 96bit RGB float or 64bit RGBA half float (alpha always 1)
 class BaseTexture
 {
 public:
    enum Format
    {
       RGBA,
-      RGB_FP
+      RGB_FP,
+      RGB_FP16 // stored as RGBA16F, the format used for loaded HDR images
    };
 
+   static int BytesPerPixel(const Format format) { return (format == RGBA) ? 4 : ((format == RGB_FP) ? 3*4 : 4*2); }
+
    BaseTexture()
       : m_width(0), m_height(0), m_realWidth(0), m_realHeight(0), m_format(RGBA)
    { }
 
    BaseTexture(const int w, const int h, const Format format = RGBA)
-      : m_width(w), m_height(h), m_realWidth(w), m_realHeight(h), m_format(format), m_data((format == RGBA ? 4 : 3*4) * (w*h))
+      : m_width(w), m_height(h), m_realWidth(w), m_realHeight(h), m_format(format), m_data(BytesPerPixel(format) * (w*h))
    { }
 
    int width() const   { return m_width; }
    int height() const  { return m_height; }
-   int pitch() const   { return (m_format == RGBA ? 4 : 3*4) * m_width; } // pitch in bytes
+   int pitch() const   { return BytesPerPixel(m_format) * m_width; } // pitch in bytes
+   bool IsHDR() const  { return m_format != RGBA; }
    BYTE* data()        { return m_data.data(); }
 
    int m_width;
@@ -42,15 +50,25 @@ public:
 
    void CopyTo_ConvertAlpha(BYTE* const bits) // premultiplies alpha (as Win32 AlphaBlend() wants it like that) OR converts rgb_fp format to 32bits
    {
-     if(m_format == RGB_FP) // Tonemap for 8bpc-Display
+     if(IsHDR()) // Tonemap for 8bpc-Display
      {
         unsigned int o = 0;
         for (int j = 0; j < m_height; ++j)
 			  for (int i = 0; i < m_width; ++i, ++o)
 			  {
-				  const float r = ((float*)m_data.data())[o * 3];
-				  const float g = ((float*)m_data.data())[o * 3 + 1];
-				  const float b = ((float*)m_data.data())[o * 3 + 2];
+				  float r,g,b;
+				  if (m_format == RGB_FP16)
+				  {
+					  r = half2float(((unsigned short*)m_data.data())[o * 4]);
+					  g = half2float(((unsigned short*)m_data.data())[o * 4 + 1]);
+					  b = half2float(((unsigned short*)m_data.data())[o * 4 + 2]);
+				  }
+				  else
+				  {
+					  r = ((float*)m_data.data())[o * 3];
+					  g = ((float*)m_data.data())[o * 3 + 1];
+					  b = ((float*)m_data.data())[o * 3 + 2];
+				  }
 				  const float l = r*0.176204f + g*0.812985f + b*0.0108109f;
 				  const float n = (l*0.25f + 1.0f) / (l + 1.0f); // overflow is handled by clamp
 				  bits[o * 4    ] = (BYTE)(clamp(b*n, 0.f, 1.f) * 255.f);
@@ -114,6 +132,51 @@ public:
    static BaseTexture *CreateFromFreeImage(FIBITMAP* dib);
 };
 
+// Upload-ready data of a 32bit BaseTexture: mip chain (2x2 box filter, sRGB aware) and optional BC3/DXT5 compression,
+// prepared on all cores. Each level is tightly packed in the layout D3D expects, so it can be copied as-is.
+// Level 0 of an uncompressed chain is the texture itself and not stored (LevelData(0) is then NULL).
+class TextureMipChain
+{
+public:
+   TextureMipChain(BaseTexture * const surf, const bool linearRGB, const bool compressBC3, const unsigned int numLevels);
+
+   unsigned int NumLevels() const { return (unsigned int)m_levels.size(); }
+   const BYTE* LevelData(const unsigned int level) const { return m_levels[level].empty() ? NULL : (const BYTE*)m_levels[level].data(); }
+   unsigned int LevelPitch(const unsigned int level) const { return m_pitch[level]; } // bytes per row of pixels or 4x4 blocks
+   unsigned int LevelRows(const unsigned int level) const { return m_rows[level]; }
+   size_t SizeInBytes() const;
+
+private:
+   std::vector< std::vector<DWORD> > m_levels; // BC3 blocks are 4 DWORDs each
+   std::vector<unsigned int> m_pitch;
+   std::vector<unsigned int> m_rows;
+};
+
+// Mip chains by the hash of their source texels (and settings), so that uploading the same image again (e.g. after
+// the texture manager dropped it) skips the filtering and encoding. Owned by the RenderDevice, so it is emptied when
+// the player ends. The chains are shared, a returned one stays valid after it was evicted.
+class TextureMipChainCache
+{
+public:
+   TextureMipChainCache();
+   ~TextureMipChainCache();
+
+   std::shared_ptr<const TextureMipChain> Get(BaseTexture * const surf, const bool linearRGB, const bool compressBC3, const unsigned int numLevels);
+   void Clear();
+
+private:
+   struct Entry
+   {
+      std::shared_ptr<const TextureMipChain> chain;
+      std::list<unsigned long long>::iterator lru;
+   };
+
+   CRITICAL_SECTION m_cs;  // guards all below
+   std::map<unsigned long long, Entry> m_map;
+   std::list<unsigned long long> m_lru; // keys, most recently used first
+   size_t m_size;          // bytes of all chains in m_map
+};
+
 class Texture : public ILoadable
 {
 public:
@@ -140,7 +203,7 @@ public:
        if(m_pdsBuffer == NULL)
            return false;
        else
-           return (m_pdsBuffer->m_format == BaseTexture::RGB_FP);
+           return m_pdsBuffer->IsHDR();
    }
 
    // create/release a DC which contains a (read-only) copy of the texture; for editor use
@@ -168,7 +231,7 @@ public:
    BaseTexture* m_pdsBuffer;
 
    HBITMAP m_hbmGDIVersion; // HBitmap at screen depth and converted/visualized alpha so GDI draws it fast
-   PinBinary *m_ppb;  // if this image should be saved as a binary stream, otherwise just LZW compressed from the live bitmap
+   PinBinary *m_ppb;  // if this image should be saved as a binary stream, otherwise just compressed from the live bitmap
 
    char m_szName[MAXTOKEN];
    char m_szInternalName[MAXTOKEN];
@@ -176,4 +239,5 @@ public:
 
 private:
    HBITMAP m_oldHBM;        // this is to cache the result of SelectObject()
+   int m_compressedSize;    // only used during loading
 };
@@ -914,9 +914,9 @@ void Bumper::PutCenter(const Vertex2D& pv)
    m_ptable->SetDirtyDraw();
 }
 
-HRESULT Bumper::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT Bumper::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteStruct(FID(VCEN), &m_d.m_vCenter, sizeof(Vertex2D));
    bw.WriteFloat(FID(RADI), m_d.m_radius);
@@ -944,7 +944,7 @@ HRESULT Bumper::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    bw.WriteBool(FID(COLI), m_d.m_fCollidable);
    bw.WriteBool(FID(REEN), m_d.m_fReflectionEnabled);
 
-   ISelect::SaveData(pstm, hcrypthash);
+   ISelect::SaveData(pstm, phashbuf);
 
    bw.WriteTag(FID(ENDB));
 
@@ -952,10 +952,10 @@ HRESULT Bumper::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
 }
 
 
-HRESULT Bumper::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT Bumper::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
-   BiffReader br(pstm, this, pid, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, pid, version, phashbuf, hcryptkey);
 
    m_ptable = ptable;
 
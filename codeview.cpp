@@ -1092,7 +1092,7 @@ next:
    }
 }
 
-void CodeViewer::SaveToStream(IStream *pistream, const HCRYPTHASH hcrypthash)
+void CodeViewer::SaveToStream(IStream *pistream, HashBuffer * const phashbuf)
 {
    size_t cchar = SendMessage(m_hwndScintilla, SCI_GETTEXTLENGTH, 0, 0);
    const size_t bufferSize = cchar + 32;
@@ -1103,7 +1103,8 @@ void CodeViewer::SaveToStream(IStream *pistream, const HCRYPTHASH hcrypthash)
    pistream->Write(&cchar, (ULONG)sizeof(int), &writ);
    pistream->Write(szText, (ULONG)(cchar*sizeof(char)), &writ);
 
-   CryptHashData(hcrypthash, (BYTE *)szText, (DWORD)cchar, 0);
+   if (phashbuf)
+      phashbuf->Update(szText, (DWORD)cchar);
 
    delete[] szText;
 }
@@ -1124,7 +1125,7 @@ void CodeViewer::SaveToFile(const char *filename)
 	}
 }
 
-void CodeViewer::LoadFromStream(IStream *pistream, const HCRYPTHASH hcrypthash, const HCRYPTKEY hcryptkey)
+void CodeViewer::LoadFromStream(IStream *pistream, HashBuffer * const phashbuf, const HCRYPTKEY hcryptkey)
 {
    m_fIgnoreDirty = true;
 
@@ -1136,7 +1137,8 @@ void CodeViewer::LoadFromStream(IStream *pistream, const HCRYPTHASH hcrypthash,
 
    pistream->Read(szText, cchar*(int)sizeof(char), &read);
 
-   CryptHashData(hcrypthash, (BYTE *)szText, cchar, 0);
+   if (phashbuf)
+      phashbuf->Update(szText, cchar);
 
    // if there is a valid key, then decrypt the script text (now in szText)
    //(must be done after the hash is updated)
@@ -3075,9 +3077,9 @@ ISelect *Collection::GetISelect()
    return NULL;
 }
 
-HRESULT Collection::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT Collection::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteWideString(FID(NAME), (WCHAR *)m_wzName);
 
@@ -3097,9 +3099,9 @@ HRESULT Collection::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    return S_OK;
 }
 
-HRESULT Collection::LoadData(IStream *pstm, PinTable *ppt, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT Collection::LoadData(IStream *pstm, PinTable *ppt, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
-   BiffReader br(pstm, this, ppt, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, ppt, version, phashbuf, hcryptkey);
 
    br.Load();
    return S_OK;
@@ -245,9 +245,9 @@ public:
    void ShowFindReplaceDialog();
    void Find(const FINDREPLACE * const pfr);
    void Replace(const FINDREPLACE * const pfr);
-   void SaveToStream(IStream *pistream, HCRYPTHASH const hcrypthash);
+   void SaveToStream(IStream *pistream, HashBuffer * const phashbuf);
    void SaveToFile(const char *filename);
-   void LoadFromStream(IStream *pistream, HCRYPTHASH const hcrypthash, const HCRYPTKEY hcryptkey); // incl. table protection
+   void LoadFromStream(IStream *pistream, HashBuffer * const phashbuf, const HCRYPTKEY hcryptkey); // incl. table protection
    void LoadFromFile(const char *filename);
    void SetCaption(const char * const szCaption);
 
@@ -357,8 +357,8 @@ public:
    virtual ISelect *GetISelect();
 
    //ILoadable
-   virtual HRESULT SaveData(IStream *pstm, HCRYPTHASH hcrypthash);
-   virtual HRESULT LoadData(IStream *pstm, PinTable *ppt, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey);
+   virtual HRESULT SaveData(IStream *pstm, HashBuffer *phashbuf);
+   virtual HRESULT LoadData(IStream *pstm, PinTable *ppt, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey);
    virtual BOOL LoadToken(int id, BiffReader *pbr);
 
    STDMETHOD(get_Count)(long __RPC_FAR *plCount);
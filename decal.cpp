@@ -665,9 +665,9 @@ void Decal::Rotate(const float ang, const Vertex2D& pvCenter, const bool useElem
    m_d.m_rotation += ang;
 }
 
-HRESULT Decal::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT Decal::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteStruct(FID(VCEN), &m_d.m_vCenter, sizeof(Vertex2D));
    bw.WriteFloat(FID(WDTH), m_d.m_width);
@@ -686,7 +686,7 @@ HRESULT Decal::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
 
    bw.WriteBool(FID(BGLS), m_fBackglass);
 
-   ISelect::SaveData(pstm, hcrypthash);
+   ISelect::SaveData(pstm, phashbuf);
 
    bw.WriteTag(FID(FONT));
    IPersistStream * ips;
@@ -698,11 +698,11 @@ HRESULT Decal::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    return S_OK;
 }
 
-HRESULT Decal::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT Decal::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
 
-   BiffReader br(pstm, this, pid, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, pid, version, phashbuf, hcryptkey);
 
    m_ptable = ptable;
 
@@ -791,7 +791,7 @@ BOOL Decal::LoadToken(int id, BiffReader *pbr)
       IPersistStream * ips;
       m_pIFont->QueryInterface(IID_IPersistStream, (void **)&ips);
 
-      ips->Load(pbr->m_pistream);
+      ips->Load(pbr->GetStream());
    }
    else
    {
@@ -528,9 +528,9 @@ void DispReel::PutCenter(const Vertex2D& pv)
 }
 
 
-HRESULT DispReel::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT DispReel::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteStruct(FID(VER1), &m_d.m_v1, sizeof(Vertex2D));
    bw.WriteStruct(FID(VER2), &m_d.m_v2, sizeof(Vertex2D));
@@ -554,7 +554,7 @@ HRESULT DispReel::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    bw.WriteBool(FID(VISI), m_d.m_fVisible);
    bw.WriteInt(FID(GIPR), m_d.m_imagesPerGridRow);
 
-   ISelect::SaveData(pstm, hcrypthash);
+   ISelect::SaveData(pstm, phashbuf);
 
    bw.WriteTag(FID(ENDB));
 
@@ -562,11 +562,11 @@ HRESULT DispReel::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
 }
 
 
-HRESULT DispReel::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT DispReel::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
 
-   BiffReader br(pstm, this, pid, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, pid, version, phashbuf, hcryptkey);
 
    m_ptable = ptable;
 
@@ -679,7 +679,7 @@ BOOL DispReel::LoadToken(int id, BiffReader *pbr)
       IPersistStream * ips;
       pIFont->QueryInterface(IID_IPersistStream, (void **)&ips);
 
-      ips->Load(pbr->m_pistream);
+      ips->Load(pbr->GetStream());
 
       pIFont->Release();
    }
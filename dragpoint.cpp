@@ -391,9 +391,9 @@ void IHaveDragPoints::ClearPointsForOverwrite()
    m_vdpoint.clear();
 }
 
-HRESULT IHaveDragPoints::SavePointData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT IHaveDragPoints::SavePointData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    for (size_t i = 0; i < m_vdpoint.size(); i++)
    {
@@ -406,7 +406,7 @@ HRESULT IHaveDragPoints::SavePointData(IStream *pstm, HCRYPTHASH hcrypthash)
       bw.WriteBool(FID(ATEX), pdp->m_fAutoTexture);
       bw.WriteFloat(FID(TEXC), pdp->m_texturecoord);
 
-      ((ISelect *)pdp)->SaveData(pstm, hcrypthash);
+      ((ISelect *)pdp)->SaveData(pstm, phashbuf);
 
       bw.WriteTag(FID(ENDB));
    }
@@ -426,7 +426,7 @@ void IHaveDragPoints::LoadPointToken(int id, BiffReader *pbr, int version)
          pdp->AddRef();
          pdp->Init(this, 0.f, 0.f, 0.f, false);
          m_vdpoint.push_back(pdp);
-         BiffReader br(pbr->m_pistream, pdp, NULL, version, pbr->m_hcrypthash, pbr->m_hcryptkey);
+         BiffReader br(pbr, pdp, NULL, version);
          br.Load();
       }
    }
@@ -21,8 +21,8 @@ public:
 
    virtual int GetMinimumPoints() const { return 3; }
 
-   virtual HRESULT SavePointData(IStream *pstm, HCRYPTHASH hcrypthash);
-   //virtual HRESULT InitPointLoad(IStream *pstm, HCRYPTHASH hcrypthash);
+   virtual HRESULT SavePointData(IStream *pstm, HashBuffer *phashbuf);
+   //virtual HRESULT InitPointLoad(IStream *pstm, HashBuffer *phashbuf);
    virtual void LoadPointToken(int id, BiffReader *pbr, int version);
 
    virtual void ClearPointsForOverwrite();
@@ -58,6 +58,8 @@ public:
 
    void FireVoidGroupEvent(int dispid)
    {
+      PROFILE_ZONE("FireGroupEvent");
+
       T* const pT = (T*)this;
       for (size_t i = 0; i < pT->m_vEventCollection.size(); ++i)
       {
@@ -602,9 +602,9 @@ void Flasher::DoCommand(int icmd, int x, int y)
    }
 }
 
-HRESULT Flasher::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT Flasher::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteFloat(FID(FHEI), m_d.m_height);
    bw.WriteFloat(FID(FLAX), m_d.m_vCenter.x);
@@ -628,10 +628,10 @@ HRESULT Flasher::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    bw.WriteInt(FID(ALGN), m_d.m_imagealignment);
    bw.WriteInt(FID(FILT), m_d.m_filter);
    bw.WriteInt(FID(FIAM), m_d.m_filterAmount);
-   ISelect::SaveData(pstm, hcrypthash);
+   ISelect::SaveData(pstm, phashbuf);
 
    HRESULT hr;
-   if (FAILED(hr = SavePointData(pstm, hcrypthash)))
+   if (FAILED(hr = SavePointData(pstm, phashbuf)))
       return hr;
 
    bw.WriteTag(FID(ENDB));
@@ -645,11 +645,11 @@ void Flasher::ClearForOverwrite()
 }
 
 
-HRESULT Flasher::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT Flasher::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
 
-   BiffReader br(pstm, this, pid, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, pid, version, phashbuf, hcryptkey);
 
    m_ptable = ptable;
 
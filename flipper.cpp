@@ -993,9 +993,9 @@ void Flipper::RenderStatic()
 {
 }
 
-HRESULT Flipper::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT Flipper::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteStruct(FID(VCEN), &m_d.m_Center, sizeof(Vertex2D));
    bw.WriteFloat(FID(BASR), m_d.m_BaseRadius);
@@ -1035,18 +1035,18 @@ HRESULT Flipper::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    bw.WriteBool(FID(REEN), m_d.m_fReflectionEnabled);
 
 
-   ISelect::SaveData(pstm, hcrypthash);
+   ISelect::SaveData(pstm, phashbuf);
 
    bw.WriteTag(FID(ENDB));
 
    return S_OK;
 }
 
-HRESULT Flipper::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT Flipper::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
 
-   BiffReader br(pstm, this, pid, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, pid, version, phashbuf, hcryptkey);
 
    m_ptable = ptable;
 
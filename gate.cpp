@@ -676,9 +676,9 @@ void Gate::PutCenter(const Vertex2D& pv)
    m_ptable->SetDirtyDraw();
 }
 
-HRESULT Gate::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT Gate::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteStruct(FID(VCEN), &m_d.m_vCenter, sizeof(Vertex2D));
    bw.WriteFloat(FID(LGTH), m_d.m_length);
@@ -702,18 +702,18 @@ HRESULT Gate::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    bw.WriteBool(FID(REEN), m_d.m_fReflectionEnabled);
    bw.WriteInt(FID(GATY), m_d.m_type);
 
-   ISelect::SaveData(pstm, hcrypthash);
+   ISelect::SaveData(pstm, phashbuf);
 
    bw.WriteTag(FID(ENDB));
 
    return S_OK;
 }
 
-HRESULT Gate::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT Gate::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
 
-   BiffReader br(pstm, this, pid, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, pid, version, phashbuf, hcryptkey);
 
    m_ptable = ptable;
 
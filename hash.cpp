@@ -12,3 +12,135 @@ unsigned long StringHash(const unsigned char *str)
 
    return hash;
 }
+
+// XXH64 by Yann Collet, see https://github.com/Cyan4973/xxHash
+
+static const unsigned long long XXH_PRIME64_1 = 11400714785074694791ULL;
+static const unsigned long long XXH_PRIME64_2 = 14029467366897019727ULL;
+static const unsigned long long XXH_PRIME64_3 = 1609587929392839161ULL;
+static const unsigned long long XXH_PRIME64_4 = 9650029242287828579ULL;
+static const unsigned long long XXH_PRIME64_5 = 2870177450012600261ULL;
+
+static __forceinline unsigned long long XXH64_round(unsigned long long acc, const unsigned long long input)
+{
+   acc += input * XXH_PRIME64_2;
+   acc = _rotl64(acc, 31);
+   return acc * XXH_PRIME64_1;
+}
+
+static __forceinline unsigned long long XXH64_mergeRound(unsigned long long acc, const unsigned long long val)
+{
+   acc ^= XXH64_round(0, val);
+   return acc * XXH_PRIME64_1 + XXH_PRIME64_4;
+}
+
+void XXH64Stream::Reset(const unsigned long long seed)
+{
+   m_seed = seed;
+   m_v[0] = seed + XXH_PRIME64_1 + XXH_PRIME64_2;
+   m_v[1] = seed + XXH_PRIME64_2;
+   m_v[2] = seed;
+   m_v[3] = seed - XXH_PRIME64_1;
+   m_totalLen = 0;
+   m_memSize = 0;
+}
+
+void XXH64Stream::Update(const void * const pv, const size_t count)
+{
+   const unsigned char *p = (const unsigned char *)pv;
+   const unsigned char * const pEnd = p + count;
+
+   m_totalLen += count;
+
+   if (m_memSize + count < 32)
+   {
+      memcpy(m_mem + m_memSize, p, count);
+      m_memSize += (unsigned int)count;
+      return;
+   }
+
+   if (m_memSize)
+   {
+      const unsigned int fill = 32 - m_memSize;
+      memcpy(m_mem + m_memSize, p, fill);
+      const unsigned long long * const pl = (const unsigned long long *)m_mem;
+      m_v[0] = XXH64_round(m_v[0], pl[0]);
+      m_v[1] = XXH64_round(m_v[1], pl[1]);
+      m_v[2] = XXH64_round(m_v[2], pl[2]);
+      m_v[3] = XXH64_round(m_v[3], pl[3]);
+      p += fill;
+      m_memSize = 0;
+   }
+
+   if (p + 32 <= pEnd)
+   {
+      unsigned long long v1 = m_v[0], v2 = m_v[1], v3 = m_v[2], v4 = m_v[3];
+      do
+      {
+         unsigned long long l[4];
+         memcpy(l, p, 32); // unaligned input
+         v1 = XXH64_round(v1, l[0]);
+         v2 = XXH64_round(v2, l[1]);
+         v3 = XXH64_round(v3, l[2]);
+         v4 = XXH64_round(v4, l[3]);
+         p += 32;
+      } while (p + 32 <= pEnd);
+      m_v[0] = v1; m_v[1] = v2; m_v[2] = v3; m_v[3] = v4;
+   }
+
+   if (p < pEnd)
+   {
+      memcpy(m_mem, p, pEnd - p);
+      m_memSize = (unsigned int)(pEnd - p);
+   }
+}
+
+unsigned long long XXH64Stream::Digest() const
+{
+   unsigned long long h64;
+   if (m_totalLen >= 32)
+   {
+      h64 = _rotl64(m_v[0], 1) + _rotl64(m_v[1], 7) + _rotl64(m_v[2], 12) + _rotl64(m_v[3], 18);
+      h64 = XXH64_mergeRound(h64, m_v[0]);
+      h64 = XXH64_mergeRound(h64, m_v[1]);
+      h64 = XXH64_mergeRound(h64, m_v[2]);
+      h64 = XXH64_mergeRound(h64, m_v[3]);
+   }
+   else
+      h64 = m_seed + XXH_PRIME64_5;
+
+   h64 += m_totalLen;
+
+   const unsigned char *p = m_mem;
+   const unsigned char * const pEnd = p + m_memSize;
+   while (p + 8 <= pEnd)
+   {
+      unsigned long long k1;
+      memcpy(&k1, p, 8);
+      h64 ^= XXH64_round(0, k1);
+      h64 = _rotl64(h64, 27) * XXH_PRIME64_1 + XXH_PRIME64_4;
+      p += 8;
+   }
+   if (p + 4 <= pEnd)
+   {
+      unsigned int k1;
+      memcpy(&k1, p, 4);
+      h64 ^= (unsigned long long)k1 * XXH_PRIME64_1;
+      h64 = _rotl64(h64, 23) * XXH_PRIME64_2 + XXH_PRIME64_3;
+      p += 4;
+   }
+   while (p < pEnd)
+   {
+      h64 ^= (*p) * XXH_PRIME64_5;
+      h64 = _rotl64(h64, 11) * XXH_PRIME64_1;
+      p++;
+   }
+
+   h64 ^= h64 >> 33;
+   h64 *= XXH_PRIME64_2;
+   h64 ^= h64 >> 29;
+   h64 *= XXH_PRIME64_3;
+   h64 ^= h64 >> 32;
+
+   return h64;
+}
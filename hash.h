@@ -21,3 +21,22 @@ struct StringComparator
       return lstrcmpi(str1, str2) == 0;
    }
 };
+
+// streaming XXH64, a fast non-cryptographic hash (used for the table integrity checksum)
+class XXH64Stream
+{
+public:
+   XXH64Stream(const unsigned long long seed = 0) { Reset(seed); }
+
+   void Reset(const unsigned long long seed);
+   void Update(const void * const pv, const size_t count);
+   unsigned long long Digest() const;
+
+   unsigned long long m_totalLen;
+
+private:
+   unsigned long long m_v[4];
+   unsigned long long m_seed;
+   unsigned char m_mem[32];
+   unsigned int m_memSize;
+};
@@ -419,9 +419,11 @@ void HitTarget::SetupHitObject(vector<HitObject*> &pvho, HitObject * obj, const
    }
    else
       obj->m_fe = false;
+   obj->m_group = &m_hitGroup;
 
    pvho.push_back(obj);
    m_vhoCollidable.push_back(obj);	//remember hit components of primitive
+   UpdateHitGroup(); // reads m_vhoCollidable[0], so only after the push_back
 }
 
 void HitTarget::EndPlay()
@@ -636,6 +638,7 @@ void HitTarget::UpdateAnimation(RenderDevice *pd3dDevice)
                     m_moveAnimationOffset = -limit;
                     m_moveDown = false;
                     m_d.m_isDropped = true;
+                    UpdateHitGroup();
                     m_moveAnimation = false;
                     m_timeStamp = 0;
                     if (m_d.m_fUseHitEvent)
@@ -649,6 +652,7 @@ void HitTarget::UpdateAnimation(RenderDevice *pd3dDevice)
                     m_moveAnimationOffset = 0.0f;
                     m_moveAnimation = false;
                     m_d.m_isDropped = false;
+                    UpdateHitGroup();
                     if (m_d.m_fUseHitEvent)
                         FireGroupEvent(DISPID_TargetEvents_Raised);
                 }
@@ -888,9 +892,9 @@ void HitTarget::PutCenter(const Vertex2D& pv)
 // Save and Load
 //////////////////////////////
 
-HRESULT HitTarget::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT HitTarget::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    /*
     * Someone decided that it was a good idea to write these vectors including
@@ -926,18 +930,18 @@ HRESULT HitTarget::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    bw.WriteString(FID(MAPH), m_d.m_szPhysicsMaterial);
    bw.WriteBool(FID(OVPH), m_d.m_fOverwritePhysics);
 
-   ISelect::SaveData(pstm, hcrypthash);
+   ISelect::SaveData(pstm, phashbuf);
 
    bw.WriteTag(FID(ENDB));
 
    return S_OK;
 }
 
-HRESULT HitTarget::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT HitTarget::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
 
-   BiffReader br(pstm, this, pid, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, pid, version, phashbuf, hcryptkey);
 
    m_ptable = ptable;
 
@@ -1442,6 +1446,7 @@ STDMETHODIMP HitTarget::put_Collidable(VARIANT_BOOL newVal)
        if (m_vhoCollidable.size() > 0 && m_vhoCollidable[0]->m_fEnabled != b)
            for (size_t i = 0; i < m_vhoCollidable.size(); i++) //!! costly
                m_vhoCollidable[i]->m_fEnabled = b;	//copy to hit checking on entities composing the object 
+       UpdateHitGroup();
    }
 
    return S_OK;
@@ -1677,7 +1682,10 @@ STDMETHODIMP HitTarget::put_IsDropped(VARIANT_BOOL newVal)
       }
    }
    else
+   {
       m_d.m_isDropped = val;
+      UpdateHitGroup();
+   }
 
    STOPUNDO
 
@@ -215,6 +215,9 @@ private:        // private member functions
 
    std::vector<HitObject*> m_vhoCollidable; // Objects to that may be collide selectable
 
+   HitGroup m_hitGroup; // shared enable flag/bounds of all of the above for the collision tree
+   void UpdateHitGroup() { m_hitGroup.m_fEnabled = !m_d.m_isDropped && !m_vhoCollidable.empty() && m_vhoCollidable[0]->m_fEnabled; }
+
    VertexBuffer *vertexBuffer;
    IndexBuffer *indexBuffer;
 
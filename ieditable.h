@@ -142,9 +142,9 @@ public:
 	virtual void EndPlay(); \
 	virtual void Delete() {IEditable::Delete();} \
 	virtual void Uncreate() {IEditable::Uncreate();} \
-	virtual HRESULT SaveData(IStream *pstm, HCRYPTHASH hcrypthash); \
+	virtual HRESULT SaveData(IStream *pstm, HashBuffer *phashbuf); \
 	virtual ItemTypeEnum GetItemType() const { return ItemType; } \
-	virtual HRESULT InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey); \
+	virtual HRESULT InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey); \
 	virtual HRESULT InitPostLoad(); \
 	virtual BOOL LoadToken(int id, BiffReader *pbr); \
 	virtual IDispatch *GetDispatch() {return static_cast<IDispatch *>(this);} \
@@ -206,9 +206,9 @@ public:
 
    virtual Hitable *GetIHitable();
 
-   virtual HRESULT SaveData(IStream *pstm, HCRYPTHASH hcrypthash) = 0;
+   virtual HRESULT SaveData(IStream *pstm, HashBuffer *phashbuf) = 0;
    virtual void ClearForOverwrite();
-   virtual HRESULT InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey) = 0;
+   virtual HRESULT InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey) = 0;
    virtual HRESULT InitPostLoad() = 0;
    virtual HRESULT InitVBA(BOOL fNew, int id, WCHAR *wzName) = 0;
    virtual ISelect *GetISelect() = 0;
@@ -381,9 +381,9 @@ BOOL ISelect::LoadToken(int id, BiffReader *pbr)
    return fTrue;
 }
 
-HRESULT ISelect::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT ISelect::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteBool(FID(LOCK), m_fLocked);
    bw.WriteInt(FID(LAYR), m_layerIndex);
@@ -110,7 +110,7 @@ public:
    virtual IEditable *GetIEditable() = 0;
 
    BOOL LoadToken(int id, BiffReader *pbr);
-   HRESULT SaveData(IStream *pstm, HCRYPTHASH hcrypthash);
+   HRESULT SaveData(IStream *pstm, HashBuffer *phashbuf);
 
    virtual int GetSelectLevel() { return 1; }
    virtual bool LoadMesh() { return false; }
@@ -659,3 +659,123 @@ void HitKDNode::HitTestXRay(const Ball * const pball, vector<HitObject*> &pvhoHi
          }
    }
 }
+
+BallSweepAndPrune::BallSweepAndPrune()
+{
+   m_maxWidth = 0.f;
+}
+
+void BallSweepAndPrune::AddBall(Ball * const pball)
+{
+   Entry e;
+   e.m_left = pball->m_hitBBox.left;
+   e.m_right = pball->m_hitBBox.right;
+   e.m_pball = pball;
+   m_entries.push_back(e);
+
+   Update();
+}
+
+void BallSweepAndPrune::RemoveBall(const Ball * const pball)
+{
+   for (size_t i = 0; i < m_entries.size(); ++i)
+      if (m_entries[i].m_pball == pball)
+      {
+         m_entries.erase(m_entries.begin() + i); // keeps the order
+         return;
+      }
+}
+
+void BallSweepAndPrune::Update()
+{
+   m_maxWidth = 0.f;
+   for (size_t i = 0; i < m_entries.size(); ++i)
+   {
+      Entry &e = m_entries[i];
+      e.m_left = e.m_pball->m_hitBBox.left;
+      e.m_right = e.m_pball->m_hitBBox.right;
+      m_maxWidth = max(m_maxWidth, e.m_right - e.m_left);
+   }
+
+   // insertion sort, as the balls only moved a little since the last update this is close to O(n)
+   for (size_t i = 1; i < m_entries.size(); ++i)
+   {
+      const Entry e = m_entries[i];
+      size_t j = i;
+      while (j > 0 && m_entries[j - 1].m_left > e.m_left)
+      {
+         m_entries[j] = m_entries[j - 1];
+         --j;
+      }
+      m_entries[j] = e;
+   }
+}
+
+// index of the first entry that can overlap a box starting at left
+unsigned int BallSweepAndPrune::FirstCandidate(const float left) const
+{
+   const float minLeft = left - m_maxWidth;
+   unsigned int lo = 0, hi = (unsigned int)m_entries.size();
+   while (lo < hi)
+   {
+      const unsigned int mid = (lo + hi) / 2;
+      if (m_entries[mid].m_left < minLeft)
+         lo = mid + 1;
+      else
+         hi = mid;
+   }
+   return lo;
+}
+
+void BallSweepAndPrune::HitTestBall(Ball * const pball, CollisionEvent& coll) const
+{
+   const unsigned int first = FirstCandidate(pball->m_hitBBox.left);
+   unsigned int last = first;
+   while (last < m_entries.size() && m_entries[last].m_left <= pball->m_hitBBox.right)
+      ++last;
+
+   if (first == last)
+      return;
+
+   // swap test order randomly, like the HitKD leaf test did
+   const bool traversal_order = (rand_mt_01() < 0.5f);
+   const int dt = traversal_order ? 1 : -1;
+   const int start = traversal_order ? (int)first : (int)last - 1;
+   const int end = traversal_order ? (int)last : (int)first - 1;
+
+   for (int i = start; i != end; i += dt)
+   {
+#ifdef DEBUGPHYSICS
+      g_pplayer->c_tested++;
+#endif
+      const Entry &e = m_entries[i];
+      if (e.m_pball != pball // ball can not hit itself
+         && e.m_right >= pball->m_hitBBox.left
+         && fRectIntersect3D(pball->m_pos, pball->m_rcHitRadiusSqr, e.m_pball->m_hitBBox))
+      {
+         DoHitTest(pball, e.m_pball, coll);
+      }
+   }
+}
+
+void BallSweepAndPrune::HitTestXRay(const Ball * const pball, vector<HitObject*> &pvhoHit, CollisionEvent& coll) const
+{
+   for (unsigned int i = FirstCandidate(pball->m_hitBBox.left); i < m_entries.size() && m_entries[i].m_left <= pball->m_hitBBox.right; ++i)
+   {
+#ifdef DEBUGPHYSICS
+      g_pplayer->c_tested++;
+#endif
+      Ball * const pho = m_entries[i].m_pball;
+      if ((pball != pho) && // ball cannot hit itself
+         m_entries[i].m_right >= pball->m_hitBBox.left &&
+         fRectIntersect3D(pball->m_pos, pball->m_rcHitRadiusSqr, pho->m_hitBBox))
+      {
+#ifdef DEBUGPHYSICS
+         g_pplayer->c_deepTested++;
+#endif
+         const float newtime = pho->HitTest(pball, coll.m_hittime, coll);
+         if (newtime >= 0)
+            pvhoHit.push_back(pho);
+      }
+   }
+}
@@ -94,3 +94,35 @@ private:
 
    friend class HitKDNode;
 };
+
+// Ball vs. ball broadphase: sweep and prune along x over the hit bounding boxes of all balls.
+// Cheap to keep up to date (the list stays nearly sorted between updates), so it is refreshed
+// on each collision search iteration instead of rebuilding a HitKD for the balls each cycle.
+class BallSweepAndPrune
+{
+public:
+   BallSweepAndPrune();
+
+   void AddBall(Ball * const pball);
+   void RemoveBall(const Ball * const pball);
+   void Clear() { m_entries.clear(); m_maxWidth = 0.f; }
+
+   // call when the bounding boxes of the balls have changed (CalcHitBBox)
+   void Update();
+
+   void HitTestBall(Ball * const pball, CollisionEvent& coll) const;
+   void HitTestXRay(const Ball * const pball, vector<HitObject*> &pvhoHit, CollisionEvent& coll) const;
+
+private:
+   struct Entry
+   {
+      float m_left;
+      float m_right;
+      Ball *m_pball;
+   };
+
+   unsigned int FirstCandidate(const float left) const;
+
+   std::vector<Entry> m_entries; // sorted by m_left
+   float m_maxWidth;             // widest bounding box, to bound the search to the left
+};
@@ -1033,9 +1033,9 @@ void Light::MoveOffset(const float dx, const float dy)
    m_ptable->SetDirtyDraw();
 }
 
-HRESULT Light::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT Light::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteStruct(FID(VCEN), &m_d.m_vCenter, sizeof(Vertex2D));
    bw.WriteFloat(FID(RADI), m_d.m_falloff);
@@ -1066,11 +1066,11 @@ HRESULT Light::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    bw.WriteFloat(FID(BMVA), m_d.m_modulate_vs_add);
    bw.WriteFloat(FID(BHHI), m_d.m_bulbHaloHeight);
 
-   ISelect::SaveData(pstm, hcrypthash);
+   ISelect::SaveData(pstm, phashbuf);
 
    //bw.WriteTag(FID(PNTS));
    HRESULT hr;
-   if (FAILED(hr = SavePointData(pstm, hcrypthash)))
+   if (FAILED(hr = SavePointData(pstm, phashbuf)))
       return hr;
 
    bw.WriteTag(FID(ENDB));
@@ -1078,7 +1078,7 @@ HRESULT Light::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    return S_OK;
 }
 
-HRESULT Light::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT Light::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
 
@@ -1098,7 +1098,7 @@ HRESULT Light::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version,
    //m_d.m_borderwidth = 0;
    //m_d.m_bordercolor = RGB(0,0,0);
 
-   BiffReader br(pstm, this, pid, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, pid, version, phashbuf, hcryptkey);
 
    m_ptable = ptable;
 
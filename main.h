@@ -71,6 +71,8 @@ using std::vector;
 
 #include "IDebug.h"
 
+#include "trace.h"
+
 #include "EventProxy.h"
 
 #include "worker.h"
@@ -91,6 +93,7 @@ using std::vector;
 
 #include "PinInput.h"
 #include "PinSound.h"
+#include "soundmixer.h"
 #include "PinBinary.h"
 
 #include "VPinball.h"
@@ -146,7 +149,6 @@ using std::vector;
 #include "wintimer.h"
 
 #include "slintf.h"
-#include "trace.h"
 
 #include "extern.h"
 
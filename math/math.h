@@ -291,6 +291,40 @@ inline unsigned short float2half(const float value)
    return hbits;
 }
 
+// 4 halfs (in the low 16 bits of each 32bit lane) to 4 floats with plain SSE2 (denormal halfs flush to zero if DAZ is set)
+__forceinline __m128 half2float_sse2(const __m128i h)
+{
+   const __m128i expmant = _mm_and_si128(h, _mm_set1_epi32(0x7FFF));
+   const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(expmant, 13)), _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+   const __m128 infnanexp = _mm_and_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(expmant, _mm_set1_epi32(0x7BFF))), _mm_castsi128_ps(_mm_set1_epi32(255 << 23)));
+   const __m128i sign = _mm_slli_epi32(_mm_xor_si128(h, expmant), 16);
+   return _mm_or_ps(scaled, _mm_or_ps(_mm_castsi128_ps(sign), infnanexp));
+}
+
+// 4 floats to 4 halfs (round to nearest even, incl. denormals/inf/nan) with plain SSE2, for CPUs without F16C
+__forceinline __m128i float2half_sse2(const __m128 f)
+{
+   const __m128 justsign = _mm_and_ps(_mm_castsi128_ps(_mm_set1_epi32(0x80000000)), f);
+   const __m128 absf = _mm_xor_ps(f, justsign);
+   const __m128i absf_int = _mm_castps_si128(absf);
+
+   const __m128i b_isregular = _mm_cmpgt_epi32(_mm_set1_epi32((127 + 16) << 23), absf_int); // values above round to inf
+   const __m128i inf_or_nan = _mm_or_si128(_mm_and_si128(_mm_castps_si128(_mm_cmpunord_ps(absf, absf)), _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+   // denormal result: let the FPU do the rounding
+   const __m128i subnorm_magic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+   const __m128i b_issub = _mm_cmpgt_epi32(_mm_set1_epi32((127 - 14) << 23), absf_int);
+   const __m128i subnorm = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absf, _mm_castsi128_ps(subnorm_magic))), subnorm_magic);
+
+   // normal result: rebias exponent and round mantissa to nearest even
+   const __m128i mantodd = _mm_srai_epi32(_mm_slli_epi32(absf_int, 31 - 13), 31);
+   const __m128i normal = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absf_int, _mm_set1_epi32(0xFFF - ((127 - 15) << 23))), mantodd), 13);
+
+   const __m128i nonspecial = _mm_or_si128(_mm_and_si128(subnorm, b_issub), _mm_andnot_si128(b_issub, normal));
+   const __m128i joined = _mm_or_si128(_mm_and_si128(nonspecial, b_isregular), _mm_andnot_si128(b_isregular, inf_or_nan));
+   return _mm_or_si128(joined, _mm_srli_epi32(_mm_castps_si128(justsign), 16));
+}
+
 //
 
 // input two random numbers, output two transformed random numbers
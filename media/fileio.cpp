@@ -1,4 +1,5 @@
 #include "stdafx.h"
+#include "../inc/miniz.h"
 
 bool Exists(const char* const filePath)
 {
@@ -149,16 +150,238 @@ bool RawReadFromFile(const char * const szfilename, int *psize, char **pszout)
    return true;
 }
 
-BiffWriter::BiffWriter(IStream *pistream, HCRYPTHASH hcrypthash)
+#define HASH_BUFFER_SIZE (64*1024)
+
+HashBuffer::HashBuffer(const HCRYPTHASH hcrypthash)
 {
-   m_pistream = pistream;
    m_hcrypthash = hcrypthash;
+   m_fastHash = false;
+   m_buffer = new BYTE[HASH_BUFFER_SIZE];
+   m_size = 0;
+}
+
+HashBuffer::~HashBuffer()
+{
+   // no Flush() here, the hash object may already be destroyed by now
+   delete[] m_buffer;
+}
+
+void HashBuffer::SetFastHash(const bool fastHash)
+{
+   // must be decided before the first block is flushed (everything so far is still in the buffer)
+   m_fastHash = fastHash;
+}
+
+void HashBuffer::Flush()
+{
+   if (m_size == 0)
+      return;
+
+   if (m_fastHash)
+      m_xxh.Update(m_buffer, m_size);
+   else
+      CryptHashData(m_hcrypthash, m_buffer, m_size, 0);
+
+   m_size = 0;
+}
+
+void HashBuffer::Update(const void * const pv, const DWORD count)
+{
+   if (m_size + count > HASH_BUFFER_SIZE)
+   {
+      Flush();
+
+      if (count >= HASH_BUFFER_SIZE) // big blobs (e.g. screenshot, script) go straight through
+      {
+         if (m_fastHash)
+            m_xxh.Update(pv, count);
+         else
+            CryptHashData(m_hcrypthash, (const BYTE *)pv, count, 0);
+         return;
+      }
+   }
+
+   memcpy(m_buffer + m_size, pv, count);
+   m_size += count;
+}
+
+void HashBuffer::GetHashValue(BYTE * const hashval, DWORD * const hashlen)
+{
+   Flush();
+
+   if (m_fastHash)
+   {
+      // 16 bytes, like the MD2 value: XXH64 digest followed by the amount of hashed bytes
+      const unsigned long long digest = m_xxh.Digest();
+      memcpy(hashval, &digest, sizeof(digest));
+      memcpy(hashval + sizeof(digest), &m_xxh.m_totalLen, sizeof(m_xxh.m_totalLen));
+      *hashlen = (DWORD)(sizeof(digest) + sizeof(m_xxh.m_totalLen));
+   }
+   else
+   {
+      CryptGetHashParam(m_hcrypthash, HP_HASHSIZE, hashval, hashlen, 0);
+      *hashlen = 256;
+      CryptGetHashParam(m_hcrypthash, HP_HASHVAL, hashval, hashlen, 0);
+   }
+}
+
+struct DeflateChunksJob
+{
+   const unsigned char *src;
+   size_t size;
+   int level;
+   std::vector< std::vector<unsigned char> > chunks;
+   std::vector<unsigned char> failed; // per chunk
+};
+
+static void DeflateChunks(void *param, const unsigned int begin, const unsigned int end)
+{
+   DeflateChunksJob * const job = (DeflateChunksJob*)param;
+   for (unsigned int i = begin; i < end; ++i)
+   {
+      const size_t offset = (size_t)i * CHUNKED_DEFLATE_CHUNK_SIZE;
+      const mz_ulong len = (mz_ulong)min(job->size - offset, (size_t)CHUNKED_DEFLATE_CHUNK_SIZE);
+      mz_ulong clen = compressBound(len);
+      job->chunks[i].resize(clen);
+      job->failed[i] = (compress2(job->chunks[i].data(), &clen, job->src + offset, len, job->level) != Z_OK);
+      job->chunks[i].resize(clen);
+   }
+}
+
+bool ChunkedDeflate(const void * const data, const size_t size, const int level, std::vector<unsigned char> &out)
+{
+   const unsigned int numChunks = (unsigned int)((size + CHUNKED_DEFLATE_CHUNK_SIZE - 1) / CHUNKED_DEFLATE_CHUNK_SIZE);
+
+   DeflateChunksJob job;
+   job.src = (const unsigned char*)data;
+   job.size = size;
+   job.level = level;
+   job.chunks.resize(numChunks);
+   job.failed.resize(numChunks, 0);
+   ParallelFor(DeflateChunks, &job, numChunks, GetNumCPUCores());
+
+   const unsigned int header[3] = { (unsigned int)size, CHUNKED_DEFLATE_CHUNK_SIZE, numChunks };
+   size_t total = sizeof(header) + numChunks * sizeof(unsigned int);
+   for (unsigned int i = 0; i < numChunks; ++i)
+      total += job.chunks[i].size();
+   out.resize(total);
+
+   unsigned char *p = out.data();
+   memcpy(p, header, sizeof(header));
+   p += sizeof(header);
+   for (unsigned int i = 0; i < numChunks; ++i, p += sizeof(unsigned int))
+   {
+      const unsigned int clen = (unsigned int)job.chunks[i].size();
+      memcpy(p, &clen, sizeof(unsigned int));
+   }
+   bool ok = true;
+   for (unsigned int i = 0; i < numChunks; ++i)
+   {
+      if (!job.chunks[i].empty())
+         memcpy(p, job.chunks[i].data(), job.chunks[i].size());
+      p += job.chunks[i].size();
+      ok &= !job.failed[i];
+   }
+   return ok;
+}
+
+struct InflateChunksJob
+{
+   const unsigned char *src;
+   std::vector<size_t> offsets; // of each compressed chunk in src, plus the end
+   unsigned char *dest;
+   size_t size;
+   size_t chunkSize;
+   std::vector<unsigned char> failed; // per chunk
+};
+
+static void InflateChunks(void *param, const unsigned int begin, const unsigned int end)
+{
+   InflateChunksJob * const job = (InflateChunksJob*)param;
+   for (unsigned int i = begin; i < end; ++i)
+   {
+      const size_t offset = (size_t)i * job->chunkSize;
+      const mz_ulong len = (mz_ulong)min(job->size - offset, job->chunkSize);
+      mz_ulong uclen = len;
+      job->failed[i] = (uncompress(job->dest + offset, &uclen, job->src + job->offsets[i], (mz_ulong)(job->offsets[i + 1] - job->offsets[i])) != Z_OK || uclen != len);
+   }
+}
+
+bool ChunkedInflate(const void * const data, const size_t size, void * const out, const size_t outSize)
+{
+   unsigned int header[3];
+   if (size < sizeof(header))
+      return false;
+   memcpy(header, data, sizeof(header));
+   const unsigned int numChunks = header[2];
+   if (header[0] != outSize || header[1] == 0 || numChunks != (outSize + header[1] - 1) / header[1]
+      || (size - sizeof(header)) / sizeof(unsigned int) < numChunks)
+      return false;
+
+   InflateChunksJob job;
+   job.src = (const unsigned char*)data;
+   job.dest = (unsigned char*)out;
+   job.size = outSize;
+   job.chunkSize = header[1];
+   job.failed.resize(numChunks, 0);
+   job.offsets.resize(numChunks + 1);
+   job.offsets[0] = sizeof(header) + numChunks * sizeof(unsigned int);
+   for (unsigned int i = 0; i < numChunks; ++i)
+   {
+      unsigned int clen;
+      memcpy(&clen, job.src + sizeof(header) + i * sizeof(unsigned int), sizeof(unsigned int));
+      job.offsets[i + 1] = job.offsets[i] + clen;
+      if (job.offsets[i + 1] > size)
+         return false;
+   }
+
+   ParallelFor(InflateChunks, &job, numChunks, GetNumCPUCores());
+
+   for (unsigned int i = 0; i < numChunks; ++i)
+      if (job.failed[i])
+         return false;
+   return true;
+}
+
+bool ChunkedInflateChunk(const void * const data, const size_t size, const unsigned int chunk, void * const out, size_t &outSize)
+{
+   unsigned int header[3];
+   if (size < sizeof(header))
+      return false;
+   memcpy(header, data, sizeof(header));
+   const unsigned int numChunks = header[2];
+   if (header[1] == 0 || chunk >= numChunks || numChunks != (header[0] + header[1] - 1) / header[1]
+      || (size - sizeof(header)) / sizeof(unsigned int) < numChunks)
+      return false;
+
+   const unsigned char * const src = (const unsigned char*)data;
+   size_t offset = sizeof(header) + numChunks * sizeof(unsigned int);
+   unsigned int clen;
+   for (unsigned int i = 0; i <= chunk; ++i)
+   {
+      memcpy(&clen, src + sizeof(header) + i * sizeof(unsigned int), sizeof(unsigned int));
+      if (i < chunk)
+         offset += clen;
+   }
+   if (offset + clen > size)
+      return false;
+
+   const mz_ulong len = (mz_ulong)min((size_t)header[0] - (size_t)chunk * header[1], (size_t)header[1]);
+   mz_ulong uclen = len;
+   outSize = len;
+   return uncompress((unsigned char*)out, &uclen, src + offset, clen) == Z_OK && uclen == len;
+}
+
+BiffWriter::BiffWriter(IStream *pistream, HashBuffer *phashbuf)
+{
+   m_pistream = pistream;
+   m_phashbuf = phashbuf;
 }
 
 HRESULT BiffWriter::WriteBytes(const void *pv, unsigned long count, unsigned long *foo)
 {
-   if (m_hcrypthash)
-      CryptHashData(m_hcrypthash, (BYTE *)pv, count, 0);
+   if (m_phashbuf)
+      m_phashbuf->Update(pv, count);
 
    return m_pistream->Write(pv, count, foo);
 }
@@ -303,7 +526,7 @@ HRESULT BiffWriter::WriteTag(int id)
    return hr;
 }
 
-BiffReader::BiffReader(IStream *pistream, ILoadable *piloadable, void *ppassdata, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+BiffReader::BiffReader(IStream *pistream, ILoadable *piloadable, void *ppassdata, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    m_pistream = pistream;
    m_piloadable = piloadable;
@@ -312,18 +535,107 @@ BiffReader::BiffReader(IStream *pistream, ILoadable *piloadable, void *ppassdata
 
    m_bytesinrecordremaining = 0;
 
-   m_hcrypthash = hcrypthash;
+   m_phashbuf = phashbuf;
    m_hcryptkey = hcryptkey;
+
+   m_source = this;
+   m_buffer = new BYTE[BIFF_READ_BUFFER_SIZE];
+   m_bufferPos = 0;
+   m_bufferEnd = 0;
 }
 
-HRESULT BiffReader::ReadBytes(void *pv, unsigned long count, unsigned long *foo)
+BiffReader::BiffReader(BiffReader * const parent, ILoadable *piloadable, void *ppassdata, int version)
+{
+   m_pistream = parent->m_source->m_pistream;
+   m_piloadable = piloadable;
+   m_pdata = ppassdata;
+   m_version = version;
+
+   m_bytesinrecordremaining = 0;
+
+   m_phashbuf = parent->m_phashbuf;
+   m_hcryptkey = parent->m_hcryptkey;
+
+   m_source = parent->m_source;
+   m_buffer = NULL;
+   m_bufferPos = 0;
+   m_bufferEnd = 0;
+}
+
+BiffReader::~BiffReader()
 {
-   HRESULT hr = m_pistream->Read(pv, count, foo);
+   if (m_source == this)
+   {
+      GetStream(); // give back the bytes that were read ahead, in case the caller continues on the stream
+      delete[] m_buffer;
+   }
+}
 
-   if (m_hcrypthash)
+IStream *BiffReader::GetStream()
+{
+   BiffReader * const src = m_source;
+   if (src->m_bufferPos != src->m_bufferEnd)
    {
-      CryptHashData(m_hcrypthash, (BYTE *)pv, count, 0);
+      LARGE_INTEGER li;
+      li.QuadPart = -(LONGLONG)(src->m_bufferEnd - src->m_bufferPos);
+      src->m_pistream->Seek(li, STREAM_SEEK_CUR, NULL);
    }
+   src->m_bufferPos = 0;
+   src->m_bufferEnd = 0;
+   return src->m_pistream;
+}
+
+HRESULT BiffReader::ReadBuffered(void *pv, const ULONG count, ULONG *read)
+{
+   if (count <= m_bufferEnd - m_bufferPos) // common case: token is already in the buffer
+   {
+      memcpy(pv, m_buffer + m_bufferPos, count);
+      m_bufferPos += count;
+      if (read)
+         *read = count;
+      return S_OK;
+   }
+
+   BYTE *dst = (BYTE*)pv;
+   ULONG done = 0;
+   HRESULT hr = S_OK;
+   while (done < count)
+   {
+      if (m_bufferPos == m_bufferEnd)
+      {
+         const ULONG left = count - done;
+         ULONG r = 0;
+         if (left >= BIFF_READ_BUFFER_SIZE / 2) // big blobs go straight to the destination
+         {
+            hr = m_pistream->Read(dst + done, left, &r);
+            done += r;
+            break;
+         }
+         m_bufferPos = 0;
+         m_bufferEnd = 0;
+         hr = m_pistream->Read(m_buffer, BIFF_READ_BUFFER_SIZE, &r);
+         m_bufferEnd = r;
+         if (r == 0)
+            break;
+      }
+      const ULONG n = min(count - done, m_bufferEnd - m_bufferPos);
+      memcpy(dst + done, m_buffer + m_bufferPos, n);
+      m_bufferPos += n;
+      done += n;
+   }
+
+   if (read)
+      *read = done;
+
+   return FAILED(hr) ? hr : ((done == count) ? S_OK : S_FALSE);
+}
+
+HRESULT BiffReader::ReadBytes(void *pv, unsigned long count, unsigned long *foo)
+{
+   const HRESULT hr = m_source->ReadBuffered(pv, count, foo);
+
+   if (m_phashbuf)
+      m_phashbuf->Update(pv, count);
 
    return hr;
 }
@@ -333,7 +645,7 @@ HRESULT BiffReader::GetIntNoHash(void *pvalue)
    m_bytesinrecordremaining -= sizeof(int);
 
    ULONG read = 0;
-   return m_pistream->Read(pvalue, sizeof(int), &read);
+   return m_source->ReadBuffered(pvalue, sizeof(int), &read);
 }
 
 HRESULT BiffReader::GetInt(void *pvalue)
@@ -449,6 +761,8 @@ HRESULT BiffReader::Load()
 
       if (!fContinue)
       {
+         if (m_source == this)
+            GetStream();
          return E_FAIL;
       }
 
@@ -463,6 +777,9 @@ HRESULT BiffReader::Load()
       }
    }
 
+   if (m_source == this)
+      GetStream();
+
    return S_OK;
 }
 
@@ -694,6 +1011,7 @@ unsigned long __stdcall FastIStream::Release()
 
 long __stdcall FastIStream::Read(void *pv, unsigned long count, unsigned long *foo)
 {
+   count = (m_cSeek < m_cSize) ? min(count, (unsigned long)(m_cSize - m_cSeek)) : 0; // BiffReader reads ahead, so stop at the end of the data
    memcpy(pv, m_rg + m_cSeek, count);
    m_cSeek += count;
 
@@ -1,4 +1,6 @@
 #pragma once
+#include "hash.h"
+
 #define FID(A) *(int *)#A
 
 bool Exists(const char* const filePath);
@@ -16,10 +18,44 @@ public:
    virtual BOOL LoadToken(int id, BiffReader *pbr) = 0;
 };
 
+// Collects all bytes that go into the table integrity hash (stored in the "MAC" stream)
+// and feeds them to the hash in large blocks, instead of one CryptHashData() per token.
+// The table save/load owns it and passes it down to all BiffWriter/BiffReader instances (NULL = not hashed),
+// the byte order (and thus the legacy MD2 value) is unchanged.
+// With fastHash set (FAST_HASH_FORMAT_VERSION and newer) XXH64 is used instead of MD2.
+class HashBuffer
+{
+public:
+   HashBuffer(const HCRYPTHASH hcrypthash);
+   ~HashBuffer();
+
+   void SetFastHash(const bool fastHash);
+   void Update(const void * const pv, const DWORD count);
+   void Flush();
+   void GetHashValue(BYTE * const hashval, DWORD * const hashlen); // hashval must hold at least 16 bytes
+
+private:
+   HCRYPTHASH m_hcrypthash;
+   bool m_fastHash;
+   XXH64Stream m_xxh;
+
+   BYTE *m_buffer;
+   DWORD m_size;
+};
+
+// deflates data in independent chunks of CHUNKED_DEFLATE_CHUNK_SIZE, which are (de)compressed in parallel
+// layout: raw size, chunk size, chunk count, compressed size of each chunk, then the zlib streams of all chunks
+#define CHUNKED_DEFLATE_CHUNK_SIZE (256*1024)
+bool ChunkedDeflate(const void * const data, const size_t size, const int level, std::vector<unsigned char> &out);
+// outSize must match the raw size stored in data
+bool ChunkedInflate(const void * const data, const size_t size, void * const out, const size_t outSize);
+// decodes only the given chunk (for streaming), out must hold the chunk size, outSize returns its raw size
+bool ChunkedInflateChunk(const void * const data, const size_t size, const unsigned int chunk, void * const out, size_t &outSize);
+
 class BiffWriter
 {
 public:
-   BiffWriter(IStream *pistream, HCRYPTHASH hcrypthash);
+   BiffWriter(IStream *pistream, HashBuffer *phashbuf);
    HRESULT WriteInt(int id, int value);
    HRESULT WriteString(int id, char *szvalue);
    HRESULT WriteWideString(int id, WCHAR *wzvalue);
@@ -35,13 +71,19 @@ public:
    HRESULT WriteRecordSize(int size);
 
    IStream *m_pistream;
-   HCRYPTHASH m_hcrypthash;
+   HashBuffer *m_phashbuf;
 };
 
+// size of the read-ahead buffer of BiffReader, so that tokens are decoded from memory instead of one IStream::Read each
+#define BIFF_READ_BUFFER_SIZE (64*1024)
+
 class BiffReader
 {
 public:
-   BiffReader(IStream *pistream, ILoadable *piloadable, void *ppassdata, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey);
+   BiffReader(IStream *pistream, ILoadable *piloadable, void *ppassdata, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey);
+   // nested reader (e.g. drag points inside an element), shares the stream and read-ahead buffer of parent
+   BiffReader(BiffReader * const parent, ILoadable *piloadable, void *ppassdata, int version);
+   ~BiffReader();
 
    HRESULT GetIntNoHash(void *pvalue);
    HRESULT GetInt(void *pvalue);
@@ -58,15 +100,27 @@ public:
 
    HRESULT Load();
 
-   IStream *m_pistream;
+   // returns the underlying stream positioned at the current token, for loaders that read from it directly (LZW, PinBinary, script)
+   IStream *GetStream();
+
    ILoadable *m_piloadable;
    void *m_pdata;
    int m_version;
 
    int m_bytesinrecordremaining;
 
-   HCRYPTHASH m_hcrypthash;
+   HashBuffer *m_phashbuf;
    HCRYPTKEY m_hcryptkey;
+
+private:
+   HRESULT ReadBuffered(void *pv, const ULONG count, ULONG *read);
+
+   IStream *m_pistream;
+   BiffReader *m_source; // owner of the stream and buffer (this, or the top level reader)
+
+   BYTE *m_buffer;
+   ULONG m_bufferPos;
+   ULONG m_bufferEnd;
 };
 
 class FastIStream;
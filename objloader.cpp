@@ -7,32 +7,20 @@ struct MyPoly
    int vi2, ti2, ni2;
 };
 
-static vector<Vertex3Ds> tmpVerts;
-static vector<Vertex3Ds> tmpNorms;
-static vector<Vertex2D> tmpTexel;
-static vector<MyPoly> tmpFaces;
-static vector<Vertex3D_NoTex2> verts;
-static vector<int> faces;
-static unsigned int faceIndexOffset = 0;
-static FILE *matFile = NULL;
-
-static int isInList(const int vi, const int ti, const int ni)
+// raw content of one obj file, kept per load (and not file-static) so that several files can be loaded concurrently
+struct ObjData
 {
-   for (unsigned int i = 0; i < verts.size(); i++)
-      if (verts[i].x == tmpVerts[vi].x && verts[i].y == tmpVerts[vi].y && verts[i].z == tmpVerts[vi].z
-         &&
-         verts[i].tu == tmpTexel[ti].x && verts[i].tv == tmpTexel[ti].y
-         &&
-         verts[i].nx == tmpNorms[ni].x && verts[i].ny == tmpNorms[ni].y && verts[i].nz == tmpNorms[ni].z)
-      {
-         return i;
-      }
+   vector<Vertex3Ds> verts;
+   vector<Vertex3Ds> norms;
+   vector<Vertex2D> texel;
+   vector<MyPoly> faces;
+};
 
-   return -1;
-}
+static unsigned int faceIndexOffset = 0;
+static FILE *matFile = NULL;
 
 #if 0
-static void NormalizeNormals()
+static void NormalizeNormals(vector<Vertex3D_NoTex2> &verts, const vector<unsigned int> &faces)
 {
    for (unsigned int i = 0; i < faces.size(); i += 3)
    {
@@ -160,99 +148,330 @@ bool WaveFrontObjLoadMaterial(const char *filename, Material *mat)
    return true;
 }
 
-bool WaveFrontObj_Load(const char *filename, const bool flipTv, const bool convertToLeftHanded)
+// welds identical face corners into one vertex: first via the (v,t,n) index triple, then via the exact attribute values
+// (same result as comparing against all previous vertices, but O(1) per corner)
+class VertexWelder
 {
-   FILE *f;
-   fopen_s(&f, filename, "r");
-   if (!f)
+public:
+   VertexWelder(const ObjData &obj, vector<Vertex3D_NoTex2> &verts) : m_obj(obj), m_verts(verts), m_numAttribs(0)
+   {
+      const size_t numPositions = obj.verts.size();
+      m_firstCorner.resize(numPositions, -1);
+      size_t size = 1024;
+      while (size < numPositions * 2)
+         size *= 2;
+      m_attribs.resize(size, -1);
+      m_corners.reserve(numPositions);
+      m_verts.reserve(numPositions);
+   }
+
+   int FindOrAdd(const int vi, const int ti, const int ni)
+   {
+      // same index triple as before? (short list of the corners seen per position, follows the face order so mostly cache hits)
+      for (int c = m_firstCorner[vi]; c >= 0; c = m_corners[c].next)
+         if (m_corners[c].ti == ti && m_corners[c].ni == ni)
+            return m_corners[c].idx;
+
+      Vertex3D_NoTex2 tmp;
+      tmp.x = m_obj.verts[vi].x;
+      tmp.y = m_obj.verts[vi].y;
+      tmp.z = m_obj.verts[vi].z;
+      tmp.tu = m_obj.texel[ti].x;
+      tmp.tv = m_obj.texel[ti].y;
+      tmp.nx = m_obj.norms[ni].x;
+      tmp.ny = m_obj.norms[ni].y;
+      tmp.nz = m_obj.norms[ni].z;
+
+      // different indices, but same values (duplicated v/vt/vn entries in the file)?
+      int idx = -1;
+      const unsigned int mask = (unsigned int)m_attribs.size() - 1;
+      unsigned int h = HashAttribs(tmp) & mask;
+      while (m_attribs[h] >= 0)
+      {
+         if (SameAttribs(m_verts[m_attribs[h]], tmp))
+         {
+            idx = m_attribs[h];
+            break;
+         }
+         h = (h + 1) & mask;
+      }
+      if (idx < 0)
+      {
+         idx = (int)m_verts.size();
+         m_verts.push_back(tmp);
+         m_attribs[h] = idx;
+         if (++m_numAttribs * 2 > m_attribs.size())
+            RehashAttribs();
+      }
+
+      const Corner c = { ti, ni, idx, m_firstCorner[vi] };
+      m_firstCorner[vi] = (int)m_corners.size();
+      m_corners.push_back(c);
+
+      return idx;
+   }
+
+private:
+   struct Corner { int ti, ni, idx, next; };
+
+   static unsigned int Mix(unsigned int h)
+   {
+      h ^= h >> 16; h *= 0x85ebca6bu;
+      h ^= h >> 13; h *= 0xc2b2ae35u;
+      h ^= h >> 16;
+      return h;
+   }
+   // +0.0f, so that -0 and +0 (which compare equal) hash the same
+   static unsigned int FloatBits(const float f) { const float g = f + 0.0f; return *(const unsigned int*)&g; }
+   static unsigned int HashAttribs(const Vertex3D_NoTex2 &v)
+   {
+      unsigned int h = FloatBits(v.x);
+      h = Mix(h) ^ FloatBits(v.y);
+      h = Mix(h) ^ FloatBits(v.z);
+      h = Mix(h) ^ FloatBits(v.tu);
+      h = Mix(h) ^ FloatBits(v.tv);
+      h = Mix(h) ^ FloatBits(v.nx);
+      h = Mix(h) ^ FloatBits(v.ny);
+      h = Mix(h) ^ FloatBits(v.nz);
+      return Mix(h);
+   }
+   static bool SameAttribs(const Vertex3D_NoTex2 &a, const Vertex3D_NoTex2 &b)
+   {
+      return a.x == b.x && a.y == b.y && a.z == b.z && a.tu == b.tu && a.tv == b.tv && a.nx == b.nx && a.ny == b.ny && a.nz == b.nz;
+   }
+
+   void RehashAttribs()
+   {
+      m_attribs.assign(m_attribs.size() * 2, -1);
+      const unsigned int mask = (unsigned int)m_attribs.size() - 1;
+      for (size_t i = 0; i < m_verts.size(); ++i)
+      {
+         unsigned int h = HashAttribs(m_verts[i]) & mask;
+         while (m_attribs[h] >= 0)
+            h = (h + 1) & mask;
+         m_attribs[h] = (int)i;
+      }
+   }
+
+   const ObjData &m_obj;
+   vector<Vertex3D_NoTex2> &m_verts;
+
+   std::vector<int> m_firstCorner; // per position: first entry in m_corners, -1 if none
+   std::vector<Corner> m_corners;
+   std::vector<int> m_attribs;     // indices into verts, open addressing with linear probing
+   size_t m_numAttribs;
+};
+
+// tokenizer working directly on the memory mapped file
+class ObjTokenizer
+{
+public:
+   ObjTokenizer(const char * const data, const size_t size) : m_cur(data), m_end(data + size) { }
+
+   bool AtEnd() const { return m_cur >= m_end; }
+
+   // skips blanks, but not the end of the line
+   void SkipBlanks()
+   {
+      while (m_cur < m_end && (*m_cur == ' ' || *m_cur == '\t' || *m_cur == '\r'))
+         m_cur++;
+   }
+
+   bool AtEndOfLine()
+   {
+      SkipBlanks();
+      return m_cur >= m_end || *m_cur == '\n';
+   }
+
+   void SkipLine()
+   {
+      while (m_cur < m_end && *m_cur != '\n')
+         m_cur++;
+      if (m_cur < m_end)
+         m_cur++;
+   }
+
+   // next whitespace separated token (also across lines), returns its length
+   size_t Token(const char *&token)
+   {
+      while (m_cur < m_end && (*m_cur == ' ' || *m_cur == '\t' || *m_cur == '\r' || *m_cur == '\n'))
+         m_cur++;
+      token = m_cur;
+      while (m_cur < m_end && !(*m_cur == ' ' || *m_cur == '\t' || *m_cur == '\r' || *m_cur == '\n'))
+         m_cur++;
+      return m_cur - token;
+   }
+
+   bool Float(float &f)
+   {
+      SkipBlanks();
+      const char * const start = m_cur;
+      const char *p = m_cur;
+      bool neg = false;
+      if (p < m_end && (*p == '-' || *p == '+'))
+         neg = (*p++ == '-');
+
+      // exact fast path (mantissa < 2^53, power of ten <= 22), otherwise fall back to strtod
+      unsigned long long mantissa = 0;
+      int digits = 0, exp10 = 0;
+      bool any = false;
+      for (; p < m_end && *p >= '0' && *p <= '9'; ++p, any = true)
+         if (digits < 18) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) digits++; }
+         else exp10++;
+      if (p < m_end && *p == '.')
+         for (++p; p < m_end && *p >= '0' && *p <= '9'; ++p, any = true)
+            if (digits < 18) { mantissa = mantissa * 10 + (*p - '0'); if (mantissa) digits++; exp10--; }
+      if (!any)
+         return false;
+      const bool slowPath = (digits >= 18) || (mantissa > (1ull << 53));
+      if (p < m_end && (*p == 'e' || *p == 'E'))
+      {
+         const char *q = p + 1;
+         bool eneg = false;
+         if (q < m_end && (*q == '-' || *q == '+'))
+            eneg = (*q++ == '-');
+         if (q < m_end && *q >= '0' && *q <= '9')
+         {
+            int e = 0;
+            for (; q < m_end && *q >= '0' && *q <= '9'; ++q)
+               if (e < 10000) e = e * 10 + (*q - '0');
+            exp10 += eneg ? -e : e;
+            p = q;
+         }
+      }
+      m_cur = p;
+
+      if (!slowPath && exp10 >= -22 && exp10 <= 22)
+      {
+         static const double pow10[23] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+         const double d = (exp10 < 0) ? (double)mantissa / pow10[-exp10] : (double)mantissa * pow10[exp10];
+         f = (float)(neg ? -d : d);
+      }
+      else
+      {
+         char tmp[64];
+         const size_t len = min((size_t)(p - start), sizeof(tmp) - 1);
+         memcpy(tmp, start, len);
+         tmp[len] = 0;
+         f = (float)strtod(tmp, NULL);
+      }
+      return true;
+   }
+
+   bool Int(int &i)
+   {
+      const char *p = m_cur;
+      bool neg = false;
+      if (p < m_end && (*p == '-' || *p == '+'))
+         neg = (*p++ == '-');
+      if (p >= m_end || *p < '0' || *p > '9')
+         return false;
+      int v = 0;
+      for (; p < m_end && *p >= '0' && *p <= '9'; ++p)
+         v = v * 10 + (*p - '0');
+      i = neg ? -v : v;
+      m_cur = p;
+      return true;
+   }
+
+   bool Char(const char c)
+   {
+      if (m_cur < m_end && *m_cur == c)
+      {
+         m_cur++;
+         return true;
+      }
       return false;
+   }
 
-   tmpVerts.clear();
-   tmpTexel.clear();
-   tmpNorms.clear();
-   tmpFaces.clear();
-   verts.clear();
-   faces.clear();
+private:
+   const char *m_cur;
+   const char * const m_end;
+};
+
+static bool TokenIs(const char * const token, const size_t len, const char * const keyword)
+{
+   return strlen(keyword) == len && memcmp(token, keyword, len) == 0;
+}
 
+// on failure error is set to the message
+static bool WaveFrontObj_Parse(ObjTokenizer &tok, const bool flipTv, const bool convertToLeftHanded, ObjData &obj, const char *&error)
+{
    struct VertInfo { int v; int t; int n; };
    std::vector<VertInfo> faceVerts;
 
-   // need some small data type 
-   while (1)
+   while (true)
    {
-      char lineHeader[256];
-      const int res = fscanf_s(f, "\n%s", lineHeader, 256);
-      if (res == EOF)
-      {
-         fclose(f);
-         break;
-      }
+      const char *token;
+      const size_t len = tok.Token(token);
+      if (len == 0)
+         return true;
 
-      if (strcmp(lineHeader, "v") == 0)
+      if (TokenIs(token, len, "v"))
       {
-         Vertex3Ds tmp;
-         fscanf_s(f, "%f %f %f\n", &tmp.x, &tmp.y, &tmp.z);
+         Vertex3Ds tmp(0.f, 0.f, 0.f);
+         tok.Float(tmp.x); tok.Float(tmp.y); tok.Float(tmp.z);
          if (convertToLeftHanded)
             tmp.z *= -1.0f;
-         tmpVerts.push_back(tmp);
+         obj.verts.push_back(tmp);
       }
-      else if (strcmp(lineHeader, "vt") == 0)
+      else if (TokenIs(token, len, "vt"))
       {
-         Vertex2D tmp;
-         fscanf_s(f, "%f %f", &tmp.x, &tmp.y);
+         Vertex2D tmp(0.f, 0.f);
+         tok.Float(tmp.x); tok.Float(tmp.y);
          if (flipTv || convertToLeftHanded)
          {
             tmp.y = 1.f - tmp.y;
          }
-         tmpTexel.push_back(tmp);
+         obj.texel.push_back(tmp);
       }
-      else if (strcmp(lineHeader, "vn") == 0)
+      else if (TokenIs(token, len, "vn"))
       {
-         Vertex3Ds tmp;
-         fscanf_s(f, "%f %f %f\n", &tmp.x, &tmp.y, &tmp.z);
+         Vertex3Ds tmp(0.f, 0.f, 0.f);
+         tok.Float(tmp.x); tok.Float(tmp.y); tok.Float(tmp.z);
          if (convertToLeftHanded)
             tmp.z *= -1.f;
-         tmpNorms.push_back(tmp);
+         obj.norms.push_back(tmp);
       }
-      else if (strcmp(lineHeader, "f") == 0)
+      else if (TokenIs(token, len, "f"))
       {
-         if (tmpVerts.size() == 0)
+         if (obj.verts.empty())
          {
-            ShowError("No vertices found in obj file, import is impossible!");
-            goto Error;
+            error = "No vertices found in obj file, import is impossible!";
+            return false;
          }
-         if (tmpTexel.size() == 0)
+         if (obj.texel.empty())
          {
-            ShowError("No texture coordinates (UVs) found in obj file, import is impossible!");
-            goto Error;
+            error = "No texture coordinates (UVs) found in obj file, import is impossible!";
+            return false;
          }
-         if (tmpNorms.size() == 0)
+         if (obj.norms.empty())
          {
-            ShowError("No normals found in obj file, import is impossible!");
-            goto Error;
+            error = "No normals found in obj file, import is impossible!";
+            return false;
          }
          faceVerts.clear();
-         int matches;
-         do
+         while (!tok.AtEndOfLine())
          {
             VertInfo vi;
-            matches = fscanf_s(f, "%d/%d/%d", &vi.v, &vi.t, &vi.n);
-            if (matches > 0 && matches != 3)
+            if (!tok.Int(vi.v) || !tok.Char('/') || !tok.Int(vi.t) || !tok.Char('/') || !tok.Int(vi.n))
             {
-               ShowError("Face information incorrect! Each face needs vertices, UVs and normals!");
-               goto Error;
+               error = "Face information incorrect! Each face needs vertices, UVs and normals!";
+               return false;
             }
-            if (matches == 3)
+            vi.v--; vi.t--; vi.n--;    // convert to 0-based indices
+            if ((unsigned int)vi.v >= obj.verts.size() || (unsigned int)vi.t >= obj.texel.size() || (unsigned int)vi.n >= obj.norms.size())
             {
-               vi.v--; vi.t--; vi.n--;    // convert to 0-based indices
-               faceVerts.push_back(vi);
+               error = "Face information incorrect! Index out of range!";
+               return false;
             }
-         } while (matches > 0);
+            faceVerts.push_back(vi);
+         }
 
          if (faceVerts.size() < 3)
          {
-            ShowError("Invalid face -- less than 3 vertices!");
-            goto Error;
+            error = "Invalid face -- less than 3 vertices!";
+            return false;
          }
 
          if (convertToLeftHanded)
@@ -273,119 +492,87 @@ bool WaveFrontObj_Load(const char *filename, const bool flipTv, const bool conve
             tmpFace.ti2 = faceVerts[i + 1].t;
             tmpFace.ni2 = faceVerts[i + 1].n;
 
-            tmpFaces.push_back(tmpFace);
+            obj.faces.push_back(tmpFace);
          }
       }
-      else
-      {
-         // unknown line header, skip rest of line
-         fgets(lineHeader, 256, f);
-      }
+
+      // skip rest of line (or unknown line header)
+      tok.SkipLine();
    }
+}
 
-   for (size_t i = 0; i < tmpFaces.size(); i++)
+bool WaveFrontObj_Load(const char *filename, const bool flipTv, const bool convertToLeftHanded, std::vector<Vertex3D_NoTex2> &verts, std::vector<unsigned int> &indices, std::string * const error)
+{
+   const unsigned long long start_usec = usec();
+
+   verts.clear();
+   indices.clear();
+
+   const HANDLE hFile = CreateFile(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+   if (hFile == INVALID_HANDLE_VALUE)
    {
-      int idx = isInList(tmpFaces[i].vi0, tmpFaces[i].ti0, tmpFaces[i].ni0);
-      if (idx == -1)
-      {
-         Vertex3D_NoTex2 tmp;
-         tmp.x = tmpVerts[tmpFaces[i].vi0].x;
-         tmp.y = tmpVerts[tmpFaces[i].vi0].y;
-         tmp.z = tmpVerts[tmpFaces[i].vi0].z;
-         tmp.tu = tmpTexel[tmpFaces[i].ti0].x;
-         tmp.tv = tmpTexel[tmpFaces[i].ti0].y;
-         tmp.nx = tmpNorms[tmpFaces[i].ni0].x;
-         tmp.ny = tmpNorms[tmpFaces[i].ni0].y;
-         tmp.nz = tmpNorms[tmpFaces[i].ni0].z;
-         verts.push_back(tmp);
-         faces.push_back((int)(verts.size() - 1));
-      }
-      else
-      {
-         faces.push_back(idx);
-      }
+      if (error) // else the caller reports it
+         *error = "Could not open obj file!";
+      return false;
+   }
 
-      idx = isInList(tmpFaces[i].vi1, tmpFaces[i].ti1, tmpFaces[i].ni1);
-      if (idx == -1)
-      {
-         Vertex3D_NoTex2 tmp;
-         tmp.x = tmpVerts[tmpFaces[i].vi1].x;
-         tmp.y = tmpVerts[tmpFaces[i].vi1].y;
-         tmp.z = tmpVerts[tmpFaces[i].vi1].z;
-         tmp.tu = tmpTexel[tmpFaces[i].ti1].x;
-         tmp.tv = tmpTexel[tmpFaces[i].ti1].y;
-         tmp.nx = tmpNorms[tmpFaces[i].ni1].x;
-         tmp.ny = tmpNorms[tmpFaces[i].ni1].y;
-         tmp.nz = tmpNorms[tmpFaces[i].ni1].z;
-         verts.push_back(tmp);
-         faces.push_back((int)(verts.size() - 1));
-      }
-      else
-      {
-         faces.push_back(idx);
-      }
+   LARGE_INTEGER fileSize;
+   if (!GetFileSizeEx(hFile, &fileSize) || (unsigned long long)fileSize.QuadPart > (size_t)~0)
+   {
+      CloseHandle(hFile);
+      if (error)
+         *error = "Could not read obj file size or file too large!";
+      return false;
+   }
 
-      idx = isInList(tmpFaces[i].vi2, tmpFaces[i].ti2, tmpFaces[i].ni2);
-      if (idx == -1)
-      {
-         Vertex3D_NoTex2 tmp;
-         tmp.x = tmpVerts[tmpFaces[i].vi2].x;
-         tmp.y = tmpVerts[tmpFaces[i].vi2].y;
-         tmp.z = tmpVerts[tmpFaces[i].vi2].z;
-         tmp.tu = tmpTexel[tmpFaces[i].ti2].x;
-         tmp.tv = tmpTexel[tmpFaces[i].ti2].y;
-         tmp.nx = tmpNorms[tmpFaces[i].ni2].x;
-         tmp.ny = tmpNorms[tmpFaces[i].ni2].y;
-         tmp.nz = tmpNorms[tmpFaces[i].ni2].z;
-         verts.push_back(tmp);
-         faces.push_back((int)(verts.size() - 1));
-      }
-      else
-      {
-         faces.push_back(idx);
-      }
+   // empty files cannot be mapped
+   const HANDLE hMap = (fileSize.QuadPart > 0) ? CreateFileMapping(hFile, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+   const char * const data = hMap ? (const char*)MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0) : NULL;
+   const char *errorMsg = NULL;
+   bool ok = false;
+   ObjData obj;
+   if (fileSize.QuadPart > 0 && data == NULL)
+      errorMsg = "Could not map obj file!";
+   else
+   {
+      ObjTokenizer tok(data, (size_t)fileSize.QuadPart);
+      ok = WaveFrontObj_Parse(tok, flipTv, convertToLeftHanded, obj, errorMsg);
    }
-   // not used yet
-   //   NormalizeNormals();
 
-   tmpVerts.clear();
-   tmpTexel.clear();
-   tmpNorms.clear();
-   tmpFaces.clear();
-   return true;
+   if (data)
+      UnmapViewOfFile(data);
+   if (hMap)
+      CloseHandle(hMap);
+   CloseHandle(hFile);
 
-Error:
-   tmpVerts.clear();
-   tmpTexel.clear();
-   tmpNorms.clear();
-   tmpFaces.clear();
-   fclose(f);
-   return false;
-}
+   if (ok)
+   {
+      const unsigned long long parse_usec = usec();
 
-void WaveFrontObj_GetVertices(std::vector<Vertex3D_NoTex2>& objMesh) // clears temporary storage on the way
-{
-   objMesh.resize(verts.size());
-   for (size_t i = 0; i < verts.size(); i++)
-   {
-      objMesh[i].x = verts[i].x;
-      objMesh[i].y = verts[i].y;
-      objMesh[i].z = verts[i].z;
-      objMesh[i].tu = verts[i].tu;
-      objMesh[i].tv = verts[i].tv;
-      objMesh[i].nx = verts[i].nx;
-      objMesh[i].ny = verts[i].ny;
-      objMesh[i].nz = verts[i].nz;
+      indices.resize(obj.faces.size() * 3);
+      VertexWelder welder(obj, verts);
+      for (size_t i = 0; i < obj.faces.size(); i++)
+      {
+         const MyPoly &f = obj.faces[i];
+         indices[i * 3    ] = welder.FindOrAdd(f.vi0, f.ti0, f.ni0);
+         indices[i * 3 + 1] = welder.FindOrAdd(f.vi1, f.ti1, f.ni1);
+         indices[i * 3 + 2] = welder.FindOrAdd(f.vi2, f.ti2, f.ni2);
+      }
+      // not used yet
+      //   NormalizeNormals(verts, indices);
+
+      slintf("WaveFrontObj_Load: %u triangles, %u vertices (%u welded) parsed in %.1f ms, welded in %.1f ms\n", (unsigned int)obj.faces.size(), (unsigned int)obj.verts.size(), (unsigned int)verts.size(),
+         (double)(parse_usec - start_usec) / 1000., (double)(usec() - parse_usec) / 1000.);
+   }
+   else if (errorMsg)
+   {
+      if (error)
+         *error = errorMsg;
+      else
+         ShowError(errorMsg);
    }
-   verts.clear();
-}
 
-void WaveFrontObj_GetIndices(std::vector<unsigned int>& list) // clears temporary storage on the way
-{
-   list.resize(faces.size());
-   for (size_t i = 0; i < faces.size(); i++)
-      list[i] = faces[i];
-   faces.clear();
+   return ok;
 }
 
 FILE* WaveFrontObj_ExportStart(const char *filename)
@@ -575,7 +762,7 @@ void WaveFrontObj_Save(const char *filename, const char *description, const Mesh
    fclose(f);
    return;
    */
-   if(mesh.m_animationFrames.size() == 0)
+   if(mesh.m_animation.NumFrames() == 0)
    {
        f = WaveFrontObj_ExportStart( filename );
        if(!f)
@@ -593,18 +780,19 @@ void WaveFrontObj_Save(const char *filename, const char *description, const Mesh
        std::size_t pos = fname.find_last_of( "." );
        string name = fname.substr( 0, pos );
        char number[32] = { 0 };
-       for(unsigned int i = 0; i < mesh.m_animationFrames.size(); i++)
+       for(unsigned int i = 0; i < mesh.m_animation.NumFrames(); i++)
        {
            std::vector<Vertex3D_NoTex2> vertsTmp = mesh.m_vertices;
 
+           const Mesh::VertData * const frameVerts = mesh.m_animation.GetFrame(i);
            for(unsigned int t = 0; t < mesh.NumVertices(); t++)
            {
-               vertsTmp[t].x = mesh.m_animationFrames[i].m_frameVerts[t].x;
-               vertsTmp[t].y = mesh.m_animationFrames[i].m_frameVerts[t].y;
-               vertsTmp[t].z = mesh.m_animationFrames[i].m_frameVerts[t].z;
-               vertsTmp[t].nx = mesh.m_animationFrames[i].m_frameVerts[t].nx;
-               vertsTmp[t].ny = mesh.m_animationFrames[i].m_frameVerts[t].ny;
-               vertsTmp[t].nz = mesh.m_animationFrames[i].m_frameVerts[t].nz;
+               vertsTmp[t].x = frameVerts[t].x;
+               vertsTmp[t].y = frameVerts[t].y;
+               vertsTmp[t].z = frameVerts[t].z;
+               vertsTmp[t].nx = frameVerts[t].nx;
+               vertsTmp[t].ny = frameVerts[t].ny;
+               vertsTmp[t].nz = frameVerts[t].nz;
            }
            sprintf_s( number, "%05u", i );
            fname = name + "_" + string(number)+".obj";
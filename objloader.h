@@ -8,9 +8,8 @@ void WaveFrontObj_WriteVertexInfo(FILE *f, const Vertex3D_NoTex2 *verts, unsigne
 void WaveFrontObj_WriteFaceInfo(FILE *f, const std::vector<WORD> &faces);
 void WaveFrontObj_WriteFaceInfoLong(FILE *f, const std::vector<unsigned int> &faces);
 void WaveFrontObj_Save(const char *filename, const char *description, const Mesh& mesh);
-void WaveFrontObj_GetVertices(std::vector<Vertex3D_NoTex2>& objMesh);
-void WaveFrontObj_GetIndices(std::vector<unsigned int>& list);
-bool WaveFrontObj_Load(const char *filename, const bool flipTv, const bool convertToLeftHanded);
+// re-entrant (so several files can be loaded in parallel), on failure the message is stored in error if given, otherwise shown
+bool WaveFrontObj_Load(const char *filename, const bool flipTv, const bool convertToLeftHanded, std::vector<Vertex3D_NoTex2> &verts, std::vector<unsigned int> &indices, std::string * const error = NULL);
 void WaveFrontObj_WriteFaceInfoList(FILE *f, const WORD *faces, const unsigned int numIndices);
 void WaveFrontObj_WriteMaterial(const char *texelName, const char *texelFilename, const Material * const mat);
 void WaveFrontObj_UseTexture(FILE *f, const char *texelName);
@@ -90,12 +90,24 @@ struct CollisionEvent
 };
 
 
+// Runtime state shared by all hit objects of one table element (Primitive, HitTarget, Ramp, Rubber),
+// so that the collision tree can skip whole subtrees of a disabled (or far away) element at once
+struct HitGroup
+{
+   HitGroup() { Reset(true); }
+
+   void Reset(const bool enabled) { m_bounds.Clear(); m_fEnabled = enabled; }
+
+   FRect3D m_bounds;  // union of the hit bounding boxes of all members, set up when building the tree
+   bool m_fEnabled;   // false if the element is currently not collidable (or dropped)
+};
+
 class HitObject
 {
 public:
    HitObject() : m_fEnabled(true), m_ObjType(eNull), m_obj(NULL),
       m_elasticity(0.3f), m_elasticityFalloff(0.0f), m_friction(0.3f), m_scatter(0.0f),
-      m_threshold(0.f), m_pfedebug(NULL), m_fe(false), m_e(false) {}
+      m_threshold(0.f), m_pfedebug(NULL), m_fe(false), m_group(NULL) {}
    virtual ~HitObject() {}
 
    virtual float HitTest(const Ball * const pball, const float dtime, CollisionEvent& coll) const { return -1.f; } //!! shouldn't need to do this, but for whatever reason there is a pure virtual function call triggered otherwise that refuses to be debugged (all derived classes DO implement this one!)
@@ -127,7 +139,8 @@ public:
    bool  m_fEnabled;
 
    bool  m_fe;  // FireEvents for m_obj?
-   bool  m_e;   // currently only used to determine which HitTriangles/HitLines/HitPoints are being part of the same Primitive element m_obj, to be able to early out intersection traversal if primitive is flagged as not collidable
+
+   HitGroup *m_group; // element this hit object is part of (if any), to be able to early out intersection traversal if the element is not collidable
 };
 
 //
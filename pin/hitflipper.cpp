@@ -184,6 +184,7 @@ void FlipperMoverObject::SetMass(const float m)
 
 void FlipperMoverObject::UpdateDisplacements(const float dtime)
 {
+   const float angleOld = m_angleCur;
    m_angleCur += m_angleSpeed*dtime;	// move flipper angle
 
    const float angleMin = min(m_angleStart, m_angleEnd);
@@ -194,6 +195,9 @@ void FlipperMoverObject::UpdateDisplacements(const float dtime)
    if (m_angleCur < angleMin)
       m_angleCur = angleMin;
 
+   if (m_angleCur != angleOld)
+      g_pplayer->m_flipperLatency.Moved(this);
+
    if (fabsf(m_angleSpeed) < 0.0005f)   // avoids 'jumping balls' when two or more balls held on flipper (and more other balls are in play) //!! make dependent on physics update rate
       return;
 
@@ -318,6 +322,8 @@ void FlipperMoverObject::ApplyImpulse(const Vertex3Ds& rotI)
 void FlipperMoverObject::SetSolenoidState(const bool s) // true = button pressed, false = released
 {
    m_solState = s;
+   if (s)
+      g_pplayer->m_flipperLatency.SolenoidOn(this);
 #ifdef DEBUG_FLIPPERS
    if (m_angleCur == m_angleStart)
       m_startTime = g_pplayer->m_time_msec;
@@ -3,6 +3,8 @@
 #include <time.h>
 #include "../meshes/ballMesh.h"
 #include "BallShader.h"
+#include "../inc/miniz.h"
+#include <shlobj.h>
 
 // touch defines, delete as soon as we can get rid of old compilers and use new ones that have these natively
 //#define TEST_TOUCH_WITH_MOUSE
@@ -483,6 +485,9 @@ Player::Player(bool _cameraMode) : cameraMode(_cameraMode)
    m_sleeptime = 0;
 
    m_pxap = NULL;
+   m_psoundmixer = NULL;
+   ZeroMemory(&m_soundStats, sizeof(m_soundStats));
+   ZeroMemory(&m_lastSoundStats, sizeof(m_lastSoundStats));
    m_pactiveball = NULL;
 
    m_curPlunger = JOYRANGEMN - 1;
@@ -548,6 +553,36 @@ Player::Player(bool _cameraMode) : cameraMode(_cameraMode)
    else
        m_disableAO = (AO == 1);
 
+   int progressiveStatic;
+   hr = GetRegInt("Player", "ProgressiveStatic", &progressiveStatic);
+   if (hr != S_OK)
+       m_progressiveStatic = false; // The default = off
+   else
+       m_progressiveStatic = (progressiveStatic == 1);
+   int staticCache;
+   hr = GetRegInt("Player", "StaticCache", &staticCache);
+   if (hr != S_OK)
+       m_staticCacheEnabled = false; // The default = off
+   else
+       m_staticCacheEnabled = (staticCache == 1);
+   m_staticCache.m_maxSize = (unsigned long long)GetRegIntWithDefault("Player", "StaticCacheSizeMB", 256) * (1024 * 1024);
+   m_staticRefineIter = -1;
+   m_staticReadback = NULL;
+   for (unsigned int i = 0; i < STATIC_STAGING_COUNT; ++i)
+   {
+      m_staticStaging[i] = NULL;
+      m_staticStagingFence[i] = NULL;
+   }
+   m_staticStagingHead = 0;
+   m_staticStagingCount = 0;
+   m_staticStagingLocked = -1;
+#ifdef ENABLE_PROFILER
+   m_profilerSpikeUsec = (U64)GetRegIntWithDefault("Player", "ProfilerSpikeMs", 0) * 1000;
+   m_profilerSpikes = 0;
+#endif
+   m_staticAccum.m_src = NULL;
+   m_staticAccum.m_passes = 0;
+
    int ss_refl;
    hr = GetRegInt("Player", "SSRefl", &ss_refl);
    if (hr != S_OK)
@@ -731,6 +766,8 @@ Player::Player(bool _cameraMode) : cameraMode(_cameraMode)
    c_traversed = 0;
    c_tested = 0;
    c_deepTested = 0;
+   c_groupSkipped = 0;
+   c_groupSkippedTests = 0;
 #endif
 
    m_movedPlunger = 0;
@@ -748,6 +785,9 @@ Player::Player(bool _cameraMode) : cameraMode(_cameraMode)
    m_dmdx = 0;
    m_dmdy = 0;
    m_texdmd = NULL;
+   m_dmdFrameColored = false;
+   m_dmdFrames = 0;
+   m_dmdFramesSkipped = 0;
    backdropSettingActive = 0;
 
    m_ScreenOffset = Vertex2D(0, 0);
@@ -783,16 +823,36 @@ Player::~Player()
 
 void Player::Shutdown()
 {
+#ifdef ENABLE_PROFILER
+   char szTrace[MAX_PATH];
+   sprintf_s(szTrace, "%sTrace.json", g_pvp->m_szMyPath);
+   Profiler::Export(szTrace);
+#endif
+
    // if limit framerate if requested by user (vsync Hz higher than refreshrate of gfxcard/monitor), restore timeEndPeriod
    const int localvsync = (m_ptable->m_TableAdaptiveVSync == -1) ? m_VSync : m_ptable->m_TableAdaptiveVSync;
    if (localvsync > m_refreshrate)
       timeEndPeriod(1); // after last precise uSleep()
 
+   if (m_flipperLatency.m_enabled)
+   {
+      // settings that affect the latency, so logs of different setups can be compared
+      char szSettings[512];
+      sprintf_s(szSettings, "%.200s  MinPhysLoopTime: %d  AdaptiveVSync: %d  MaxPrerenderedFrames: %d  Refresh: %d Hz  FullScreen: %d",
+         m_ptable->m_szTitle, m_minphyslooptime, localvsync, m_maxPrerenderedFrames, m_refreshrate, (int)m_fFullScreen);
+      char szLog[MAX_PATH];
+      sprintf_s(szLog, "%sFlipperLatency.log", g_pvp->m_szMyPath);
+      m_flipperLatency.WriteLog(szLog, szSettings);
+   }
+
    if(m_toogle_DTFS && m_ptable->m_BG_current_set != 2)
        m_ptable->m_BG_current_set ^= 1;
 
    m_pininput.UnInit();
 
+   FreeStaticAccumulation();
+   m_staticCacheJob.Wait();
+
    SAFE_RELEASE(ballVertexBuffer);
    SAFE_RELEASE(ballIndexBuffer);
    if (ballShader)
@@ -848,11 +908,7 @@ void Player::Shutdown()
       delete pball;
    }
 
-   //!! see above
-   //for (size_t i=0;i<m_vho_dynamic.size();i++)
-   //      delete m_vho_dynamic[i];
-   //m_vho_dynamic.clear();
-
+   m_ballSweepAndPrune.Clear();
    m_vball.clear();
 
    m_dmdx = 0;
@@ -882,6 +938,8 @@ void Player::Shutdown()
       m_pxap = NULL;
    }
 
+   SAFE_DELETE(m_psoundmixer);
+
    for (size_t i = 0; i < m_controlclsidsafe.size(); i++)
       delete m_controlclsidsafe[i];
    m_controlclsidsafe.clear();
@@ -906,6 +964,10 @@ void Player::InitFPS()
     m_fps = 0.0f;
     m_fpsAvg = 0.0f;
     m_fpsCount = 0;
+    m_dmdFrames = 0;
+    m_dmdFramesSkipped = 0;
+    m_dmdFps = 0.0f;
+    m_dmdSkippedFps = 0.0f;
     m_total = 0;
     m_count = 0;
     m_max = 0;
@@ -1076,6 +1138,10 @@ void Player::InitRegValues()
    hr = GetRegInt("Player", "SoundVolume", &m_SoundVolume);
    if (hr != S_OK)
       m_SoundVolume = 100; // default value
+
+   m_maxSoundVoices = max(GetRegIntWithDefault("Player", "MaxSoundVoices", 64), 0);
+
+   m_flipperLatency.m_enabled = (GetRegIntWithDefault("Player", "FlipperLatencyLog", 0) == 1);
 }
 
 void Player::InitDebugHitStructure()
@@ -1102,32 +1168,274 @@ void Player::InitDebugHitStructure()
 
 Vertex3Ds g_viewDir;
 
-static bool CompareHitableDepth(Hitable* h1, Hitable* h2)
+// LSD radix sort, 8 bits per pass, passes where all keys share the same byte are skipped
+void RenderQueue::Sort()
+{
+   const size_t n = m_entries.size();
+   if (n < 2)
+      return;
+
+   unsigned int counts[8][256];
+   memset(counts, 0, sizeof(counts));
+   for (size_t i = 0; i < n; ++i)
+   {
+      const unsigned long long key = m_entries[i].m_key;
+      for (unsigned int b = 0; b < 8; ++b)
+         counts[b][(key >> (b * 8)) & 0xFF]++;
+   }
+
+   m_tmp.resize(n);
+   for (unsigned int b = 0; b < 8; ++b)
+   {
+      unsigned int * const c = counts[b];
+      if (c[(m_entries[0].m_key >> (b * 8)) & 0xFF] == n)
+         continue;
+
+      unsigned int sum = 0;
+      for (unsigned int i = 0; i < 256; ++i)
+      {
+         const unsigned int t = c[i];
+         c[i] = sum;
+         sum += t;
+      }
+      for (size_t i = 0; i < n; ++i)
+         m_tmp[c[(m_entries[i].m_key >> (b * 8)) & 0xFF]++] = m_entries[i];
+      m_entries.swap(m_tmp);
+   }
+}
+
+LatencyHistogram::LatencyHistogram()
+{
+   m_count = 0;
+   memset(m_buckets, 0, sizeof(m_buckets));
+   m_min = ~0ull;
+   m_max = 0;
+   m_sum = 0;
+}
+
+void LatencyHistogram::Add(const U64 latency)
+{
+   m_buckets[min(latency / BUCKET_USEC, (U64)(NUM_BUCKETS - 1))]++;
+   m_count++;
+   m_min = min(m_min, latency);
+   m_max = max(m_max, latency);
+   m_sum += latency;
+}
+
+U64 LatencyHistogram::Percentile(const double p) const
+{
+   const unsigned int target = (unsigned int)ceil(p * m_count);
+   unsigned int sum = 0;
+   for (unsigned int i = 0; i < NUM_BUCKETS - 1; ++i)
+   {
+      sum += m_buckets[i];
+      if (sum >= target)
+         return min((U64)(i + 1) * BUCKET_USEC, m_max);
+   }
+   return m_max;
+}
+
+void LatencyHistogram::Write(FILE * const f, const char * const name) const
+{
+   if (m_count == 0)
+   {
+      fprintf(f, "%s: no samples\n", name);
+      return;
+   }
+
+   fprintf(f, "%s: %u samples, min %.2f avg %.2f p50 %.2f p90 %.2f p99 %.2f max %.2f ms\n", name, m_count,
+      (double)m_min / 1000., (double)m_sum / (1000. * m_count),
+      (double)Percentile(0.5) / 1000., (double)Percentile(0.9) / 1000., (double)Percentile(0.99) / 1000., (double)m_max / 1000.);
+
+   unsigned int peak = 0;
+   for (unsigned int i = 0; i < NUM_BUCKETS; ++i)
+      peak = max(peak, m_buckets[i]);
+
+   for (unsigned int i = 0; i < NUM_BUCKETS; ++i)
+   {
+      if (m_buckets[i] == 0)
+         continue;
+      char bar[41];
+      const unsigned int len = max(m_buckets[i] * 40 / peak, 1u);
+      memset(bar, '#', len);
+      bar[len] = '\0';
+      if (i < NUM_BUCKETS - 1)
+         fprintf(f, "  %5.1f - %5.1f ms %6u %s\n", (double)(i * BUCKET_USEC) / 1000., (double)((i + 1) * BUCKET_USEC) / 1000., m_buckets[i], bar);
+      else
+         fprintf(f, "  %5.1f ms and more %6u %s\n", (double)(i * BUCKET_USEC) / 1000., m_buckets[i], bar);
+   }
+}
+
+FlipperLatency::FlipperLatency()
 {
-   // GetDepth approximates direction in view distance to camera; sort ascending
-   return h1->GetDepth(g_viewDir) >= h2->GetDepth(g_viewDir);
+   m_enabled = false;
+   memset(m_press, 0, sizeof(m_press));
+   m_handlingKey = NumKeys;
+   memset(m_frames, 0, sizeof(m_frames));
+   m_lost = 0;
 }
 
-static bool CompareHitableDepthInverse(Hitable* h1, Hitable* h2)
+void FlipperLatency::KeyDown(const Key key, const unsigned int frame)
 {
-	// GetDepth approximates direction in view distance to camera; sort descending
-	return h1->GetDepth(g_viewDir) <= h2->GetDepth(g_viewDir);
+   if (!m_enabled)
+      return;
+
+   Press &press = m_press[key];
+   if (press.pending)
+      m_lost++;
+
+   press.pending = true;
+   press.keyUsec = usec();
+   press.keyFrame = frame;
+   memset(press.stageUsec, 0, sizeof(press.stageUsec));
+   press.pmover = NULL;
+
+   m_handlingKey = key;
 }
 
-static bool CompareHitableDepthReverse(Hitable* h1, Hitable* h2)
+void FlipperLatency::SolenoidOn(const FlipperMoverObject * const pmover)
 {
-   // GetDepth approximates direction in view distance to camera; sort descending
-   return h1->GetDepth(g_viewDir) < h2->GetDepth(g_viewDir);
+   // the first flipper the script switches on in the key handler is the one followed for that key,
+   // outside of it (e.g. driven by a ROM) it goes to the oldest press still waiting for its solenoid
+   Press *press = NULL;
+   if (m_handlingKey != NumKeys)
+      press = &m_press[m_handlingKey];
+   else
+      for (unsigned int i = 0; i < NumKeys; ++i)
+         if (m_press[i].pending && m_press[i].stageUsec[Solenoid] == 0 && (press == NULL || m_press[i].keyUsec < press->keyUsec))
+            press = &m_press[i];
+
+   if (press == NULL || !press->pending || press->stageUsec[Solenoid] != 0)
+      return;
+
+   // a flipper already followed for the other key keeps its first press
+   for (unsigned int i = 0; i < NumKeys; ++i)
+      if (&m_press[i] != press && m_press[i].pending && m_press[i].pmover == pmover)
+         return;
+
+   press->stageUsec[Solenoid] = usec();
+   press->pmover = pmover;
 }
 
-static bool CompareHitableMaterial(Hitable* h1, Hitable* h2)
+void FlipperLatency::StampMove(Press &press)
 {
-   return h1->GetMaterialID() < h2->GetMaterialID();
+   press.stageUsec[Move] = usec();
 }
 
-static bool CompareHitableImage(Hitable* h1, Hitable* h2)
+void FlipperLatency::Rendered()
 {
-	return h1->GetImageID() < h2->GetImageID();
+   for (unsigned int i = 0; i < NumKeys; ++i)
+   {
+      Press &press = m_press[i];
+      if (press.pending && press.stageUsec[Move] != 0 && press.stageUsec[Render] == 0)
+         press.stageUsec[Render] = usec();
+   }
+}
+
+void FlipperLatency::Flipped(const unsigned int frame)
+{
+   for (unsigned int i = 0; i < NumKeys; ++i)
+   {
+      Press &press = m_press[i];
+      if (!press.pending || press.stageUsec[Render] == 0)
+         continue;
+
+      press.stageUsec[Flip] = usec();
+      for (unsigned int s = 0; s < NumStages; ++s)
+         m_histograms[s].Add(press.stageUsec[s] - press.keyUsec);
+      m_frames[min(frame - press.keyFrame, 3u)]++;
+
+      press.pending = false;
+      press.pmover = NULL;
+   }
+}
+
+void FlipperLatency::WriteLog(const char * const filename, const char * const settings) const
+{
+   FILE *f;
+   if (fopen_s(&f, filename, "a") != 0 || !f)
+      return;
+
+   SYSTEMTIME st;
+   GetLocalTime(&st);
+   fprintf(f, "==== %04u-%02u-%02u %02u:%02u:%02u %s\n", st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond, settings);
+
+   static const char * const names[NumStages] = { "Key to solenoid", "Key to flipper move", "Key to rendered", "Key to flip" };
+   for (unsigned int i = 0; i < NumStages; ++i)
+      m_histograms[i].Write(f, names[i]);
+
+   fprintf(f, "Frames from key to flip: 0: %u  1: %u  2: %u  more: %u  (%u presses not followed by a flipper)\n\n",
+      m_frames[0], m_frames[1], m_frames[2], m_frames[3], m_lost);
+   fclose(f);
+}
+
+// maps a float to an unsigned int with the same ordering
+static unsigned int SortableDepth(const float depth)
+{
+   const unsigned int u = *(const unsigned int*)&depth;
+   return (u & 0x80000000u) ? ~u : (u | 0x80000000u);
+}
+
+// the material/image ID's are hashes or pointers, so compact them to their rank
+static unsigned int IDRank(const std::vector<unsigned long long>& ids, const unsigned long long id, const unsigned int maxRank)
+{
+   const unsigned int rank = (unsigned int)(std::lower_bound(ids.begin(), ids.end(), id) - ids.begin());
+   return min(rank, maxRank);
+}
+
+void Player::BuildRenderQueues()
+{
+   std::vector<unsigned long long> materials, images;
+   std::vector<Hitable*> all(m_vHitNonTrans);
+   all.insert(all.end(), m_vHitTrans.begin(), m_vHitTrans.end());
+   for (size_t i = 0; i < all.size(); ++i)
+   {
+      materials.push_back(all[i]->GetMaterialID());
+      images.push_back(all[i]->GetImageID());
+   }
+   std::sort(materials.begin(), materials.end());
+   materials.erase(std::unique(materials.begin(), materials.end()), materials.end());
+   std::sort(images.begin(), images.end());
+   images.erase(std::unique(images.begin(), images.end()), images.end());
+
+   // non-transparent: material, image, depth (front to back, also keeps em reels (=same depth) in user defined order)
+   // transparent: depth (back to front), material, image
+   m_opaqueQueue.Clear();
+   m_transparentQueue.Clear();
+   for (size_t i = 0; i < all.size(); ++i)
+   {
+      Hitable * const ph = all[i];
+      const unsigned long long material = IDRank(materials, ph->GetMaterialID(), 0x7FFF);
+      const unsigned long long image = IDRank(images, ph->GetImageID(), 0xFFFF);
+      const unsigned long long depth = SortableDepth(ph->GetDepth(g_viewDir));
+      const unsigned long long dmd = ph->IsDMD() ? RenderQueue::DMD_BIT : 0;
+      if (i < m_vHitNonTrans.size())
+      {
+         m_opaqueQueue.Add(ph, dmd | (material << 48) | (image << 32) | depth);
+         if (dmd)
+            m_transparentQueue.Add(ph, dmd | ((0xFFFFFFFFull - depth) << 31) | (material << 16) | image);
+      }
+      else
+         m_transparentQueue.Add(ph, ((0xFFFFFFFFull - depth) << 31) | (material << 16) | image);
+   }
+   m_opaqueQueue.Sort();
+   m_transparentQueue.Sort();
+
+   // other passes (mirror, light buffer, profiling) walk the vectors directly, so keep these in the same order
+   for (size_t i = 0; i < m_opaqueQueue.size(); ++i)
+      m_vHitNonTrans[i] = m_opaqueQueue[i];
+   size_t t = 0;
+   for (size_t i = 0; i < m_transparentQueue.size(); ++i)
+      if (!m_transparentQueue.IsDMD(i))
+         m_vHitTrans[t++] = m_transparentQueue[i];
+
+   material_flips = 0;
+   for (size_t i = 1; i < m_vHitNonTrans.size(); ++i)
+      if (m_vHitNonTrans[i]->GetMaterialID() != m_vHitNonTrans[i - 1]->GetMaterialID())
+         material_flips++;
+   for (size_t i = 1; i < m_vHitTrans.size(); ++i)
+      if (m_vHitTrans[i]->GetMaterialID() != m_vHitTrans[i - 1]->GetMaterialID())
+         material_flips++;
 }
 
 void Player::UpdateBasicShaderMatrix(const Matrix3D& objectTrafo)
@@ -1404,6 +1712,33 @@ HRESULT Player::Init(PinTable * const ptable, const HWND hwndProgress, const HWN
    InitKeys();
    InitRegValues();
 
+   // Software mixer for table sounds: 0 = off (one DirectSound buffer per voice), 1 = DirectSound output, 2 = null output, 3 = write SoundMixer.wav
+   const int soundMixer = GetRegIntWithDefault("Player", "SoundMixer", 0);
+   if (m_fPlaySound && soundMixer > 0)
+   {
+      const unsigned int sampleRate = 44100;
+      const unsigned int periodFrames = (max(GetRegIntWithDefault("Player", "SoundMixerPeriod", 256), 4) + 3) & ~3; // 5.8ms by default, multiple of 4 frames
+      SoundMixerSink *sink;
+      if (soundMixer == 2)
+         sink = new NullMixerSink(sampleRate, true);
+      else if (soundMixer == 3)
+      {
+         char szWav[MAX_PATH];
+         sprintf_s(szWav, "%sSoundMixer.wav", g_pvp->m_szMyPath);
+         sink = new FileMixerSink(szWav, sampleRate, true);
+      }
+      else
+         sink = new DSoundMixerSink(g_pvp->m_pds.m_pDS, sampleRate, periodFrames, 3);
+      if (sink->IsOpen())
+      {
+         m_psoundmixer = new SoundMixer(sink, sampleRate, periodFrames, g_pvp->m_pds.m_i3DSoundMode);
+         m_psoundmixer->SetVoiceBudget(m_maxSoundVoices);
+         m_psoundmixer->Start();
+      }
+      else
+         delete sink; // no output, so keep one DirectSound buffer per voice
+   }
+
    //
    int DN;
    bool dynamicDayNight;
@@ -1658,9 +1993,6 @@ HRESULT Player::Init(PinTable * const ptable, const HWND hwndProgress, const HWN
    m_hitoctree.DumpTree(0);
 #endif
 
-   // initialize hit structure for dynamic objects
-   m_hitoctree_dynamic.FillFromVector(m_vho_dynamic);
-
    //----------------------------------------------------------------------------------
 
    SendMessage(hwndProgress, PBM_SETPOS, 60, 0);
@@ -1706,39 +2038,8 @@ HRESULT Player::Init(PinTable * const ptable, const HWND hwndProgress, const HWN
       }
    }
 
-   material_flips = 0;
-   unsigned long long m;
-   if (m_vHitNonTrans.size() > 0)
-   {
-      std::stable_sort(m_vHitNonTrans.begin(), m_vHitNonTrans.end(), CompareHitableDepthReverse); // stable, so that em reels (=same depth) will keep user defined order
-      std::stable_sort(m_vHitNonTrans.begin(), m_vHitNonTrans.end(), CompareHitableImage); // stable, so that objects with same images will keep depth order
-      // sort by vertexbuffer not useful currently
-      std::stable_sort(m_vHitNonTrans.begin(), m_vHitNonTrans.end(), CompareHitableMaterial); // stable, so that objects with same materials will keep image order
+   BuildRenderQueues();
 
-      m = m_vHitNonTrans[0]->GetMaterialID();
-      for (size_t i = 1; i < m_vHitNonTrans.size(); ++i)
-         if (m_vHitNonTrans[i]->GetMaterialID() != m)
-         {
-            material_flips++;
-            m = m_vHitNonTrans[i]->GetMaterialID();
-         }
-   }
-
-   if (m_vHitTrans.size() > 0)
-   {
-      std::stable_sort(m_vHitTrans.begin(), m_vHitTrans.end(), CompareHitableImage); // see above
-      // sort by vertexbuffer not useful currently
-      std::stable_sort(m_vHitTrans.begin(), m_vHitTrans.end(), CompareHitableMaterial);
-      std::stable_sort(m_vHitTrans.begin(), m_vHitTrans.end(), CompareHitableDepth);
-
-      m = m_vHitTrans[0]->GetMaterialID();
-      for (size_t i = 1; i < m_vHitTrans.size(); ++i)
-         if (m_vHitTrans[i]->GetMaterialID() != m)
-         {
-            material_flips++;
-            m = m_vHitTrans[i]->GetMaterialID();
-         }
-   }
    // Direct all renders to the back buffer.
    m_pin3d.SetRenderTarget(m_pin3d.m_pddsBackBuffer, m_pin3d.m_pddsZBuffer);
 
@@ -1965,13 +2266,9 @@ void Player::RenderDynamicMirror(const bool onlyBalls)
 
    if (!onlyBalls)
    {
-      std::stable_sort(m_vHitTrans.begin(), m_vHitTrans.end(), CompareHitableDepthInverse);
-
-      // Draw transparent objects.
-      for (size_t i = 0; i < m_vHitTrans.size(); ++i)
+      // Draw transparent objects (front to back, as mirrored).
+      for (size_t i = m_vHitTrans.size(); i-- > 0;)
          m_vHitTrans[i]->RenderDynamic();
-
-      std::stable_sort(m_vHitTrans.begin(), m_vHitTrans.end(), CompareHitableDepth);
    }
 
    DrawBalls();
@@ -2035,6 +2332,7 @@ void Player::RenderMirrorOverlay()
 void Player::InitStatic(HWND hwndProgress)
 {
    TRACE_FUNCTION();
+   PROFILE_FUNCTION();
 
    // Start the frame.
    for (size_t i = 0; i < m_vhitables.size(); ++i)
@@ -2046,40 +2344,113 @@ void Player::InitStatic(HWND hwndProgress)
    m_pin3d.InitPlayfieldGraphics();
 
    // allocate system/CPU memory buffer to copy static rendering buffer to (and accumulation float32 buffer) to do brute force oversampling of the static rendering
-   D3DSURFACE_DESC descStatic;
-   m_pin3d.m_pddsStatic->GetDesc(&descStatic);
-   RECT rectStatic;
-   rectStatic.left = 0;
-   rectStatic.right = descStatic.Width;
-   rectStatic.top = 0;
-   rectStatic.bottom = descStatic.Height;
+   if (!cameraMode)
+   {
+      D3DSURFACE_DESC descStatic;
+      m_pin3d.m_pddsStatic->GetDesc(&descStatic);
+      const unsigned int channels = (descStatic.Format == D3DFMT_A16B16G16R16F) ? 4 : ((descStatic.Format == D3DFMT_G16R16F) ? 2 : 1);
 
-   float * __restrict const pdestStatic = new float[descStatic.Width*descStatic.Height * 3]; // RGB float32
-   memset(pdestStatic, 0, descStatic.Width*descStatic.Height * 3 * sizeof(float));
+      m_staticAccum.m_rowLength = descStatic.Width * channels;
+      m_staticAccum.m_sum.assign(m_staticAccum.m_rowLength*descStatic.Height, 0.f);
+      m_staticAccum.m_passes = 0;
 
-   RenderTarget* offscreenSurface;
-   CHECKD3D(m_pin3d.m_pd3dPrimaryDevice->GetCoreDevice()->CreateOffscreenPlainSurface(descStatic.Width, descStatic.Height, descStatic.Format, D3DPOOL_SYSTEMMEM, &offscreenSurface, NULL));
+      CHECKD3D(m_pin3d.m_pd3dPrimaryDevice->GetCoreDevice()->CreateOffscreenPlainSurface(descStatic.Width, descStatic.Height, descStatic.Format, D3DPOOL_SYSTEMMEM, &m_staticReadback, NULL));
+      for (unsigned int i = 0; i < STATIC_STAGING_COUNT; ++i)
+      {
+         m_staticStaging[i] = m_pin3d.m_pd3dPrimaryDevice->DuplicateRenderTarget(m_pin3d.m_pddsStatic, true);
+         m_pin3d.m_pd3dPrimaryDevice->GetCoreDevice()->CreateQuery(D3DQUERYTYPE_EVENT, &m_staticStagingFence[i]); // stays NULL if not supported, then the readback just waits
+      }
+      m_staticStagingHead = 0;
+      m_staticStagingCount = 0;
+      m_staticStagingLocked = -1;
 
-   // if rendering static/with heavy oversampling, disable the aniso/trilinear filter to get a sharper/more precise result overall!
-   if (!cameraMode)
-   {
+      // if rendering static/with heavy oversampling, disable the aniso/trilinear filter to get a sharper/more precise result overall!
       m_isRenderingStatic = true;
       // set up the texture filter again, so that this is triggered correctly
       m_pin3d.m_pd3dPrimaryDevice->SetTextureFilter(0, TEXTURE_MODE_TRILINEAR);
       m_pin3d.m_pd3dPrimaryDevice->SetTextureFilter(4, TEXTURE_MODE_TRILINEAR);
    }
 
-//#define STATIC_PRERENDER_ITERATIONS_KOROBOV 7.0 // for the (commented out) lattice-based QMC oversampling, 'magic factor', depending on the the number of iterations!
-   // loop for X times and accumulate/average these renderings on CPU side
+   const U64 start_usec = usec();
+
+   // the unjittered pass is always rendered first, it provides the final static depth buffer (so the other passes go to the back/z buffer, see RenderStaticJitteredPass())
+   // and its image also identifies table, camera and resolution for the static cache
    // NOTE: iter == 0 MUST ALWAYS PRODUCE an offset of 0,0!
-   for (int iter = cameraMode ? 0 : (STATIC_PRERENDER_ITERATIONS-1); iter >= 0; --iter) // just do one iteration if in dynamic camera/light/material tweaking mode
+   RenderStaticPass(0, hwndProgress);
+
+   if (cameraMode) // just do one iteration if in dynamic camera/light/material tweaking mode
+      RenderStaticAO();
+   else
    {
-   m_pin3d.m_pd3dPrimaryDevice->m_stats_drawn_triangles = 0;
+      AccumulateStaticPass(m_pin3d.m_pddsStatic);
 
-   float u1 = xyLDBNbnot[iter*2  ];  //      (float)iter*(float)(1.0                                /STATIC_PRERENDER_ITERATIONS);
-   float u2 = xyLDBNbnot[iter*2+1];  //fmodf((float)iter*(float)(STATIC_PRERENDER_ITERATIONS_KOROBOV/STATIC_PRERENDER_ITERATIONS), 1.f);
+      bool cached = false;
+      if (m_staticCacheEnabled)
+      {
+         ReadbackStaticPass(true); // the key needs the unjittered image now
+         m_staticCache.m_key = StaticCacheKey();
+         cached = LoadStaticCache();
+         if (cached)
+            slintf("Static prerender: loaded from cache %s in %.1f ms\n", m_staticCache.m_filename.c_str(), (double)(usec() - start_usec) / 1000.);
+      }
+
+      // loop for X times and accumulate/average these renderings on CPU side, the accumulation of one pass runs in parallel to the rendering of the next
+      // in progressive mode the rest follows during play, see RefineStatic()
+      if (!cached && !m_progressiveStatic)
+         for (int iter = STATIC_PRERENDER_ITERATIONS-1; iter > 0; --iter)
+            RenderStaticJitteredPass(iter);
+
+      // if rendering static/with heavy oversampling, re-enable the aniso/trilinear filter now for the normal rendering
+      m_isRenderingStatic = false;
+      m_pin3d.m_pd3dPrimaryDevice->SetTextureFilter(0, TEXTURE_MODE_TRILINEAR);
+      m_pin3d.m_pd3dPrimaryDevice->SetTextureFilter(4, TEXTURE_MODE_TRILINEAR);
+      m_pin3d.InitLayout(m_ptable->m_BG_enable_FSS);
+
+      if (!cached)
+      {
+         ResolveStatic();
+         slintf("Static prerender: %u passes in %.1f ms\n", m_staticAccum.m_passes, (double)(usec() - start_usec) / 1000.);
+
+         // Now finalize static buffer with non-dynamic AO
+         RenderStaticAO();
+
+         m_staticRefineIter = m_progressiveStatic ? (STATIC_PRERENDER_ITERATIONS-1) : 0;
+         if (m_staticRefineIter == 0 && m_staticCacheEnabled)
+            SaveStaticCache();
+      }
+   }
+
+   if (m_staticRefineIter < 1)
+      FreeStaticAccumulation();
+}
+
+// renders a jittered static pass into the back/z buffer (as the static depth buffer has to stay the unjittered one, and the static buffer may still be displayed), and accumulates it
+void Player::RenderStaticJitteredPass(const int iter)
+{
+   std::swap(m_pin3d.m_pddsStatic, m_pin3d.m_pddsBackBuffer);
+   std::swap(m_pin3d.m_pddsStaticZ, m_pin3d.m_pddsZBuffer);
+   RenderStaticPass(iter, NULL);
+   std::swap(m_pin3d.m_pddsStatic, m_pin3d.m_pddsBackBuffer);
+   std::swap(m_pin3d.m_pddsStaticZ, m_pin3d.m_pddsZBuffer);
+
+   AccumulateStaticPass(m_pin3d.m_pddsBackBuffer);
+}
+
+//#define STATIC_PRERENDER_ITERATIONS_KOROBOV 7.0 // for the (commented out) lattice-based QMC oversampling, 'magic factor', depending on the the number of iterations!
+static void StaticPassJitter(const int iter, float &u1, float &u2)
+{
+   u1 = xyLDBNbnot[iter*2  ];  //      (float)iter*(float)(1.0                                /STATIC_PRERENDER_ITERATIONS);
+   u2 = xyLDBNbnot[iter*2+1];  //fmodf((float)iter*(float)(STATIC_PRERENDER_ITERATIONS_KOROBOV/STATIC_PRERENDER_ITERATIONS), 1.f);
    // the following line implements filter importance sampling for a small gauss (i.e. less jaggies as it also samples neighboring pixels) -> but also potentially more artifacts in compositing!
    gaussianDistribution(u1, u2, 0.5f, 0.5f); //!! first 0.5 could be increased for more blur, but is pretty much what is recommended
+}
+
+void Player::RenderStaticPass(const int iter, HWND hwndProgress)
+{
+   m_pin3d.m_pd3dPrimaryDevice->m_stats_drawn_triangles = 0;
+
+   float u1, u2;
+   StaticPassJitter(iter, u1, u2);
    // sanity check to be sure to limit filter area to 3x3 in practice, as the gauss transformation is unbound (which is correct, but for our use-case/limited amount of samples very bad)
    assert(u1 > -1.f && u1 < 2.f);
    assert(u2 > -1.f && u2 < 2.f);
@@ -2172,104 +2543,422 @@ void Player::InitStatic(HWND hwndProgress)
    // Finish the frame.
    m_pin3d.m_pd3dPrimaryDevice->EndScene();
 
-   // Readback static buffer, convert 16bit to 32bit float, and accumulate
-   if (!cameraMode)
-   {
-   CHECKD3D(m_pin3d.m_pd3dPrimaryDevice->GetCoreDevice()->GetRenderTargetData(m_pin3d.m_pddsStatic, offscreenSurface));
+   stats_drawn_static_triangles = m_pin3d.m_pd3dPrimaryDevice->m_stats_drawn_triangles;
+}
 
-   D3DLOCKED_RECT locked;
-   CHECKD3D(offscreenSurface->LockRect(&locked, &rectStatic, D3DLOCK_READONLY));
+struct StaticNormalizeJob
+{
+   const StaticAccumulation *accum;
+   unsigned short *dest;
+   unsigned int destPitch; // in halfs
+};
+
+static void StaticAccumulate(void *param, const unsigned int begin, const unsigned int end)
+{
+   StaticAccumulation * const accum = (StaticAccumulation*)param;
+   const __m128i zero = _mm_setzero_si128();
 
-   const unsigned short * __restrict const psrc = (unsigned short*)locked.pBits;
-   for (unsigned int y = 0; y < descStatic.Height; ++y)
+   for (unsigned int y = begin; y < end; ++y)
    {
-      unsigned int ofs0 = y*descStatic.Width*3;
-      unsigned int ofs1 = y*locked.Pitch/2;
-      if(descStatic.Format == D3DFMT_A16B16G16R16F)
-      {
-      for (unsigned int x = 0; x < descStatic.Width; ++x,ofs0+=3,ofs1+=4)
-      {
-         pdestStatic[ofs0  ] += half2float(psrc[ofs1  ]);
-         pdestStatic[ofs0+1] += half2float(psrc[ofs1+1]);
-         pdestStatic[ofs0+2] += half2float(psrc[ofs1+2]);
-      }
-      }
-      else if(descStatic.Format == D3DFMT_R16F)
+      const unsigned short * __restrict const psrc = accum->m_src + y*accum->m_srcPitch;
+      float * __restrict const pdest = accum->m_sum.data() + y*accum->m_rowLength;
+
+      unsigned int x = 0;
+      for (; x + 8 <= accum->m_rowLength; x += 8)
       {
-      for (unsigned int x = 0; x < descStatic.Width; ++x,++ofs0,++ofs1)
-         pdestStatic[ofs0] += half2float(psrc[ofs1]);
+         const __m128i h = _mm_loadu_si128((const __m128i*)(psrc + x));
+         _mm_storeu_ps(pdest + x,     _mm_add_ps(_mm_loadu_ps(pdest + x),     half2float_sse2(_mm_unpacklo_epi16(h, zero))));
+         _mm_storeu_ps(pdest + x + 4, _mm_add_ps(_mm_loadu_ps(pdest + x + 4), half2float_sse2(_mm_unpackhi_epi16(h, zero))));
       }
-      else if(descStatic.Format == D3DFMT_G16R16F)
-      {
-      for (unsigned int x = 0; x < descStatic.Width; ++x,ofs0+=2,ofs1+=2)
+      for (; x < accum->m_rowLength; ++x)
+         pdest[x] += half2float(psrc[x]);
+   }
+}
+
+static void StaticNormalize(void *param, const unsigned int begin, const unsigned int end)
+{
+   const StaticNormalizeJob * const job = (StaticNormalizeJob*)param;
+   const unsigned int rowLength = job->accum->m_rowLength;
+   const float invPasses = 1.0f / (float)job->accum->m_passes;
+   const __m128 scale = _mm_set1_ps(invPasses);
+
+   for (unsigned int y = begin; y < end; ++y)
+   {
+      const float * __restrict const psrc = job->accum->m_sum.data() + y*rowLength;
+      unsigned short * __restrict const pdest = job->dest + y*job->destPitch;
+
+      unsigned int x = 0;
+      for (; x + 8 <= rowLength; x += 8)
       {
-         pdestStatic[ofs0  ] += half2float(psrc[ofs1  ]);
-         pdestStatic[ofs0+1] += half2float(psrc[ofs1+1]);
-      }
+         const __m128i h0 = float2half_sse2(_mm_mul_ps(_mm_loadu_ps(psrc + x),     scale));
+         const __m128i h1 = float2half_sse2(_mm_mul_ps(_mm_loadu_ps(psrc + x + 4), scale));
+         // sign extend so that the saturating pack keeps all 16 bits
+         _mm_storeu_si128((__m128i*)(pdest + x), _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32(h0, 16), 16), _mm_srai_epi32(_mm_slli_epi32(h1, 16), 16)));
       }
+      for (; x < rowLength; ++x)
+         pdest[x] = float2half(psrc[x]*invPasses);
    }
+}
 
-   offscreenSurface->UnlockRect();
-   }
-   stats_drawn_static_triangles = m_pin3d.m_pd3dPrimaryDevice->m_stats_drawn_triangles;
+// Copy a static pass on the GPU to the next free staging buffer and fence it, then read back the oldest pass if its copy is done,
+// so that the lock does not have to wait for the GPU (only if all staging buffers are in use, the oldest one is waited for)
+void Player::AccumulateStaticPass(RenderTarget * const src)
+{
+   if (m_staticStagingCount + 1 >= STATIC_STAGING_COUNT)
+      ReadbackStaticPass(true);
+
+   const unsigned int slot = (m_staticStagingHead + m_staticStagingCount) % STATIC_STAGING_COUNT;
+   m_pin3d.m_pd3dPrimaryDevice->CopySurface(m_staticStaging[slot], src);
+   if (m_staticStagingFence[slot])
+      m_staticStagingFence[slot]->Issue(D3DISSUE_END);
+   m_staticStagingCount++;
+   m_staticAccum.m_passes++;
+
+   ReadbackStaticPass(false);
+}
+
+// finishes the accumulation of the last read back pass and unlocks its staging buffer
+void Player::WaitStaticAccumulate()
+{
+   m_staticAccumJob.Wait();
+   if (m_staticStagingLocked >= 0)
+   {
+      m_staticStaging[m_staticStagingLocked]->UnlockRect();
+      m_staticStagingLocked = -1;
+      m_staticAccum.m_src = NULL;
    }
+}
 
-   // if rendering static/with heavy oversampling, re-enable the aniso/trilinear filter now for the normal rendering
-   if (!cameraMode)
+// Readback the oldest pending static pass (if not wait, only if the GPU is done with its copy), convert 16bit to 32bit float,
+// and accumulate (in the background, until the next pass is read back)
+void Player::ReadbackStaticPass(const bool wait)
+{
+   if (m_staticStagingCount == 0)
+      return;
+
+   const unsigned int slot = m_staticStagingHead;
+   if (!wait && m_staticStagingFence[slot] && m_staticStagingFence[slot]->GetData(NULL, 0, D3DGETDATA_FLUSH) == S_FALSE)
+      return;
+
+   WaitStaticAccumulate();
+
+   D3DLOCKED_RECT locked;
+   CHECKD3D(m_staticStaging[slot]->LockRect(&locked, NULL, D3DLOCK_READONLY));
+   m_staticStagingLocked = (int)slot;
+   m_staticStagingHead = (slot + 1) % STATIC_STAGING_COUNT;
+   m_staticStagingCount--;
+   m_staticAccum.m_src = (const unsigned short*)locked.pBits;
+   m_staticAccum.m_srcPitch = locked.Pitch / 2;
+
+   // leave one core to the render thread
+   m_staticAccumJob.Start(StaticAccumulate, &m_staticAccum, (unsigned int)(m_staticAccum.m_sum.size() / m_staticAccum.m_rowLength), max(GetNumCPUCores(), 2u) - 1);
+}
+
+// now normalize oversampled result, convert back to 16bit float, and copy to/overwrite the static GPU buffer
+void Player::ResolveStatic()
+{
+   while (m_staticStagingCount > 0) // the last passes
+      ReadbackStaticPass(true);
+   WaitStaticAccumulate();
+
+   D3DLOCKED_RECT locked;
+   CHECKD3D(m_staticReadback->LockRect(&locked, NULL, D3DLOCK_DISCARD));
+
+   StaticNormalizeJob job;
+   job.accum = &m_staticAccum;
+   job.dest = (unsigned short*)locked.pBits;
+   job.destPitch = locked.Pitch / 2;
+   ParallelFor(StaticNormalize, &job, (unsigned int)(m_staticAccum.m_sum.size() / m_staticAccum.m_rowLength), GetNumCPUCores());
+
+   m_staticReadback->UnlockRect();
+
+   CHECKD3D(m_pin3d.m_pd3dPrimaryDevice->GetCoreDevice()->UpdateSurface(m_staticReadback, NULL, m_pin3d.m_pddsStatic, NULL));
+}
+
+void Player::FreeStaticAccumulation()
+{
+   WaitStaticAccumulate();
+   SAFE_RELEASE(m_staticReadback);
+   for (unsigned int i = 0; i < STATIC_STAGING_COUNT; ++i)
    {
-      m_isRenderingStatic = false;
-      m_pin3d.m_pd3dPrimaryDevice->SetTextureFilter(0, TEXTURE_MODE_TRILINEAR);
-      m_pin3d.m_pd3dPrimaryDevice->SetTextureFilter(4, TEXTURE_MODE_TRILINEAR);
+      SAFE_RELEASE(m_staticStaging[i]);
+      SAFE_RELEASE(m_staticStagingFence[i]);
    }
+   m_staticStagingCount = 0;
+   std::vector<float>().swap(m_staticAccum.m_sum);
+   m_staticRefineIter = -1;
+}
 
-   // now normalize oversampled result in pdestStatic, convert back to 16bit float, and copy to/overwrite the static GPU buffer
-   if (!cameraMode)
+// on-disk cache of the final static buffer, one file per table and view setup
+#define STATIC_CACHE_VERSION 2
+
+struct StaticCacheHeader
+{
+   char m_magic[4];
+   unsigned int m_version;
+   unsigned long long m_key;
+   unsigned int m_rowLength; // in halfs
+   unsigned int m_height;
+   unsigned int m_compressedSize;
+};
+
+unsigned long long Player::StaticCacheKey()
+{
+   const unsigned int height = (unsigned int)(m_staticAccum.m_sum.size() / m_staticAccum.m_rowLength);
+
+   // the unjittered pass covers table, camera, resolution, day/night, etc.
+   XXH64Stream hash;
+   for (unsigned int y = 0; y < height; ++y)
+      hash.Update(m_staticAccum.m_src + y*m_staticAccum.m_srcPitch, m_staticAccum.m_rowLength * sizeof(unsigned short));
+
+   // plus everything else that changes the oversampling and the static AO
+   const bool staticAO = UseStaticAO();
+   const int settings[] = { STATIC_CACHE_VERSION, STATIC_PRERENDER_ITERATIONS, (int)m_staticAccum.m_rowLength, (int)height,
+                            m_AA, m_ptable->m_useAA, staticAO, m_width, m_height };
+   hash.Update(settings, sizeof(settings));
+
+   // the offsets of the jittered passes, which are not in the image
+   for (int iter = 1; iter < STATIC_PRERENDER_ITERATIONS; ++iter)
+   {
+      float jitter[2];
+      StaticPassJitter(iter, jitter[0], jitter[1]);
+      hash.Update(jitter, sizeof(jitter));
+   }
+
+   if (staticAO)
+      hash.Update(&m_ptable->m_AOScale, sizeof(m_ptable->m_AOScale));
+
+   char szName[64];
+   XXH64Stream namehash;
+   namehash.Update(m_ptable->m_szFileName, strlen(m_ptable->m_szFileName));
+   namehash.Update(&m_ptable->m_BG_current_set, sizeof(m_ptable->m_BG_current_set));
+   namehash.Update(settings + 2, 2 * sizeof(int));
+   sprintf_s(szName, "%016llX.static", namehash.Digest());
+   // the VP directory is often not writable, so the files go to the local application data of the user
+   char szPath[MAX_PATH];
+   if (SHGetFolderPath(NULL, CSIDL_LOCAL_APPDATA, NULL, SHGFP_TYPE_CURRENT, szPath) == S_OK)
+      m_staticCache.m_dir = string(szPath) + "\\Visual Pinball\\StaticCache";
+   else
+      m_staticCache.m_dir = string(g_pvp->m_szMyPath) + "Cache";
+   m_staticCache.m_filename = m_staticCache.m_dir + "\\" + szName;
+
+   return hash.Digest();
+}
+
+bool Player::LoadStaticCache()
+{
+   const unsigned int height = (unsigned int)(m_staticAccum.m_sum.size() / m_staticAccum.m_rowLength);
+
+   FILE *f;
+   if (fopen_s(&f, m_staticCache.m_filename.c_str(), "rb") != 0)
+      return false;
+
+   StaticCacheHeader header;
+   std::vector<BYTE> compressed;
+   bool ok = (fread(&header, sizeof(header), 1, f) == 1) && (memcmp(header.m_magic, "VPSC", 4) == 0) && (header.m_version == STATIC_CACHE_VERSION)
+          && (header.m_key == m_staticCache.m_key) && (header.m_rowLength == m_staticAccum.m_rowLength) && (header.m_height == height);
+   if (ok)
    {
+      compressed.resize(header.m_compressedSize);
+      ok = (fread(compressed.data(), header.m_compressedSize, 1, f) == 1);
+   }
+   fclose(f);
+   if (!ok)
+      return false;
+
+   // stored with low and high bytes of the halfs separated, which deflates a lot better
+   std::vector<BYTE> shuffled(m_staticAccum.m_rowLength*height * 2);
+   mz_ulong len = (mz_ulong)shuffled.size();
+   if (uncompress(shuffled.data(), &len, compressed.data(), header.m_compressedSize) != Z_OK || len != shuffled.size())
+      return false;
+
+   WaitStaticAccumulate();
+
    D3DLOCKED_RECT locked;
-   CHECKD3D(offscreenSurface->LockRect(&locked, &rectStatic, D3DLOCK_DISCARD));
+   CHECKD3D(m_staticReadback->LockRect(&locked, NULL, D3DLOCK_DISCARD));
+   const BYTE * const plo = shuffled.data();
+   const BYTE * const phi = plo + shuffled.size() / 2;
+   for (unsigned int y = 0; y < height; ++y)
+   {
+      unsigned short * const pdest = (unsigned short*)((BYTE*)locked.pBits + y*locked.Pitch);
+      const unsigned int ofs = y*m_staticAccum.m_rowLength;
+      for (unsigned int x = 0; x < m_staticAccum.m_rowLength; ++x)
+         pdest[x] = (unsigned short)(plo[ofs + x] | (phi[ofs + x] << 8));
+   }
+   m_staticReadback->UnlockRect();
+
+   CHECKD3D(m_pin3d.m_pd3dPrimaryDevice->GetCoreDevice()->UpdateSurface(m_staticReadback, NULL, m_pin3d.m_pddsStatic, NULL));
+
+   return true;
+}
+
+struct StaticCacheFile
+{
+   FILETIME m_time;
+   unsigned long long m_size;
+   string m_filename;
+};
+
+static bool StaticCacheFileOlder(const StaticCacheFile &a, const StaticCacheFile &b)
+{
+   return CompareFileTime(&a.m_time, &b.m_time) < 0;
+}
 
-   unsigned short * __restrict const psrc = (unsigned short*)locked.pBits;
-   for (unsigned int y = 0; y < descStatic.Height; ++y)
+// deletes the oldest cache files until all together fit into m_maxSize (never the newest one, which was just written)
+static void StaticCacheEvict(const StaticCache * const cache)
+{
+   std::vector<StaticCacheFile> files;
+   unsigned long long size = 0;
+
+   WIN32_FIND_DATA fd;
+   const HANDLE h = FindFirstFile((cache->m_dir + "\\*.static").c_str(), &fd);
+   if (h == INVALID_HANDLE_VALUE)
+      return;
+   do
    {
-      unsigned int ofs0 = y*descStatic.Width*3;
-      unsigned int ofs1 = y*locked.Pitch/2;
-      if(descStatic.Format == D3DFMT_A16B16G16R16F)
-      {
-      for (unsigned int x = 0; x < descStatic.Width; ++x,ofs0+=3,ofs1+=4)
-      {
-         psrc[ofs1  ] = float2half(pdestStatic[ofs0  ]*(float)(1.0/STATIC_PRERENDER_ITERATIONS));
-         psrc[ofs1+1] = float2half(pdestStatic[ofs0+1]*(float)(1.0/STATIC_PRERENDER_ITERATIONS));
-         psrc[ofs1+2] = float2half(pdestStatic[ofs0+2]*(float)(1.0/STATIC_PRERENDER_ITERATIONS));
-      }
-      }
-      else if(descStatic.Format == D3DFMT_R16F)
-      {
-      for (unsigned int x = 0; x < descStatic.Width; ++x,++ofs0,++ofs1)
-         psrc[ofs1] = float2half(pdestStatic[ofs0]*(float)(1.0/STATIC_PRERENDER_ITERATIONS));
-      }
-      else if(descStatic.Format == D3DFMT_G16R16F)
-      {
-      for (unsigned int x = 0; x < descStatic.Width; ++x,ofs0+=2,ofs1+=2)
-      {
-         psrc[ofs1  ] = float2half(pdestStatic[ofs0  ]*(float)(1.0/STATIC_PRERENDER_ITERATIONS));
-         psrc[ofs1+1] = float2half(pdestStatic[ofs0+1]*(float)(1.0/STATIC_PRERENDER_ITERATIONS));
-      }
-      }
+      StaticCacheFile file;
+      file.m_time = fd.ftLastWriteTime;
+      file.m_size = ((unsigned long long)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
+      file.m_filename = cache->m_dir + "\\" + fd.cFileName;
+      files.push_back(file);
+      size += file.m_size;
+   } while (FindNextFile(h, &fd));
+   FindClose(h);
+
+   if (size <= cache->m_maxSize)
+      return;
+
+   std::sort(files.begin(), files.end(), StaticCacheFileOlder);
+   for (size_t i = 0; i + 1 < files.size() && size > cache->m_maxSize; ++i)
+   {
+      if (DeleteFile(files[i].m_filename.c_str()))
+         size -= files[i].m_size;
+      else
+         slintf("Static cache: cannot delete %s (error %u)\n", files[i].m_filename.c_str(), GetLastError());
+   }
+}
+
+static void StaticCacheWrite(void *param, const unsigned int begin, const unsigned int end)
+{
+   const StaticCache * const cache = (StaticCache*)param;
+
+   const size_t count = cache->m_data.size();
+   std::vector<BYTE> shuffled(count * 2);
+   for (size_t i = 0; i < count; ++i)
+   {
+      shuffled[i] = (BYTE)cache->m_data[i];
+      shuffled[count + i] = (BYTE)(cache->m_data[i] >> 8);
+   }
+
+   mz_ulong clen = compressBound((mz_ulong)shuffled.size());
+   std::vector<BYTE> compressed(clen);
+   if (compress2(compressed.data(), &clen, shuffled.data(), (mz_ulong)shuffled.size(), MZ_DEFAULT_LEVEL) != Z_OK)
+   {
+      slintf("Static cache: cannot compress %s\n", cache->m_filename.c_str());
+      return;
    }
 
-   offscreenSurface->UnlockRect();
+   StaticCacheHeader header;
+   memcpy(header.m_magic, "VPSC", 4);
+   header.m_version = STATIC_CACHE_VERSION;
+   header.m_key = cache->m_key;
+   header.m_rowLength = cache->m_rowLength;
+   header.m_height = cache->m_height;
+   header.m_compressedSize = (unsigned int)clen;
 
-   CHECKD3D(m_pin3d.m_pd3dPrimaryDevice->GetCoreDevice()->UpdateSurface(offscreenSurface, NULL, m_pin3d.m_pddsStatic, NULL));
+   const int err = SHCreateDirectoryEx(NULL, cache->m_dir.c_str(), NULL);
+   if (err != ERROR_SUCCESS && err != ERROR_ALREADY_EXISTS && err != ERROR_FILE_EXISTS)
+   {
+      slintf("Static cache: cannot create %s (error %d)\n", cache->m_dir.c_str(), err);
+      return;
    }
 
-   delete [] pdestStatic;
-   SAFE_RELEASE(offscreenSurface);
+   FILE *f;
+   const errno_t ferr = fopen_s(&f, cache->m_filename.c_str(), "wb");
+   if (ferr != 0)
+   {
+      slintf("Static cache: cannot write %s (errno %d)\n", cache->m_filename.c_str(), ferr);
+      return;
+   }
+   const bool ok = (fwrite(&header, sizeof(header), 1, f) == 1) && (fwrite(compressed.data(), clen, 1, f) == 1);
+   const bool closed = (fclose(f) == 0);
+   if (!ok || !closed)
+   {
+      slintf("Static cache: cannot write %s (disk full?)\n", cache->m_filename.c_str());
+      DeleteFile(cache->m_filename.c_str());
+      return;
+   }
 
-   // Now finalize static buffer with non-dynamic AO
+   StaticCacheEvict(cache);
+}
 
-   // Dynamic AO disabled? -> Pre-Render Static AO
+// reads back the final static buffer and writes it to the cache in the background
+void Player::SaveStaticCache()
+{
+   m_staticCacheJob.Wait();
+
+   WaitStaticAccumulate();
+
+   CHECKD3D(m_pin3d.m_pd3dPrimaryDevice->GetCoreDevice()->GetRenderTargetData(m_pin3d.m_pddsStatic, m_staticReadback));
+
+   m_staticCache.m_rowLength = m_staticAccum.m_rowLength;
+   m_staticCache.m_height = (unsigned int)(m_staticAccum.m_sum.size() / m_staticAccum.m_rowLength);
+   m_staticCache.m_data.resize(m_staticCache.m_rowLength*m_staticCache.m_height);
+
+   D3DLOCKED_RECT locked;
+   CHECKD3D(m_staticReadback->LockRect(&locked, NULL, D3DLOCK_READONLY));
+   for (unsigned int y = 0; y < m_staticCache.m_height; ++y)
+      memcpy(m_staticCache.m_data.data() + y*m_staticCache.m_rowLength, (BYTE*)locked.pBits + y*locked.Pitch, m_staticCache.m_rowLength * sizeof(unsigned short));
+   m_staticReadback->UnlockRect();
+
+   m_staticCacheJob.Start(StaticCacheWrite, &m_staticCache, 1, 1);
+}
+
+// progressive static prerender: render one more jittered pass per frame (before the frame itself, where back and z buffer are free to use),
+// once all are rendered, wait (over the next frames) until all are read back, then resolve and update the static buffer once
+void Player::RefineStatic()
+{
+   if (m_staticRefineIter < 0)
+      return;
+
+   if (m_staticRefineIter == 0)
+   {
+      ReadbackStaticPass(false);
+      if (m_staticStagingCount > 0)
+         return;
+
+      ResolveStatic();
+      RenderStaticAO();
+      if (m_staticCacheEnabled)
+         SaveStaticCache();
+      FreeStaticAccumulation();
+      return;
+   }
+
+   m_isRenderingStatic = true;
+   m_pin3d.m_pd3dPrimaryDevice->SetTextureFilter(0, TEXTURE_MODE_TRILINEAR);
+   m_pin3d.m_pd3dPrimaryDevice->SetTextureFilter(4, TEXTURE_MODE_TRILINEAR);
+
+   RenderStaticJitteredPass(m_staticRefineIter);
+
+   m_isRenderingStatic = false;
+   m_pin3d.m_pd3dPrimaryDevice->SetTextureFilter(0, TEXTURE_MODE_TRILINEAR);
+   m_pin3d.m_pd3dPrimaryDevice->SetTextureFilter(4, TEXTURE_MODE_TRILINEAR);
+   m_pin3d.InitLayout(m_ptable->m_BG_enable_FSS);
+
+   m_staticRefineIter--;
+}
+
+// Dynamic AO disabled? -> Pre-Render Static AO
+bool Player::UseStaticAO() const
+{
    const bool useAO = ((m_dynamicAO && (m_ptable->m_useAO == -1)) || (m_ptable->m_useAO == 1));
-   if (!m_disableAO && !useAO && m_pin3d.m_pd3dPrimaryDevice->DepthBufferReadBackAvailable() && (m_ptable->m_AOScale > 0.f))
+   return !m_disableAO && !useAO && m_pin3d.m_pd3dPrimaryDevice->DepthBufferReadBackAvailable() && (m_ptable->m_AOScale > 0.f);
+}
+
+void Player::RenderStaticAO()
+{
+   if (UseStaticAO())
    {
       const bool useAA = (m_AA && (m_ptable->m_useAA == -1)) || (m_ptable->m_useAA == 1);
 
@@ -2374,8 +3063,7 @@ Ball *Player::CreateBall(const float x, const float y, const float z, const floa
 
    pball->CalcHitBBox();
 
-   m_vho_dynamic.push_back(pball);
-   m_hitoctree_dynamic.FillFromVector(m_vho_dynamic);
+   m_ballSweepAndPrune.AddBall(pball);
 
    if (!m_pactiveballDebug)
       m_pactiveballDebug = pball;
@@ -2418,9 +3106,7 @@ void Player::DestroyBall(Ball *pball)
 
    RemoveFromVectorSingle(m_vball, pball);
    RemoveFromVectorSingle<MoverObject*>(m_vmover, &pball->m_ballMover);
-   RemoveFromVectorSingle<HitObject*>(m_vho_dynamic, pball);
-
-   m_hitoctree_dynamic.FillFromVector(m_vho_dynamic);
+   m_ballSweepAndPrune.RemoveBall(pball);
 
    m_vballDelete.push_back(pball);
 
@@ -3122,14 +3808,16 @@ void Player::SetGravity(float slopeDeg, float strength)
 
 void Player::PhysicsSimulateCycle(float dtime) // move physics forward to this time
 {
+   PROFILE_FUNCTION();
+
    float hittime;
    int StaticCnts = STATICCNTS;    // maximum number of static counts
 
-   // it's okay to have this code outside of the inner loop, as the ball hitrects already include the maximum distance they can travel in that timespan
-   m_hitoctree_dynamic.Update();
-
    while (dtime > 0.f)
    {
+      // cheap as the balls are nearly sorted already, so keep the ball-ball broadphase exact on each iteration
+      m_ballSweepAndPrune.Update();
+
       // first find hits, if any +++++++++++++++++++++ 
 #ifdef DEBUGPHYSICS
       c_timesearch++;
@@ -3168,13 +3856,13 @@ void Player::PhysicsSimulateCycle(float dtime) // move physics forward to this t
 
             if (rand_mt_01() < 0.5f) // swap order of dynamic and static obj checks randomly
             {
-               m_hitoctree_dynamic.HitTestBall(pball, pball->m_coll);  // dynamic objects
+               m_ballSweepAndPrune.HitTestBall(pball, pball->m_coll);  // other balls
                m_hitoctree.HitTestBall(pball, pball->m_coll);  // find the hit objects and hit times
             }
             else
             {
                m_hitoctree.HitTestBall(pball, pball->m_coll);  // find the hit objects and hit times
-               m_hitoctree_dynamic.HitTestBall(pball, pball->m_coll);  // dynamic objects
+               m_ballSweepAndPrune.HitTestBall(pball, pball->m_coll);  // other balls
             }
 
             const float htz = pball->m_coll.m_hittime; // this ball's hit time
@@ -3341,6 +4029,8 @@ void Player::PhysicsSimulateCycle(float dtime) // move physics forward to this t
 
 void Player::UpdatePhysics()
 {
+   PROFILE_FUNCTION();
+
    U64 initial_time_usec = usec();
 
    // DJRobX's crazy latency-reduction code
@@ -3403,6 +4093,10 @@ void Player::UpdatePhysics()
       if ((m_time_msec - m_lastfpstime) > 1000)
       {
          m_fps = (float)((double)m_cframes * 1000.0 / (m_time_msec - m_lastfpstime));
+         m_dmdFps = (float)((double)m_dmdFrames * 1000.0 / (m_time_msec - m_lastfpstime));
+         m_dmdSkippedFps = (float)((double)m_dmdFramesSkipped * 1000.0 / (m_time_msec - m_lastfpstime));
+         m_dmdFrames = 0;
+         m_dmdFramesSkipped = 0;
          m_lastfpstime = m_time_msec;
          m_fpsAvg += m_fps;
          m_fpsCount++;
@@ -3518,6 +4212,7 @@ void Player::UpdatePhysics()
 
       if(m_script_period <= 1000*MAX_TIMERS_MSEC_OVERALL) // if overall script time per frame exceeded, skip
       {
+         PROFILE_ZONE("Timers");
          const unsigned int p_timeCur = (unsigned int)((m_curPhysicsFrameTime - m_StartTime_usec) / 1000); // milliseconds
 
          for (size_t i = 0; i < m_vht.size(); i++)
@@ -3810,6 +4505,7 @@ void Player::DrawBulbLightBuffer()
 void Player::RenderDynamics()
 {
    TRACE_FUNCTION();
+   PROFILE_FUNCTION();
 
    unsigned int reflection_path = 0;
    if (!cameraMode)
@@ -3884,17 +4580,13 @@ void Player::RenderDynamics()
    if (ProfilingMode() != 2) // normal rendering path for standard gameplay
    {
 #endif
+      // Draw non-transparent objects, then the non-transparent DMD's
+      for (size_t i = 0; i < m_opaqueQueue.size(); ++i)
+      {
+         m_dmdstate = m_opaqueQueue.IsDMD(i) ? 2 : 0;
+         m_opaqueQueue[i]->RenderDynamic();
+      }
       m_dmdstate = 0;
-      // Draw non-transparent objects. No DMD's
-      for (size_t i = 0; i < m_vHitNonTrans.size(); ++i)
-        if(!m_vHitNonTrans[i]->IsDMD())
-          m_vHitNonTrans[i]->RenderDynamic();
-
-      m_dmdstate = 2;
-      // Draw non-transparent DMD's
-      for (size_t i = 0; i < m_vHitNonTrans.size(); ++i)
-        if(m_vHitNonTrans[i]->IsDMD())
-          m_vHitNonTrans[i]->RenderDynamic();
 
       DrawBalls();
 
@@ -3910,17 +4602,12 @@ void Player::RenderDynamics()
       if (ProfilingMode() == 1)
          m_pin3d.m_gpu_profiler.Timestamp(GTS_LightBuffer);
 #endif
-      m_dmdstate = 0;
-      // Draw transparent objects. No DMD's
-      for (size_t i = 0; i < m_vHitTrans.size(); ++i)
-        if(!m_vHitTrans[i]->IsDMD())
-          m_vHitTrans[i]->RenderDynamic();
-
-      m_dmdstate = 1;
-      // Draw only transparent DMD's
-      for (size_t i = 0; i < m_vHitNonTrans.size(); ++i) // NonTrans is correct as DMDs are always sorted in there
-        if(m_vHitNonTrans[i]->IsDMD())
-          m_vHitNonTrans[i]->RenderDynamic();
+      // Draw transparent objects, then the transparent DMD's (taken from m_vHitNonTrans, as DMDs are always sorted in there)
+      for (size_t i = 0; i < m_transparentQueue.size(); ++i)
+      {
+         m_dmdstate = m_transparentQueue.IsDMD(i) ? 1 : 0;
+         m_transparentQueue[i]->RenderDynamic();
+      }
 
 #ifdef FPS
       if (ProfilingMode() == 1)
@@ -4313,15 +5000,20 @@ void Player::UpdateHUD()
 		DebugPrint(10, 70, szFoo, len);
 
 		// performance counters
-		len = sprintf_s(szFoo, "Draw calls: %u (%u Locks)", m_pin3d.m_pd3dPrimaryDevice->Perf_GetNumDrawCalls(), m_pin3d.m_pd3dPrimaryDevice->Perf_GetNumLockCalls());
+		const RenderDevice * const pd3dDevice = m_pin3d.m_pd3dPrimaryDevice;
+		len = sprintf_s(szFoo, "Draw calls: %u (%u Locks)", pd3dDevice->Perf_GetNumDrawCalls(), pd3dDevice->Perf_GetNumLockCalls());
 		DebugPrint(10, 95, szFoo, len);
-		len = sprintf_s(szFoo, "State changes: %u", m_pin3d.m_pd3dPrimaryDevice->Perf_GetNumStateChanges());
+		len = sprintf_s(szFoo, "State changes: %u (%u filtered)", pd3dDevice->Perf_GetNumStateChanges(), pd3dDevice->Perf_GetNumRedundantStateChanges());
 		DebugPrint(10, 115, szFoo, len);
-		len = sprintf_s(szFoo, "Texture changes: %u (%u Uploads)", m_pin3d.m_pd3dPrimaryDevice->Perf_GetNumTextureChanges(), m_pin3d.m_pd3dPrimaryDevice->Perf_GetNumTextureUploads());
+		len = sprintf_s(szFoo, "Texture changes: %u (%u filtered, %u Uploads)", pd3dDevice->Perf_GetNumTextureChanges(), pd3dDevice->Perf_GetNumRedundantTextureChanges(), pd3dDevice->Perf_GetNumTextureUploads());
 		DebugPrint(10, 135, szFoo, len);
-		len = sprintf_s(szFoo, "Parameter changes: %u (%u Material ID changes)", m_pin3d.m_pd3dPrimaryDevice->Perf_GetNumParameterChanges(), material_flips);
+		len = sprintf_s(szFoo, "Parameter changes: %u (%u filtered, %u Material ID changes)  Techniques: %u (%u filtered)", pd3dDevice->Perf_GetNumParameterChanges(), pd3dDevice->Perf_GetNumRedundantParameterChanges(), material_flips,
+			pd3dDevice->Perf_GetNumTechniqueChanges(), pd3dDevice->Perf_GetNumRedundantTechniqueChanges());
 		DebugPrint(10, 155, szFoo, len);
-		len = sprintf_s(szFoo, "Objects: %u Transparent, %u Solid", (unsigned int)m_vHitTrans.size(), (unsigned int)m_vHitNonTrans.size());
+		if (m_texdmd)
+			len = sprintf_s(szFoo, "Objects: %u Transparent, %u Solid  DMD: %.1f frames/s (%.1f unchanged)", (unsigned int)m_vHitTrans.size(), (unsigned int)m_vHitNonTrans.size(), m_dmdFps, m_dmdSkippedFps);
+		else
+			len = sprintf_s(szFoo, "Objects: %u Transparent, %u Solid", (unsigned int)m_vHitTrans.size(), (unsigned int)m_vHitNonTrans.size());
 		DebugPrint(10, 175, szFoo, len);
 
 #ifdef DEBUGPHYSICS
@@ -4343,6 +5035,10 @@ void Player::UpdateHUD()
 		len = sprintf_s(szFoo, "kDObjects: %5u kD:%5u QuadObjects: %5u Quadtree:%5u Traversed:%5u Tested:%5u DeepTested:%5u",
 			c_kDObjects, c_kDNextlevels, c_quadObjects, c_quadNextlevels, c_traversed, c_tested, c_deepTested);
 		DebugPrint(10, 240, szFoo, len);
+
+		len = sprintf_s(szFoo, "Skipped Elements: %5u Skipped HitTests: %5u",
+			c_groupSkipped, c_groupSkippedTests);
+		DebugPrint(10, 280, szFoo, len);
 #endif
 		len = sprintf_s(szFoo, "Left Flipper keypress to rotate: %.1f ms (%d f) to eos: %.1f ms (%d f)",
 			(INT64)(m_pininput.m_leftkey_down_usec_rotate_to_end - m_pininput.m_leftkey_down_usec) < 0 ? int_as_float(0x7FC00000) : (double)(m_pininput.m_leftkey_down_usec_rotate_to_end - m_pininput.m_leftkey_down_usec) / 1000.,
@@ -4350,6 +5046,12 @@ void Player::UpdateHUD()
 			(INT64)(m_pininput.m_leftkey_down_usec_EOS - m_pininput.m_leftkey_down_usec) < 0 ? int_as_float(0x7FC00000) : (double)(m_pininput.m_leftkey_down_usec_EOS - m_pininput.m_leftkey_down_usec) / 1000.,
 			(int)(m_pininput.m_leftkey_down_frame_EOS - m_pininput.m_leftkey_down_frame) < 0 ? -1 : (int)(m_pininput.m_leftkey_down_frame_EOS - m_pininput.m_leftkey_down_frame));
 		DebugPrint(10, 260, szFoo, len);
+
+#ifndef DEBUGPHYSICS // line is used by the physics counters then
+		len = sprintf_s(szFoo, "Sound voices: %u (max %d)  steals: %u  new: %u in %.1f us",
+			m_lastSoundStats.voices, m_maxSoundVoices, m_lastSoundStats.steals, m_lastSoundStats.allocs, (double)m_lastSoundStats.allocUsec);
+		DebugPrint(10, 280, szFoo, len);
+#endif
 	}
 
     // Draw performance readout - at end of CPU frame, so hopefully the previous frame
@@ -4561,8 +5263,11 @@ void Player::PrepareVideoBuffersNormal()
 
 void Player::FlipVideoBuffers(const bool vsync)
 {
+   PROFILE_FUNCTION();
+
    // display frame
    m_pin3d.Flip(vsync);
+   m_flipperLatency.Flipped((unsigned int)m_overall_frames);
 
    // switch to texture output buffer again
    m_pin3d.m_pd3dPrimaryDevice->FBShader->SetTexture("Texture0", (D3DTexture*)NULL);
@@ -4918,6 +5623,8 @@ void Player::UpdateCameraModeDisplay()
 
 void Player::Render()
 {
+   PROFILE_FUNCTION();
+
    U64 timeforframe = usec();
 
    m_pininput.ProcessKeys(/*sim_msec,*/ -(int)(timeforframe / 1000)); // trigger key events mainly for VPM<->VP rountrip
@@ -4953,10 +5660,14 @@ void Player::Render()
    c_traversed = 0;
    c_tested = 0;
    c_deepTested = 0;
+   c_groupSkipped = 0;
+   c_groupSkippedTests = 0;
 #endif
 
    m_LastKnownGoodCounter++;
 
+   RefineStatic();
+
    m_pin3d.m_pd3dPrimaryDevice->m_stats_drawn_triangles = 0;
 
    // copy static buffers to back buffer and z buffer
@@ -4971,8 +5682,11 @@ void Player::Render()
    m_overall_frames++;
 
    // Process all AnimObjects (currently only DispReel, LightSeq and Slingshot)
-   for (size_t l = 0; l < m_vanimate.size(); ++l)
-      m_vanimate[l]->Animate();
+   {
+      PROFILE_ZONE("Animate");
+      for (size_t l = 0; l < m_vanimate.size(); ++l)
+         m_vanimate[l]->Animate();
+   }
 
 #ifdef FPS
    if (ProfilingMode() == 1)
@@ -4983,6 +5697,7 @@ void Player::Render()
       m_pin3d.m_pd3dPrimaryDevice->BeginScene();
       RenderDynamics();
       m_pin3d.m_pd3dPrimaryDevice->EndScene();
+      m_flipperLatency.Rendered();
    }
 
    m_pininput.ProcessKeys(/*sim_msec,*/ -(int)(timeforframe / 1000)); // trigger key events mainly for VPM<->VP rountrip
@@ -5023,6 +5738,15 @@ void Player::Render()
    if (ProfilingMode() != 0)
       m_pin3d.m_gpu_profiler.EndFrame();
 #endif
+#ifdef ENABLE_PROFILER
+   // dump the last zones of all threads on frame time spikes (limited, as each trace is some MB)
+   if (m_profilerSpikeUsec > 0 && m_profilerSpikes < 10 && usec() - timeforframe > m_profilerSpikeUsec)
+   {
+      char szTrace[MAX_PATH];
+      sprintf_s(szTrace, "%sTrace_spike%u.json", g_pvp->m_szMyPath, m_profilerSpikes++);
+      Profiler::Export(szTrace);
+   }
+#endif
 #ifndef ACCURATETIMERS
    // do the en/disable changes for the timers that piled up
    for (size_t i = 0; i < m_changed_vht.size(); ++i)
@@ -5042,20 +5766,23 @@ void Player::Render()
    Ball * const old_pactiveball = m_pactiveball;
    m_pactiveball = NULL;  // No ball is the active ball for timers/key events
 
-   for (size_t i=0;i<m_vht.size();i++)
    {
-      HitTimer * const pht = m_vht[i];
-      if ((pht->m_interval >= 0 && pht->m_nextfire <= m_time_msec) || pht->m_interval < 0) 
+      PROFILE_ZONE("Timers");
+      for (size_t i=0;i<m_vht.size();i++)
       {
-         const unsigned int curnextfire = pht->m_nextfire;
-         pht->m_pfe->FireGroupEvent(DISPID_TimerEvents_Timer);
-         // Only add interval if the next fire time hasn't changed since the event was run. 
-         // Handles corner case:
-         //Timer1.Enabled = False
-         //Timer1.Interval = 1000
-         //Timer1.Enabled = True
-         if (curnextfire == pht->m_nextfire)
-            pht->m_nextfire += pht->m_interval;
+         HitTimer * const pht = m_vht[i];
+         if ((pht->m_interval >= 0 && pht->m_nextfire <= m_time_msec) || pht->m_interval < 0) 
+         {
+            const unsigned int curnextfire = pht->m_nextfire;
+            pht->m_pfe->FireGroupEvent(DISPID_TimerEvents_Timer);
+            // Only add interval if the next fire time hasn't changed since the event was run. 
+            // Handles corner case:
+            //Timer1.Enabled = False
+            //Timer1.Interval = 1000
+            //Timer1.Enabled = True
+            if (curnextfire == pht->m_nextfire)
+               pht->m_nextfire += pht->m_interval;
+         }
       }
    }
 
@@ -5075,6 +5802,21 @@ void Player::Render()
       }
    }
 
+   // Refill ring buffers of streamed table sounds
+   for (size_t i = 0; i < m_ptable->m_vsound.size(); i++)
+      if (m_ptable->m_vsound[i]->m_streaming)
+         m_ptable->m_vsound[i]->UpdateStream();
+
+   // Sound voice counters of this frame, for the FPS display
+   m_soundStats.voices = (unsigned int)m_ptable->m_voldsound.size();
+   if (m_psoundmixer)
+   {
+      m_soundStats.voices += m_psoundmixer->GetNumVoices();
+      m_soundStats.steals += m_psoundmixer->ResetSteals();
+   }
+   m_lastSoundStats = m_soundStats;
+   ZeroMemory(&m_soundStats, sizeof(m_soundStats));
+
    for (size_t i = 0; i < m_vballDelete.size(); i++)
    {
       Ball * const pball = m_vballDelete[i];
@@ -5670,7 +6412,7 @@ void Player::DoDebugObjectMenu(int x, int y)
 
    vector<HitObject*> vhoHit;
 
-   m_hitoctree_dynamic.HitTestXRay(&ballT, vhoHit, ballT.m_coll);
+   m_ballSweepAndPrune.HitTestXRay(&ballT, vhoHit, ballT.m_coll);
    m_hitoctree.HitTestXRay(&ballT, vhoHit, ballT.m_coll);
    m_debugoctree.HitTestXRay(&ballT, vhoHit, ballT.m_coll);
 
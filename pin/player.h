@@ -8,6 +8,9 @@
 #define DEFAULT_PLAYER_FS_WIDTH 1920
 #define DEFAULT_PLAYER_FS_REFRESHRATE 60
 
+// staging buffers of the static prerender: one locked while accumulating, the others in flight between GPU copy and readback
+#define STATIC_STAGING_COUNT 3
+
 // NOTE that the following four definitions need to be in sync in their order!
 enum EnumAssignKeys
 {
@@ -246,6 +249,137 @@ struct TimerOnOff
    bool enabled;
 };
 
+// CPU side sum of the static prerender passes
+struct StaticAccumulation
+{
+   std::vector<float> m_sum;     // same channel layout as the (half float) static buffer
+   const unsigned short *m_src;  // pass to add
+   unsigned int m_srcPitch;      // in halfs
+   unsigned int m_rowLength;     // halfs/floats per row
+   unsigned int m_passes;
+};
+
+// final static buffer as stored in the on-disk cache
+struct StaticCache
+{
+   unsigned long long m_key;
+   std::string m_dir;                  // per user, without trailing backslash
+   std::string m_filename;
+   unsigned long long m_maxSize;       // of all files in m_dir, the oldest ones are deleted beyond
+   std::vector<unsigned short> m_data; // rows tightly packed
+   unsigned int m_rowLength;           // in halfs
+   unsigned int m_height;
+};
+
+// draw order of the dynamic elements: one entry per Hitable with a 64bit state/depth key, radix sorted
+class RenderQueue
+{
+public:
+   static const unsigned long long DMD_BIT = 1ull << 63; // DMD's always last, and rendered with a different m_dmdstate
+
+   void Clear() { m_entries.clear(); }
+   void Add(Hitable * const ph, const unsigned long long key)
+   {
+      const Entry e = { key, ph };
+      m_entries.push_back(e);
+   }
+   void Sort(); // ascending by key, stable
+
+   size_t size() const                   { return m_entries.size(); }
+   Hitable* operator[](const size_t i) const { return m_entries[i].m_ph; }
+   bool IsDMD(const size_t i) const      { return (m_entries[i].m_key & DMD_BIT) != 0; }
+
+private:
+   struct Entry
+   {
+      unsigned long long m_key;
+      Hitable *m_ph;
+   };
+
+   std::vector<Entry> m_entries;
+   std::vector<Entry> m_tmp;
+};
+
+// latencies in 100 usec buckets up to 25 ms, everything above goes into the last bucket
+class LatencyHistogram
+{
+public:
+   LatencyHistogram();
+
+   void Add(const U64 latency);
+   U64 Percentile(const double p) const; // upper bound of the bucket holding the given fraction of all samples
+   void Write(FILE * const f, const char * const name) const;
+
+   unsigned int m_count;
+
+private:
+   enum { BUCKET_USEC = 100, NUM_BUCKETS = 251 };
+
+   unsigned int m_buckets[NUM_BUCKETS];
+   U64 m_min, m_max, m_sum;
+};
+
+// Timestamps each flipper key press on its way to the screen (Player/FlipperLatencyLog = 1),
+// all stages relative to the key event being processed, histograms are appended to FlipperLatency.log on exit.
+// Left and right are followed separately, so pressing both (or one right after the other) doesn't drop a press.
+class FlipperLatency
+{
+public:
+   enum Stage
+   {
+      Solenoid, // FlipperMoverObject::SetSolenoidState() called by the script
+      Move,     // first physics step that moved that flipper
+      Render,   // first frame rendered with the moved flipper
+      Flip,     // that frame handed to the driver (Present returned)
+      NumStages
+   };
+
+   enum Key
+   {
+      LeftKey,
+      RightKey,
+      NumKeys
+   };
+
+   FlipperLatency();
+
+   // KeyDown() before the key event is handed to the script, KeyHandled() after it
+   void KeyDown(const Key key, const unsigned int frame);
+   void KeyHandled() { m_handlingKey = NumKeys; }
+   void SolenoidOn(const FlipperMoverObject * const pmover);
+   void Moved(const FlipperMoverObject * const pmover) // called every physics step, so keep it cheap
+   {
+      for (unsigned int i = 0; i < NumKeys; ++i)
+         if (pmover == m_press[i].pmover && m_press[i].stageUsec[Move] == 0)
+            StampMove(m_press[i]);
+   }
+   void Rendered();
+   void Flipped(const unsigned int frame);
+
+   void WriteLog(const char * const filename, const char * const settings) const;
+
+   bool m_enabled;
+
+private:
+   struct Press
+   {
+      bool pending;             // key pressed, not yet on screen
+      U64 keyUsec;
+      unsigned int keyFrame;
+      U64 stageUsec[NumStages]; // 0 = stage not reached yet
+      const FlipperMoverObject *pmover;
+   };
+
+   static void StampMove(Press &press);
+
+   Press m_press[NumKeys];
+   Key m_handlingKey;          // key whose event the script is handling right now, NumKeys if none
+
+   LatencyHistogram m_histograms[NumStages];
+   unsigned int m_frames[4];   // frames from key to flip: 0, 1, 2, more
+   unsigned int m_lost;        // presses that never reached the screen before the next one of that key (e.g. no flipper in the key handler)
+};
+
 class Player
 {
 public:
@@ -266,12 +400,26 @@ public:
    void Shutdown();
 
    void InitStatic(HWND hwndProgress);
+   void RenderStaticPass(const int iter, HWND hwndProgress);
+   void AccumulateStaticPass(RenderTarget * const src);
+   void ReadbackStaticPass(const bool wait);
+   void WaitStaticAccumulate();
+   void ResolveStatic();
+   void RenderStaticAO();
+   bool UseStaticAO() const;
+   void RenderStaticJitteredPass(const int iter);
+   void RefineStatic();
+   void FreeStaticAccumulation();
+   unsigned long long StaticCacheKey();
+   bool LoadStaticCache();
+   void SaveStaticCache();
 
    void UpdatePerFrame();
 
    void UpdatePhysics();
    void Render();
    void RenderDynamics();
+   void BuildRenderQueues();
 
    void DrawBalls();
 
@@ -421,6 +569,20 @@ public:
    int m_SoundVolume;
 
    XAudPlayer *m_pxap;
+   SoundMixer *m_psoundmixer; // software mixer for table sounds, NULL if DirectSound buffers are used
+
+   int m_maxSoundVoices; // table sounds playing at once (0 = unlimited), further PlaySound calls steal the quietest/oldest voice
+   struct SoundVoiceStats
+   {
+      unsigned int voices;          // playing at the end of the frame
+      unsigned int steals;          // voices stopped or not started because of m_maxSoundVoices
+      unsigned int allocs;          // PlaySound calls that needed a new voice
+      unsigned long long allocUsec; // time spent finding/duplicating buffers for them
+   };
+   SoundVoiceStats m_soundStats;     // current frame
+   SoundVoiceStats m_lastSoundStats; // previous frame, shown in the FPS display
+
+   FlipperLatency m_flipperLatency;
 
    int m_lastcursorx, m_lastcursory; // used for the dumb task of seeing if the mouse has really moved when we get a WM_MOUSEMOVE message
 
@@ -473,6 +635,8 @@ public:
    U32 c_traversed;
    U32 c_tested;
    U32 c_deepTested;
+   U32 c_groupSkipped;      // quadtree subtrees skipped as their element is disabled/out of reach
+   U32 c_groupSkippedTests; // hit objects (thus HitTest calls) in these subtrees
 #endif
 
 #ifdef DEBUG_BALL_SPIN
@@ -502,6 +666,12 @@ public:
    int m_dmdx;
    int m_dmdy;
    BaseTexture* m_texdmd;
+   std::vector<DWORD> m_dmdFrame; // last raw DMD frame set by the script, to skip unchanged ones
+   bool m_dmdFrameColored;
+   U32 m_dmdFrames;         // DMD frames set by the script since the last fps update
+   U32 m_dmdFramesSkipped;  // ..of which were unchanged
+   float m_dmdFps;
+   float m_dmdSkippedFps;
 
    unsigned int m_current_renderstage; // currently only used for bulb lights
    unsigned int m_dmdstate; // used to distinguish different flasher/DMD rendering mode states
@@ -519,8 +689,7 @@ private:
    vector<HitObject*> m_vdebugho;
    HitQuadtree m_debugoctree;
 
-   vector<HitObject*> m_vho_dynamic;
-   HitKD m_hitoctree_dynamic; // should be generated from scratch each time something changes
+   BallSweepAndPrune m_ballSweepAndPrune; // ball-ball broadphase
 
    HitPlane m_hitPlayfield; // HitPlanes cannot be part of octree (infinite size)
    HitPlane m_hitTopGlass;
@@ -534,6 +703,8 @@ private:
    std::vector< Hitable* > m_vhitables;
    std::vector< Hitable* > m_vHitNonTrans; // non-transparent hitables
    std::vector< Hitable* > m_vHitTrans;    // transparent hitables
+   RenderQueue m_opaqueQueue;      // m_vHitNonTrans sorted by material/image/depth (front to back), DMD's last
+   RenderQueue m_transparentQueue; // m_vHitTrans sorted back to front, followed by the DMD's of m_vHitNonTrans
 
    int m_curAccel_x[PININ_JOYMXCNT];
    int m_curAccel_y[PININ_JOYMXCNT];
@@ -623,6 +794,27 @@ public:
 
    bool m_isRenderingStatic;
 
+   // accumulation of the jittered static prerender passes (see InitStatic), kept until all passes are done if progressive
+   bool m_progressiveStatic;
+   int m_staticRefineIter;           // next pass to render in the background, 0 when all are rendered (resolved once read back), -1 if done
+   StaticAccumulation m_staticAccum;
+   ParallelJob m_staticAccumJob;     // accumulates the last pass while the next one is rendered
+   RenderTarget *m_staticReadback;   // system memory surface to upload the resolved (or cached) static buffer
+   RenderTarget *m_staticStaging[STATIC_STAGING_COUNT];         // lockable GPU copies of the last passes, used as a ring
+   IDirect3DQuery9 *m_staticStagingFence[STATIC_STAGING_COUNT]; // signaled when the copy into the staging buffer is done
+   unsigned int m_staticStagingHead;  // oldest pass not read back yet
+   unsigned int m_staticStagingCount; // passes copied but not read back yet
+   int m_staticStagingLocked;         // staging buffer locked while accumulating, -1 if none
+
+   bool m_staticCacheEnabled;
+   StaticCache m_staticCache;
+   ParallelJob m_staticCacheJob;     // compresses and writes the cache file
+
+#ifdef ENABLE_PROFILER
+   U64 m_profilerSpikeUsec;          // frames taking longer than this dump the profiler zones (0 = off)
+   unsigned int m_profilerSpikes;
+#endif
+
    bool m_fStereo3DY;
    bool m_fOverwriteBallImages;
    Texture *m_ballImage;
@@ -109,7 +109,7 @@ void Pin3D::TransformVertices(const Vertex3D_NoTex2 * rgv, const WORD * rgi, int
    }
 }
 
-void EnvmapPrecalc(const void* const __restrict envmap, const DWORD env_xres, const DWORD env_yres, void* const __restrict rad_envmap, const DWORD rad_env_xres, const DWORD rad_env_yres, const bool isHDR)
+void EnvmapPrecalc(const void* const __restrict envmap, const DWORD env_xres, const DWORD env_yres, void* const __restrict rad_envmap, const DWORD rad_env_xres, const DWORD rad_env_yres, const BaseTexture::Format format)
 {
    // brute force sampling over hemisphere for each normal direction of the to-be-(ir)radiance-baked environment
    // not the fastest solution, could do a "cosine convolution" over the picture instead (where also just 1024 or x samples could be used per pixel)
@@ -149,7 +149,16 @@ void EnvmapPrecalc(const void* const __restrict envmap, const DWORD env_xres, co
             const float v = acosf(l.z) * (float)(1.0 / M_PI);
 
 	    float r,g,b;
-	    if(isHDR)
+	    if(format == BaseTexture::RGB_FP16)
+	    {
+		unsigned int offs = ((int)(u*(float)env_xres) + (int)(v*(float)env_yres)*env_xres)*4;
+		if(offs >= env_yres*env_xres*4)
+		    offs = 0;
+		r = half2float(((unsigned short*)envmap)[offs]);
+		g = half2float(((unsigned short*)envmap)[offs+1]);
+		b = half2float(((unsigned short*)envmap)[offs+2]);
+	    }
+	    else if(format == BaseTexture::RGB_FP)
 	    {
 		unsigned int offs = ((int)(u*(float)env_xres) + (int)(v*(float)env_yres)*env_xres)*3;
 		if(offs >= env_yres*env_xres*3)
@@ -189,7 +198,15 @@ void EnvmapPrecalc(const void* const __restrict envmap, const DWORD env_xres, co
          sum[1] *= (float)(1.0 / num_samples);
          sum[2] *= (float)(1.0 / num_samples);
 #endif
-	 if(isHDR)
+	 if(format == BaseTexture::RGB_FP16)
+	 {
+            const unsigned int offs = (y*rad_env_xres + x)*4;
+            ((unsigned short*)rad_envmap)[offs  ] = float2half(sum[0]);
+	    ((unsigned short*)rad_envmap)[offs+1] = float2half(sum[1]);
+	    ((unsigned short*)rad_envmap)[offs+2] = float2half(sum[2]);
+	    ((unsigned short*)rad_envmap)[offs+3] = 0x3C00; // 1.0
+	 }
+	 else if(format == BaseTexture::RGB_FP)
 	 {
             const unsigned int offs = (y*rad_env_xres + x)*3;
             ((float*)rad_envmap)[offs  ] = sum[0];
@@ -267,7 +284,7 @@ HRESULT Pin3D::InitPin3D(const HWND hwnd, const bool fullScreen, const int width
    m_envRadianceTexture = new BaseTexture(envTexWidth, envTexHeight, envTex->m_pdsBuffer->m_format);
 
    EnvmapPrecalc(envTex->m_pdsBuffer->data(), envTex->m_pdsBuffer->width(), envTex->m_pdsBuffer->height(),
-                 m_envRadianceTexture->data(), envTexWidth, envTexHeight, envTex->IsHDR());
+                 m_envRadianceTexture->data(), envTexWidth, envTexHeight, envTex->m_pdsBuffer->m_format);
 
    m_pd3dPrimaryDevice->m_texMan.SetDirty(m_envRadianceTexture);
 
@@ -829,12 +829,25 @@ void PinInput::FireKeyEvent(const int dispid, int keycode)
 		 delete g_pplayer->m_pBCTarget;
 		 g_pplayer->m_pBCTarget = NULL;
       }
+      FlipperLatency::Key latencyKey = FlipperLatency::NumKeys;
+      if (dispid == DISPID_GameEvents_KeyDown)
+      {
+         if (keycode == g_pplayer->m_rgKeys[eLeftFlipperKey])
+            latencyKey = FlipperLatency::LeftKey;
+         else if (keycode == g_pplayer->m_rgKeys[eRightFlipperKey])
+            latencyKey = FlipperLatency::RightKey;
+      }
+      if (latencyKey != FlipperLatency::NumKeys)
+         g_pplayer->m_flipperLatency.KeyDown(latencyKey, (unsigned int)g_pplayer->m_overall_frames);
 
       // Mixer volume only
       gMixerKeyDown = (keycode == g_pplayer->m_rgKeys[eVolumeDown] && dispid == DISPID_GameEvents_KeyDown);
       gMixerKeyUp   = (keycode == g_pplayer->m_rgKeys[eVolumeUp]   && dispid == DISPID_GameEvents_KeyDown);
 
       g_pplayer->m_ptable->FireKeyEvent(dispid, keycode);
+
+      if (latencyKey != FlipperLatency::NumKeys)
+         g_pplayer->m_flipperLatency.KeyHandled();
    }
 }
 
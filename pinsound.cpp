@@ -1,15 +1,24 @@
 #include "StdAfx.h"
+#include "inc/miniz.h"
 
 PinSound::PinSound() : PinSoundCopy(this)
 {
    m_pDSBuffer = NULL;
    m_pDS3DBuffer = NULL;
    m_pdata = NULL;
+   m_cdata = 0;
    m_pPinDirectSound = NULL;
    m_iOutputTarget = SNDOUT_TABLE;
    m_iBalance = 0;
    m_iFade = 0;
    m_iVolume = 0;
+   m_streaming = false;
+   m_streamBufferBytes = 0;
+   m_streamReadPos = 0;
+   m_streamWritePos = 0;
+   m_streamSilence = 0;
+   m_streamLooping = false;
+   m_chunkIndex = -1;
 }
 
 PinSound::~PinSound()
@@ -24,10 +33,47 @@ PinSound::~PinSound()
 
 void PinSound::UnInitialize()
 {
+	// the pooled copies share the buffer memory of the original
+	for (size_t i = 0; i < m_freeCopies.size(); i++)
+	{
+		SAFE_RELEASE(m_freeCopies[i]->m_pDS3DBuffer);
+		SAFE_RELEASE(m_freeCopies[i]->m_pDSBuffer);
+		delete m_freeCopies[i];
+	}
+	m_freeCopies.clear();
+
 	SAFE_RELEASE(m_pDS3DBuffer);
 	SAFE_RELEASE(m_pDSBuffer);
 }
 
+#define MAX_FREE_SOUND_COPIES 8
+
+PinSoundCopy *PinSound::GetCopy()
+{
+	if (m_freeCopies.empty())
+		return new PinSoundCopy(this);
+
+	PinSoundCopy * const ppsc = m_freeCopies.back();
+	m_freeCopies.pop_back();
+	return ppsc;
+}
+
+void PinSound::ReleaseCopy(PinSoundCopy * const ppsc)
+{
+	if (ppsc->m_pDSBuffer && m_freeCopies.size() < MAX_FREE_SOUND_COPIES)
+	{
+		// copies can be released mid-play (stolen or stopped), so rewind them for the next Play()
+		ppsc->m_pDSBuffer->Stop();
+		ppsc->m_pDSBuffer->SetCurrentPosition(0);
+		m_freeCopies.push_back(ppsc);
+		return;
+	}
+
+	SAFE_RELEASE(ppsc->m_pDS3DBuffer);
+	SAFE_RELEASE(ppsc->m_pDSBuffer);
+	delete ppsc;
+}
+
 class PinDirectSound *PinSound::GetPinDirectSound()
 {
    if (m_pPinDirectSound)
@@ -47,12 +93,147 @@ void PinSound::ReInitialize()
 	GetPinDirectSound()->CreateDirectFromNative(this);
 }
 
+void PinSound::Pack()
+{
+   if (m_pdata == NULL || m_cdata == 0)
+      return;
+
+   if (ChunkedDeflate(m_pdata, m_cdata, MZ_BEST_SPEED, m_packedData) && m_packedData.size() < (size_t)m_cdata)
+   {
+      delete[] m_pdata;
+      m_pdata = NULL;
+   }
+   else
+      std::vector<unsigned char>().swap(m_packedData);
+}
+
+void PinSound::CopyPCM(char * const dst, const DWORD offset, const DWORD length)
+{
+   if (m_pdata)
+   {
+      memcpy(dst, m_pdata + offset, length);
+      return;
+   }
+
+   DWORD done = 0;
+   while (done < length)
+   {
+      const DWORD pos = offset + done;
+      const int chunk = (int)(pos / CHUNKED_DEFLATE_CHUNK_SIZE);
+      if (chunk != m_chunkIndex)
+      {
+         m_chunk.resize(CHUNKED_DEFLATE_CHUNK_SIZE);
+         size_t size;
+         if (!ChunkedInflateChunk(m_packedData.data(), m_packedData.size(), chunk, m_chunk.data(), size))
+         {
+            memset(dst + done, 0, length - done);
+            m_chunkIndex = -1;
+            return;
+         }
+         m_chunkIndex = chunk;
+      }
+      const DWORD inChunk = pos - (DWORD)chunk * CHUNKED_DEFLATE_CHUNK_SIZE;
+      const DWORD n = min(length - done, (DWORD)CHUNKED_DEFLATE_CHUNK_SIZE - inChunk);
+      memcpy(dst + done, m_chunk.data() + inChunk, n);
+      done += n;
+   }
+}
+
+const char *PinSound::GetPCM(std::vector<char> &tmp)
+{
+   if (m_pdata)
+      return m_pdata;
+
+   tmp.resize(m_cdata);
+   if (m_cdata > 0 && !ChunkedInflate(m_packedData.data(), m_packedData.size(), tmp.data(), m_cdata))
+      memset(tmp.data(), 0, m_cdata);
+   return tmp.data();
+}
+
+void PinSound::FillStream(char * const dst, const DWORD length)
+{
+   DWORD done = 0;
+   while (done < length)
+   {
+      if (m_streamReadPos >= (DWORD)m_cdata)
+      {
+         if (m_streamLooping && m_cdata > 0)
+            m_streamReadPos = 0;
+         else
+         {
+            memset(dst + done, (m_wfx.wBitsPerSample == 8) ? 0x80 : 0, length - done);
+            m_streamSilence += length - done;
+            return;
+         }
+      }
+      const DWORD n = min(length - done, (DWORD)m_cdata - m_streamReadPos);
+      CopyPCM(dst + done, m_streamReadPos, n);
+      m_streamReadPos += n;
+      done += n;
+   }
+}
+
+void PinSound::StartStream(const bool looping)
+{
+   m_streamLooping = looping;
+   m_streamReadPos = 0;
+   m_streamWritePos = 0;
+   m_streamSilence = 0;
+
+   VOID *pbData = NULL;
+   DWORD dwLength;
+   if (FAILED(m_pDSBuffer->Lock(0, m_streamBufferBytes, &pbData, &dwLength, NULL, NULL, 0L)))
+      return;
+   FillStream((char*)pbData, dwLength);
+   m_pDSBuffer->Unlock(pbData, dwLength, NULL, 0);
+   m_pDSBuffer->SetCurrentPosition(0);
+}
+
+void PinSound::UpdateStream()
+{
+   DWORD status;
+   m_pDSBuffer->GetStatus(&status);
+   if (!(status & DSBSTATUS_PLAYING))
+      return;
+
+   // the ring buffer only holds silence anymore, so the sound is done
+   if (m_streamSilence >= m_streamBufferBytes)
+   {
+      m_pDSBuffer->Stop();
+      return;
+   }
+
+   DWORD playPos, writePos;
+   if (FAILED(m_pDSBuffer->GetCurrentPosition(&playPos, &writePos)))
+      return;
+
+   // refill everything that was played since the last update
+   const DWORD length = (playPos + m_streamBufferBytes - m_streamWritePos) % m_streamBufferBytes;
+   if (length == 0)
+      return;
+
+   VOID *pbData = NULL;
+   VOID *pbData2 = NULL;
+   DWORD dwLength;
+   DWORD dwLength2;
+   if (FAILED(m_pDSBuffer->Lock(m_streamWritePos, length, &pbData, &dwLength, &pbData2, &dwLength2, 0L)))
+      return;
+   FillStream((char*)pbData, dwLength);
+   if (pbData2)
+      FillStream((char*)pbData2, dwLength2);
+   m_pDSBuffer->Unlock(pbData, dwLength, pbData2, dwLength2);
+
+   m_streamWritePos = (m_streamWritePos + length) % m_streamBufferBytes;
+}
+
 PinDirectSound::PinDirectSound()
 {
    m_i3DSoundMode = SNDCFG_SND3D2CH;
    m_pDS = NULL;
    m_pWaveSoundRead = NULL;
    m_pDSListener = NULL;
+   m_streamSeconds = 0;
+   m_packSounds = false;
 }
 
 PinDirectSound::~PinDirectSound()
@@ -88,6 +269,9 @@ void PinDirectSound::InitDirectSound(const HWND hwnd, const bool IsBackglass)
    SAFE_RELEASE(m_pDSListener);
    SAFE_RELEASE(m_pDS);
 
+   m_streamSeconds = GetRegIntWithDefault("Player", "SoundStreamSeconds", 0);
+   m_packSounds = !!GetRegIntWithDefault("Player", "PackSounds", 0);
+
    HRESULT hr;
    LPDIRECTSOUNDBUFFER pDSBPrimary = NULL;
 
@@ -320,21 +504,39 @@ HRESULT PinDirectSound::FillBuffer(PinSound * const pps)
    // We dont need the wav file data buffer anymore, so delete it 
    SAFE_VECTOR_DELETE(pbWavData);
 
+   if (m_packSounds)
+      pps->Pack();
+
    return S_OK;
 }
 
 HRESULT PinDirectSound::CreateDirectFromNative(PinSound * const pps)
 {
+   pps->m_streaming = (m_streamSeconds > 0) && (pps->m_wfx.nAvgBytesPerSec > 0) && (pps->m_wfx.nBlockAlign > 0)
+      && ((unsigned long long)m_streamSeconds * pps->m_wfx.nAvgBytesPerSec < (unsigned long long)pps->m_cdata);
+
    DSBUFFERDESC dsbd;
    ZeroMemory(&dsbd, sizeof(DSBUFFERDESC));
    dsbd.dwSize = sizeof(DSBUFFERDESC);
-   dsbd.dwFlags = DSBCAPS_STATIC | DSBCAPS_CTRLVOLUME | DSBCAPS_CTRLFREQUENCY;
+   dsbd.dwFlags = DSBCAPS_CTRLVOLUME | DSBCAPS_CTRLFREQUENCY;
+   if (pps->m_streaming)
+      dsbd.dwFlags |= DSBCAPS_GETCURRENTPOSITION2;
+   else
+      dsbd.dwFlags |= DSBCAPS_STATIC;
    if (m_i3DSoundMode)
 	   dsbd.dwFlags |= DSBCAPS_CTRL3D;
    else
 	   dsbd.dwFlags |= DSBCAPS_CTRLPAN;
 
-   dsbd.dwBufferBytes = pps->m_cdata;
+   if (pps->m_streaming)
+   {
+      // 2 seconds of ring buffer, refilled each frame by the player
+      pps->m_streamBufferBytes = pps->m_wfx.nAvgBytesPerSec * 2;
+      pps->m_streamBufferBytes -= pps->m_streamBufferBytes % pps->m_wfx.nBlockAlign;
+      dsbd.dwBufferBytes = pps->m_streamBufferBytes;
+   }
+   else
+      dsbd.dwBufferBytes = pps->m_cdata;
    dsbd.lpwfxFormat = &pps->m_wfx;
 
    if (m_pDS == NULL)
@@ -352,31 +554,43 @@ HRESULT PinDirectSound::CreateDirectFromNative(PinSound * const pps)
    }
 
    pps->m_pPinDirectSound = this;
-   VOID*   pbData = NULL;
-   VOID*   pbData2 = NULL;
-   DWORD   dwLength;
-   DWORD   dwLength2;
 
-   // Lock the buffer down
-   if (FAILED(hr = pps->m_pDSBuffer->Lock(0, pps->m_cdata, &pbData, &dwLength,
-      &pbData2, &dwLength2, 0L)))
+   if (pps->m_streaming)
    {
-      ShowError("Could not lock sound buffer for load.");
-      return hr;
+      // prefill with the start of the sound //!! editor preview plays only these first seconds, as nothing refills the buffer there
+      pps->StartStream(false);
+   }
+   else
+   {
+      VOID*   pbData = NULL;
+      VOID*   pbData2 = NULL;
+      DWORD   dwLength;
+      DWORD   dwLength2;
+
+      // Lock the buffer down
+      if (FAILED(hr = pps->m_pDSBuffer->Lock(0, pps->m_cdata, &pbData, &dwLength,
+         &pbData2, &dwLength2, 0L)))
+      {
+         ShowError("Could not lock sound buffer for load.");
+         return hr;
+      }
+
+      // Copy the memory to it.
+      pps->CopyPCM((char*)pbData, 0, pps->m_cdata);
+
+      // Unlock the buffer, we don't need it anymore.
+      pps->m_pDSBuffer->Unlock(pbData, pps->m_cdata, NULL, 0);
+      pbData = NULL;
    }
-
-   // Copy the memory to it.
-   memcpy(pbData, pps->m_pdata, pps->m_cdata);
-
-   // Unlock the buffer, we don't need it anymore.
-   pps->m_pDSBuffer->Unlock(pbData, pps->m_cdata, NULL, 0);
-   pbData = NULL;
 
    if (m_i3DSoundMode)
    {
 	   pps->Get3DBuffer();
    }
 
+   if (m_packSounds)
+      pps->Pack();
+
    return S_OK;
 }
 
@@ -403,12 +617,15 @@ float PinDirectSound::PanTo3D(float input)
 PinSoundCopy::PinSoundCopy(class PinSound *pOriginal)
 {
 	m_ppsOriginal = pOriginal;
+	m_volume = 0.f;
+	m_serial = 0;
 
 	if (this != pOriginal)
 	{
 		m_pDSBuffer = NULL;
 		m_pDS3DBuffer = NULL;
-		pOriginal->GetPinDirectSound()->m_pDS->DuplicateSoundBuffer(pOriginal->m_pDSBuffer, &m_pDSBuffer);
+		if (!pOriginal->m_streaming) // streamed sounds are only played by the original, a copy would share its ring buffer
+			pOriginal->GetPinDirectSound()->m_pDS->DuplicateSoundBuffer(pOriginal->m_pDSBuffer, &m_pDSBuffer);
 		if (m_pDSBuffer && pOriginal->m_pDS3DBuffer != NULL)
 		{
 			Get3DBuffer();
@@ -421,6 +638,7 @@ void PinSoundCopy::Play(const float volume, const float randompitch, const int p
 	const float totalvolume = max(min(volume, 100.0f), 0.0f);
 	const int decibelvolume = (totalvolume == 0.0f) ? DSBVOLUME_MIN : (int)(logf(totalvolume)*(float)(1000.0 / log(10.0)) - 2000.0f);
 	m_pDSBuffer->SetVolume(decibelvolume);
+	m_volume = totalvolume;
 	// Frequency tweaks are relative to original sound.  If the copy failed for some reason, don't alter original
 	if (m_ppsOriginal != this)
 	{
@@ -439,6 +657,8 @@ void PinSoundCopy::Play(const float volume, const float randompitch, const int p
 			m_ppsOriginal->m_pDSBuffer->GetFrequency(&freq);
 			m_pDSBuffer->SetFrequency(freq + pitch);
 		}
+		else // a reused copy may still have the pitch of its last sound
+			m_pDSBuffer->SetFrequency(DSBFREQUENCY_ORIGINAL);
 	}
 	switch (m_ppsOriginal->GetPinDirectSound()->m_i3DSoundMode)
 	{
@@ -456,14 +676,23 @@ void PinSoundCopy::Play(const float volume, const float randompitch, const int p
 		break;
 	case SNDCFG_SND3D2CH:
 	default:
-		if (pan != 0.f)
+		if (pan != 0.f || m_ppsOriginal != this) // a reused copy may still have the pan of its last sound
 			m_pDSBuffer->SetPan((LONG)(pan*DSBPAN_RIGHT));
 		break;
 	}
 
 	DWORD status;
 	m_pDSBuffer->GetStatus(&status);
-	if (!(status & DSBSTATUS_PLAYING))
+	if (m_ppsOriginal->m_streaming)
+	{
+		if (!(status & DSBSTATUS_PLAYING) || restart)
+		{
+			m_pDSBuffer->Stop();
+			m_ppsOriginal->StartStream(!!(flags & DSBPLAY_LOOPING));
+			m_pDSBuffer->Play(0, 0, DSBPLAY_LOOPING); // the ring buffer always loops, UpdateStream() stops it at the end
+		}
+	}
+	else if (!(status & DSBSTATUS_PLAYING))
 		m_pDSBuffer->Play(0, 0, flags);
 	else if (restart)
 		m_pDSBuffer->SetCurrentPosition(0);
@@ -58,6 +58,9 @@ public:
 	LPDIRECTSOUNDBUFFER m_pDSBuffer;
 	LPDIRECTSOUND3DBUFFER m_pDS3DBuffer;
 	class PinSound *m_ppsOriginal;
+
+	float m_volume;          // volume of the last Play(), the quietest voice is stolen first when over budget
+	unsigned int m_serial;   // play order, the oldest voice is stolen first on equal volume
 };
 
 class PinSound : public PinSoundCopy
@@ -72,10 +75,11 @@ public:
    char m_szInternalName[MAXTOKEN];
    char m_szPath[MAX_PATH];
 
-   char *m_pdata; // Copy of the buffer data so we can save it out
+   char *m_pdata; // Copy of the buffer data so we can save it out (NULL if only m_packedData is kept)
    WAVEFORMATEX m_wfx;
 
-   int m_cdata;
+   int m_cdata;   // size of the PCM data
+   std::vector<unsigned char> m_packedData; // ChunkedDeflate of the PCM data, if sounds are kept compressed in memory
    SoundOutTypes m_iOutputTarget;
    int m_iBalance;
    int m_iFade;
@@ -84,6 +88,35 @@ public:
    class PinDirectSound *GetPinDirectSound();
    void UnInitialize();
    void ReInitialize();
+
+   // finished copies are kept for reuse instead of duplicating the buffer again on every PlaySound
+   PinSoundCopy *GetCopy();
+   void ReleaseCopy(PinSoundCopy * const ppsc);
+
+   void Pack();
+   // copies PCM data from m_pdata or, if packed, from the decoded chunks
+   void CopyPCM(char * const dst, const DWORD offset, const DWORD length);
+   // PCM data to save/export, decoded into tmp if packed
+   const char *GetPCM(std::vector<char> &tmp);
+
+   // long sounds are played through a small ring buffer that is refilled while playing, instead of a static buffer holding all PCM data
+   bool m_streaming;
+   DWORD m_streamBufferBytes;
+   DWORD m_streamReadPos;    // next byte of the PCM data to put into the ring buffer
+   DWORD m_streamWritePos;   // next byte of the ring buffer to fill
+   DWORD m_streamSilence;    // bytes of silence written after the end of the sound
+   bool m_streamLooping;
+
+   void StartStream(const bool looping);
+   void UpdateStream();
+
+private:
+   void FillStream(char * const dst, const DWORD length);
+
+   std::vector<char> m_chunk; // last decoded chunk of m_packedData
+   int m_chunkIndex;
+
+   std::vector<PinSoundCopy*> m_freeCopies;
 };
 
 
@@ -108,6 +141,8 @@ public:
    CWaveSoundRead*     m_pWaveSoundRead;
    DWORD               m_dwBufferBytes;
    SoundConfigTypes    m_i3DSoundMode;
+   int                 m_streamSeconds; // sounds longer than this are streamed (0 = never)
+   bool                m_packSounds;    // keep the PCM data of table sounds compressed in memory
 };
 
 #endif // !defined(AFX_PINSOUND_H__61491D0B_9950_480C_B453_911B3A2CDB8E__INCLUDED_)
@@ -778,6 +778,10 @@ STDMETHODIMP ScriptGlobalTable::put_DMDHeight(int pVal)
    return S_OK;
 }
 
+// ScaleFX is compiled with strict float semantics also in /fp:fast builds, so that its output is exact
+// (same for any band split and compiler settings), see ScaleFXTest()
+#pragma float_control(precise, on, push)
+
 static inline float eq_col1(const DWORD AD, const DWORD BD)
 {
     const float A[3] = { (float)(AD & 255) * (float)(1.0/255.),(float)(AD & 65280) * (float)(1.0 / 65280.0),(float)(AD & 16711680) * (float)(1.0 / 16711680.0) };
@@ -841,14 +845,61 @@ static inline bool4 ambi_dom(const Vertex4D &jDx)
         jDx.w != 0.f && jDx.w + jDx.y > jDx.x + jDx.z);
 }
 
-void upscale(DWORD * const data, const unsigned int xres, const unsigned int yres, const bool is_brightness_data)
+// ScaleFX scratch buffers, kept between frames (upscale() is only called from the script thread)
+struct ScaleFXBuffers
+{
+    void Resize(const unsigned int size)
+    {
+        if (metric.size() == size)
+            return;
+        metric.resize(size);
+        strength.resize(size);
+        res.resize(size);
+        hori.resize(size);
+        vert.resize(size);
+        orient.resize(size);
+        subpixels.resize(size);
+        src.resize(size);
+    }
+
+    std::vector<Vertex4D> metric;
+    std::vector<Vertex4D> strength;
+    std::vector<bool4> res;
+    std::vector<bool4> hori;
+    std::vector<bool4> vert;
+    std::vector<bool4> orient;
+    std::vector<unsigned int> subpixels;
+    std::vector<DWORD> src; // copy of the input frame, as the output overwrites it
+};
+
+static ScaleFXBuffers g_scaleFX;
+
+struct ScaleFXJob
+{
+    DWORD *data;
+    unsigned int xres;
+    unsigned int yres;
+    bool is_brightness_data;
+};
+
+// upscale() splits the DMD into row bands from this size on, below the thread overhead is not worth it
+#define SCALEFX_MT_MIN_PIXELS (192*64)
+
+// edge metric: similarity of each pixel to its neighbors A, B, C, F (computed for all 4 at once)
+static void ScaleFXMetric(void *param, const unsigned int jbegin, const unsigned int jend)
 {
-    std::vector<Vertex4D> metric(xres*yres); //!! avoid constant reallocs?
-    
-    unsigned int o = 0;
-    if (is_brightness_data)
+    const ScaleFXJob * const job = (const ScaleFXJob*)param;
+    const unsigned int xres = job->xres;
+    const DWORD * const data = &g_scaleFX.src[0];
+    Vertex4D * const metric = &g_scaleFX.metric[0];
+
+    unsigned int o = jbegin*xres;
+    if (job->is_brightness_data)
     {
-        for (unsigned int j = 0; j < yres; ++j)
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 inv100 = _mm_set1_ps((float)(1.0 / 100.));
+
+        for (unsigned int j = jbegin; j < jend; ++j)
         {
             const unsigned int jm1 = (j - 1)*xres;
 
@@ -862,13 +913,30 @@ void upscale(DWORD * const data, const unsigned int xres, const unsigned int yre
                 const DWORD C = (j == 0) || (i == xres - 1) ? E2 : data[jm1 + ip1];
                 const DWORD F = (i == xres - 1) ? E2 : data[j*xres + ip1];
 
-                metric[o] = Vertex4D(eq_brightness(E, A), eq_brightness(E, B), eq_brightness(E, C), eq_brightness(E, F));
+                // = eq_brightness(E, A/B/C/F)
+                __m128i d = _mm_sub_epi32(_mm_set1_epi32(E), _mm_set_epi32(F, C, B, A));
+                const __m128i sgn = _mm_srai_epi32(d, 31);
+                d = _mm_sub_epi32(_mm_xor_si128(d, sgn), sgn); // abs
+                _mm_storeu_ps(&metric[o].x, _mm_sub_ps(one, _mm_mul_ps(_mm_cvtepi32_ps(d), inv100)));
             }
         }
     }
     else
     {
-        for (unsigned int j = 0; j < yres; ++j)
+        const __m128i mr = _mm_set1_epi32(255);
+        const __m128i mg = _mm_set1_epi32(65280);
+        const __m128i mb = _mm_set1_epi32(16711680);
+        const __m128 sr = _mm_set1_ps((float)(1.0 / 255.));
+        const __m128 sg = _mm_set1_ps((float)(1.0 / 65280.0));
+        const __m128 sb = _mm_set1_ps((float)(1.0 / 16711680.0));
+        const __m128 half = _mm_set1_ps(0.5f);
+        const __m128 two = _mm_set1_ps(2.f);
+        const __m128 three = _mm_set1_ps(3.f);
+        const __m128 four = _mm_set1_ps(4.f);
+        const __m128 one = _mm_set1_ps(1.f);
+        const __m128 inv3 = _mm_set1_ps((float)(1.0 / 3.));
+
+        for (unsigned int j = jbegin; j < jend; ++j)
         {
             const unsigned int jm1 = (j - 1)*xres;
 
@@ -882,18 +950,83 @@ void upscale(DWORD * const data, const unsigned int xres, const unsigned int yre
                 const DWORD C = (j == 0) || (i == xres - 1) ? E2 : data[jm1 + ip1];
                 const DWORD F = (i == xres - 1) ? E2 : data[j*xres + ip1];
 
-                metric[o] = Vertex4D(eq_col1(E, A), eq_col1(E, B), eq_col1(E, C), eq_col1(E, F));
+                // = eq_col1(E, A/B/C/F), same order of operations to get the same results
+                const __m128i e = _mm_set1_epi32(E);
+                const __m128i n = _mm_set_epi32(F, C, B, A);
+                const __m128 e0 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(e, mr)), sr);
+                const __m128 e1 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(e, mg)), sg);
+                const __m128 e2 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(e, mb)), sb);
+                const __m128 n0 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(n, mr)), sr);
+                const __m128 n1 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(n, mg)), sg);
+                const __m128 n2 = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(n, mb)), sb);
+
+                const __m128 r = _mm_mul_ps(half, _mm_add_ps(e0, n0));
+                const __m128 d0 = _mm_sub_ps(e0, n0);
+                const __m128 d1 = _mm_sub_ps(e1, n1);
+                const __m128 d2 = _mm_sub_ps(e2, n2);
+                const __m128 tmp = _mm_add_ps(_mm_add_ps(
+                    _mm_mul_ps(_mm_mul_ps(_mm_add_ps(two, r), d0), d0),
+                    _mm_mul_ps(_mm_mul_ps(four, d1), d1)),
+                    _mm_mul_ps(_mm_mul_ps(_mm_sub_ps(three, r), d2), d2));
+                _mm_storeu_ps(&metric[o].x, _mm_sub_ps(one, _mm_mul_ps(_mm_sqrt_ps(tmp), inv3)));
             }
         }
     }
+}
 
-    std::vector<bool4> g_res(xres*yres); //!! avoid constant reallocs?
-    std::vector<bool4> g_hori(xres*yres);
-    std::vector<bool4> g_vert(xres*yres);
-    std::vector<bool4> g_or(xres*yres);
+// corner strength of each pixel (= str() of E in ScaleFXEdges), so that it is computed once instead of 9 times
+static void ScaleFXStrength(void *param, const unsigned int jbegin, const unsigned int jend)
+{
+    const ScaleFXJob * const job = (const ScaleFXJob*)param;
+    const unsigned int xres = job->xres;
+    const unsigned int yres = job->yres;
+    const Vertex4D * const metric = &g_scaleFX.metric[0];
+    Vertex4D * const strength = &g_scaleFX.strength[0];
+
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 two = _mm_set1_ps(2.f);
+    const __m128 thr = _mm_set1_ps(SFX_THR);
 
-    o = 0;
-    for (unsigned int j = 0; j < yres; ++j)
+    unsigned int o = jbegin*xres;
+    for (unsigned int j = jbegin; j < jend; ++j)
+    {
+        const unsigned int jp1 = ((j == yres - 1) ? yres - 1 : j + 1)*xres;
+
+        for (unsigned int i = 0; i < xres; ++i, ++o)
+        {
+            const unsigned int im1 = (i == 0) ? 0 : i - 1;
+            const unsigned int ip1 = (i == xres - 1) ? xres - 1 : i + 1;
+
+            const Vertex4D &D = metric[j*xres + im1];
+            const Vertex4D &E = metric[o];
+            const Vertex4D &F = metric[j*xres + ip1];
+            const Vertex4D &H = metric[jp1 + i];
+
+            // = str(Vertex4D(D.z, F.x, H.z, H.x), Vertex4D(E.y, E.w, H.y, D.w))
+            const __m128 crn = _mm_set_ps(H.x, H.z, F.x, D.z);
+            const __m128 ort = _mm_set_ps(D.w, H.y, E.w, E.y);
+            const __m128 ort2 = _mm_shuffle_ps(ort, ort, _MM_SHUFFLE(2, 1, 0, 3)); // (ort.w, ort.x, ort.y, ort.z)
+            const __m128 st = _mm_max_ps(zero, _mm_sub_ps(_mm_mul_ps(two, crn), _mm_add_ps(ort, ort2)));
+            _mm_storeu_ps(&strength[o].x, _mm_and_ps(_mm_cmpgt_ps(crn, thr), st));
+        }
+    }
+}
+
+// corner dominance and edge/orientation flags
+static void ScaleFXEdges(void *param, const unsigned int jbegin, const unsigned int jend)
+{
+    const ScaleFXJob * const job = (const ScaleFXJob*)param;
+    const unsigned int xres = job->xres;
+    const unsigned int yres = job->yres;
+    const Vertex4D * const metric = &g_scaleFX.metric[0];
+    const Vertex4D * const strength = &g_scaleFX.strength[0];
+    bool4 * const g_res = &g_scaleFX.res[0];
+    bool4 * const g_hori = &g_scaleFX.hori[0];
+    bool4 * const g_vert = &g_scaleFX.vert[0];
+    bool4 * const g_or = &g_scaleFX.orient[0];
+
+    unsigned int o = jbegin*xres;
+    for (unsigned int j = jbegin; j < jend; ++j)
     {
         const unsigned int jm1 = (j == 0) ? 0 : (j - 1)*xres;
         const unsigned int jp1 = ((j == yres-1) ? yres-1 : j + 1)*xres;
@@ -928,15 +1061,25 @@ void upscale(DWORD * const data, const unsigned int xres, const unsigned int yre
             const Vertex4D K = metric[jp2 + i];
             const Vertex4D L = metric[jp2 + ip1];
 
-            const Vertex4D As = str(Vertex4D(M.z, B.x, D.z, D.x), Vertex4D(A.y, A.w, D.y, M.w));
-            const Vertex4D Bs = str(Vertex4D(A.z, C.x, E.z, E.x), Vertex4D(B.y, B.w, E.y, A.w));
-            const Vertex4D Cs = str(Vertex4D(B.z, P.x, F.z, F.x), Vertex4D(C.y, C.w, F.y, B.w));
-            const Vertex4D Ds = str(Vertex4D(N.z, E.x, G.z, G.x), Vertex4D(D.y, D.w, G.y, N.w));
-            const Vertex4D Es = str(Vertex4D(D.z, F.x, H.z, H.x), Vertex4D(E.y, E.w, H.y, D.w));
-            const Vertex4D Fs = str(Vertex4D(E.z, Q.x, I.z, I.x), Vertex4D(F.y, F.w, I.y, E.w));
-            const Vertex4D Gs = str(Vertex4D(O.z, H.x, J.z, J.x), Vertex4D(G.y, G.w, J.y, O.w));
-            const Vertex4D Hs = str(Vertex4D(G.z, I.x, K.z, K.x), Vertex4D(H.y, H.w, K.y, G.w));
-            const Vertex4D Is = str(Vertex4D(H.z, R.x, L.z, L.x), Vertex4D(I.y, I.w, L.y, H.w));
+            Vertex4D As, Bs, Cs, Ds, Fs, Gs, Hs, Is;
+            const Vertex4D Es = strength[o];
+            if (i >= 2 && i + 2 < xres && j >= 1 && j + 2 < yres) // neighborhood not affected by the border clamping, so these match the precomputed ones
+            {
+                As = strength[jm1 + im1]; Bs = strength[jm1 + i];    Cs = strength[jm1 + ip1];
+                Ds = strength[j*xres + im1];                         Fs = strength[j*xres + ip1];
+                Gs = strength[jp1 + im1]; Hs = strength[jp1 + i];    Is = strength[jp1 + ip1];
+            }
+            else
+            {
+                As = str(Vertex4D(M.z, B.x, D.z, D.x), Vertex4D(A.y, A.w, D.y, M.w));
+                Bs = str(Vertex4D(A.z, C.x, E.z, E.x), Vertex4D(B.y, B.w, E.y, A.w));
+                Cs = str(Vertex4D(B.z, P.x, F.z, F.x), Vertex4D(C.y, C.w, F.y, B.w));
+                Ds = str(Vertex4D(N.z, E.x, G.z, G.x), Vertex4D(D.y, D.w, G.y, N.w));
+                Fs = str(Vertex4D(E.z, Q.x, I.z, I.x), Vertex4D(F.y, F.w, I.y, E.w));
+                Gs = str(Vertex4D(O.z, H.x, J.z, J.x), Vertex4D(G.y, G.w, J.y, O.w));
+                Hs = str(Vertex4D(G.z, I.x, K.z, K.x), Vertex4D(H.y, H.w, K.y, G.w));
+                Is = str(Vertex4D(H.z, R.x, L.z, L.x), Vertex4D(I.y, I.w, L.y, H.w));
+            }
 
             // strength & dominance junctions
             const Vertex4D jSx = Vertex4D(As.z, Bs.w, Es.x, Ds.y), jDx = dom(As, Bs, Es, Ds);
@@ -983,10 +1126,22 @@ void upscale(DWORD * const data, const unsigned int xres, const unsigned int yre
         }
     }
 
-    unsigned int* metric_tmp = (unsigned int*)&(metric[0].x);
+}
+
+// subpixel selection
+static void ScaleFXSubpixels(void *param, const unsigned int jbegin, const unsigned int jend)
+{
+    const ScaleFXJob * const job = (const ScaleFXJob*)param;
+    const unsigned int xres = job->xres;
+    const unsigned int yres = job->yres;
+    const bool4 * const g_res = &g_scaleFX.res[0];
+    const bool4 * const g_hori = &g_scaleFX.hori[0];
+    const bool4 * const g_vert = &g_scaleFX.vert[0];
+    const bool4 * const g_or = &g_scaleFX.orient[0];
+    unsigned int * const subpixels = &g_scaleFX.subpixels[0];
 
-    o = 0;
-    for (unsigned int j = 0; j < yres; ++j)
+    unsigned int o = jbegin*xres;
+    for (unsigned int j = jbegin; j < jend; ++j)
     {
         const unsigned int jm3 = (j <= 2) ? 0 : (j - 3)*xres;
         const unsigned int jm2 = (j <= 1) ? 0 : (j - 2)*xres;
@@ -1060,14 +1215,24 @@ void upscale(DWORD * const data, const unsigned int xres, const unsigned int yre
             const unsigned int mid_w = (lvl2w.x && !Eo.x || lvl2w.y && !Eo.w || lvl5w.x && !Bo.x || lvl5w.y && !Ho.w) ? 1 : lvl2w.x ? 5 : lvl2w.y ? 7 : lvl5w.x ? 6 : lvl5w.y ? 8 : (Ec.w && Hc.y && Ec.x && Bc.z) ? (!Eo.w ? !Eo.x ? 1 : 5 : 7) : 0;
 
             // ouput
-            metric_tmp[o] = crn_x | (crn_y << 4) | (crn_z << 8) | (crn_w << 12) | (mid_x << 16) | (mid_y << 20) | (mid_z << 24) | (mid_w << 28);
+            subpixels[o] = crn_x | (crn_y << 4) | (crn_z << 8) | (crn_w << 12) | (mid_x << 16) | (mid_y << 20) | (mid_z << 24) | (mid_w << 28);
         }
     }
 
-    memcpy(&g_or[0], data, xres*yres * sizeof(DWORD));
+}
+
+// output
+static void ScaleFXOutput(void *param, const unsigned int jbegin, const unsigned int jend)
+{
+    const ScaleFXJob * const job = (const ScaleFXJob*)param;
+    const unsigned int xres = job->xres;
+    const unsigned int yres = job->yres;
+    DWORD * const data = job->data;
+    const DWORD * const src = &g_scaleFX.src[0];
+    const unsigned int * const subpixels = &g_scaleFX.subpixels[0];
 
-    o = 0;
-    for (unsigned int j = 0; j < yres; ++j)
+    unsigned int o = jbegin*xres;
+    for (unsigned int j = jbegin; j < jend; ++j)
     {
 #ifdef DMD_UPSCALE
         unsigned int offs = j*(xres*9);
@@ -1076,7 +1241,7 @@ void upscale(DWORD * const data, const unsigned int xres, const unsigned int yre
         for (unsigned int i = 0; i < xres; ++i, ++o)
 #endif
         {
-            const unsigned int tmp = metric_tmp[o];
+            const unsigned int tmp = subpixels[o];
             const unsigned int crn_x = tmp & 15;
             const unsigned int crn_y = (tmp >> 4) & 15;
             const unsigned int crn_z = (tmp >> 8) & 15;
@@ -1125,9 +1290,9 @@ void upscale(DWORD * const data, const unsigned int xres, const unsigned int yre
                     }
 
 #ifdef DMD_UPSCALE
-                    data[offs + j2*(xres*3) + i2] = (res == 0xdeadbeef) ? ((g_or[o].xyzw & 0xFEFEFEFE)>>1) : g_or[o+res].xyzw; // borders = half black/half border pixel
+                    data[offs + j2*(xres*3) + i2] = (res == 0xdeadbeef) ? ((src[o] & 0xFEFEFEFE)>>1) : src[o+res]; // borders = half black/half border pixel
 #else
-                    const unsigned int tmp2 = (res == 0xdeadbeef) ? ((g_or[o].xyzw & 0xFEFEFEFE) >> 1) : g_or[o+res].xyzw;
+                    const unsigned int tmp2 = (res == 0xdeadbeef) ? ((src[o] & 0xFEFEFEFE) >> 1) : src[o+res];
                     r +=  tmp2      & 255;
                     g += (tmp2>>8)  & 255;
                     b += (tmp2>>16) & 255;
@@ -1146,98 +1311,251 @@ void upscale(DWORD * const data, const unsigned int xres, const unsigned int yre
     }
 }
 
-STDMETHODIMP ScriptGlobalTable::put_DMDPixels(VARIANT pVal) //!! use 64bit instead of 8bit to reduce overhead??
+static void ScaleFXUpscale(DWORD * const data, const unsigned int xres, const unsigned int yres, const bool is_brightness_data, const unsigned int num_bands)
 {
-   SAFEARRAY *psa = pVal.parray;
+    const unsigned int size = xres*yres;
+    g_scaleFX.Resize(size);
+    memcpy(&g_scaleFX.src[0], data, size*sizeof(DWORD));
 
-   if (psa && g_pplayer && g_pplayer->m_dmdx > 0 && g_pplayer->m_dmdy > 0)
-   {
-      const LONG size = g_pplayer->m_dmdx*g_pplayer->m_dmdy;
-      if (!g_pplayer->m_texdmd
-#ifdef DMD_UPSCALE
-          || (g_pplayer->m_texdmd->width()*g_pplayer->m_texdmd->height() != size*(3*3)))
-#else
-          || (g_pplayer->m_texdmd->width()*g_pplayer->m_texdmd->height() != size))
-#endif
-      {
-         if (g_pplayer->m_texdmd)
-         {
-            g_pplayer->m_pin3d.m_pd3dPrimaryDevice->DMDShader->SetTexture("Texture0", (D3DTexture*)NULL);
-            g_pplayer->m_pin3d.m_pd3dPrimaryDevice->m_texMan.UnloadTexture(g_pplayer->m_texdmd);
-            delete g_pplayer->m_texdmd;
-         }
-#ifdef DMD_UPSCALE
-         g_pplayer->m_texdmd = new BaseTexture(g_pplayer->m_dmdx*3, g_pplayer->m_dmdy*3);
-#else
-         g_pplayer->m_texdmd = new BaseTexture(g_pplayer->m_dmdx, g_pplayer->m_dmdy);
+    ScaleFXJob job;
+    job.data = data;
+    job.xres = xres;
+    job.yres = yres;
+    job.is_brightness_data = is_brightness_data;
+
+    // each pass needs the neighbor rows of the previous one, so the bands are joined in between
+    ParallelFor(ScaleFXMetric, &job, yres, num_bands);
+    ParallelFor(ScaleFXStrength, &job, yres, num_bands);
+    ParallelFor(ScaleFXEdges, &job, yres, num_bands);
+    ParallelFor(ScaleFXSubpixels, &job, yres, num_bands);
+    ParallelFor(ScaleFXOutput, &job, yres, num_bands);
+}
+
+#pragma float_control(pop)
+
+void upscale(DWORD * const data, const unsigned int xres, const unsigned int yres, const bool is_brightness_data)
+{
+    const unsigned int size = xres*yres;
+    ScaleFXUpscale(data, xres, yres, is_brightness_data, (size >= SCALEFX_MT_MIN_PIXELS) ? min(GetNumCPUCores(), 4u) : 1);
+}
+
+// golden-image check of upscale() (run via -ScaleFXTest): digests of the output of the old single threaded,
+// unbanded upscaler for some generated frames, each upscaled unbanded and split into 4 bands
+struct ScaleFXGolden
+{
+    unsigned int xres, yres;
+    bool is_brightness_data;
+    unsigned long long hash;
+};
+
+static const ScaleFXGolden g_scaleFXGolden[] =
+{
+    { 128, 32, true,  0xd3166813d10c9833ull },
+    { 128, 32, false, 0xb7ad060d23016da8ull },
+    { 192, 64, true,  0xa187d784bd67ac65ull },
+    { 192, 64, false, 0x7aa66fd6304298a8ull },
+    {   7,  5, true,  0x6aeca1b4437ea747ull },
+    {   7,  5, false, 0xeb6f21bbfb6f4220ull }
+};
+
+bool ScaleFXTest(std::string &result)
+{
+    bool ok = true;
+    unsigned int lcg = 12345;
+    for (size_t t = 0; t < sizeof(g_scaleFXGolden) / sizeof(g_scaleFXGolden[0]); ++t)
+    {
+        const ScaleFXGolden &golden = g_scaleFXGolden[t];
+        const unsigned int xres = golden.xres;
+        const unsigned int size = xres*golden.yres;
+        std::vector<DWORD> data(size * 9);
+        for (unsigned int i = 0; i < size; ++i)
+        {
+            lcg = lcg * 1103515245u + 12345u;
+            DWORD v;
+            if (golden.is_brightness_data)
+            {
+                v = 0;
+                if ((lcg >> 16) % 3 != 0)
+                {
+                    lcg = lcg * 1103515245u + 12345u;
+                    v = ((lcg >> 16) % 4) * 33;
+                }
+            }
+            else
+            {
+                const unsigned int k = (lcg >> 16) % 4;
+                v = 0xFF000000u | (k == 0 ? 0 : k == 1 ? 0xFF8000 : k == 2 ? 0x00FF40 : 0x2040C0);
+            }
+            if (i % xres > 2 && i > xres) // diagonal runs for the edge detection
+            {
+                lcg = lcg * 1103515245u + 12345u;
+                if ((lcg >> 16) & 1)
+                    v = data[i - xres - 1];
+            }
+            data[i] = v;
+        }
+
+        std::vector<DWORD> single(data);
+        ScaleFXUpscale(&single[0], xres, golden.yres, golden.is_brightness_data, 1);
+        ScaleFXUpscale(&data[0], xres, golden.yres, golden.is_brightness_data, 4);
+
+        char msg[128];
+        if (memcmp(&single[0], &data[0], size * 9 * sizeof(DWORD)) != 0)
+        {
+            sprintf_s(msg, sizeof(msg), "%ux%u %s: 4 bands differ from 1 band\n", xres, golden.yres, golden.is_brightness_data ? "brightness" : "color");
+            result += msg;
+            ok = false;
+        }
+#ifndef DMD_UPSCALE // the digests are of the averaged output, not of the 3x3 one
+        XXH64Stream hash;
+        hash.Update(&single[0], size * 9 * sizeof(DWORD));
+        const unsigned long long digest = hash.Digest();
+        if (digest != golden.hash)
+        {
+            sprintf_s(msg, sizeof(msg), "%ux%u %s: hash %016llx, expected %016llx\n", xres, golden.yres, golden.is_brightness_data ? "brightness" : "color", digest, golden.hash);
+            result += msg;
+            ok = false;
+        }
 #endif
-      }
+    }
+    return ok;
+}
 
-      DWORD* const data = (DWORD*)g_pplayer->m_texdmd->data(); //!! assumes tex data to be always 32bit
+// reads a DMD frame set by the script into g_pplayer->m_dmdFrame, returns false if it is the same as the last one
+static bool ReadDMDFrame(SAFEARRAY * const psa, const LONG size, const bool colored)
+{
+   std::vector<DWORD>& frame = g_pplayer->m_dmdFrame;
+   bool changed = false;
+   if (frame.size() != (size_t)size)
+   {
+      frame.resize(size, 0);
+      changed = true;
+   }
 
-      VARIANT DMDState;
-      DMDState.vt = VT_UI1;
+   VARTYPE vt = VT_EMPTY;
+   SafeArrayGetVartype(psa, &vt);
 
-      for (LONG ofs = 0; ofs < size; ++ofs)
-      {
-         SafeArrayGetElement(psa, &ofs, &DMDState);
-         data[ofs] = DMDState.cVal; // store raw values (0..100), let shader do the rest
-      }
+   // lock the array once instead of one SafeArrayGetElement() per dot
+   void *pv;
+   if (psa->cDims != 1 || FAILED(SafeArrayAccessData(psa, &pv)))
+      return changed;
 
-      if (g_pplayer->m_scaleFX_DMD)
-         upscale(data, g_pplayer->m_dmdx, g_pplayer->m_dmdy, true);
+   const LONG count = min((LONG)psa->rgsabound[0].cElements, size);
+   const DWORD alpha = colored ? 0xFF000000u : 0; // set alpha to let shader know that this is RGB and not just brightness
 
-      g_pplayer->m_pin3d.m_pd3dPrimaryDevice->m_texMan.SetDirty(g_pplayer->m_texdmd);
+   if (vt == VT_VARIANT) // default for script arrays
+   {
+      const VARIANT * const src = (const VARIANT*)pv;
+      if (colored)
+         for (LONG ofs = 0; ofs < count; ++ofs)
+         {
+            const DWORD v = src[ofs].uintVal | alpha;
+            changed |= (frame[ofs] != v);
+            frame[ofs] = v;
+         }
+      else
+         for (LONG ofs = 0; ofs < count; ++ofs)
+         {
+            const DWORD v = (BYTE)src[ofs].cVal;
+            changed |= (frame[ofs] != v);
+            frame[ofs] = v;
+         }
+   }
+   else if (vt == VT_UI1 || vt == VT_I1) // raw byte buffer, brightness only
+   {
+      const BYTE * const src = (const BYTE*)pv;
+      for (LONG ofs = 0; ofs < count; ++ofs)
+      {
+         const DWORD v = src[ofs];
+         changed |= (frame[ofs] != v);
+         frame[ofs] = v;
+      }
+   }
+   else if (vt == VT_UI4 || vt == VT_I4 || vt == VT_INT || vt == VT_UINT) // raw 32bit buffer
+   {
+      const DWORD * const src = (const DWORD*)pv;
+      if (colored)
+         for (LONG ofs = 0; ofs < count; ++ofs)
+         {
+            const DWORD v = src[ofs] | alpha;
+            changed |= (frame[ofs] != v);
+            frame[ofs] = v;
+         }
+      else if (memcmp(&frame[0], src, count*sizeof(DWORD)) != 0) // memcmp is vectorized by the CRT
+      {
+         memcpy(&frame[0], src, count*sizeof(DWORD));
+         changed = true;
+      }
    }
 
-   return S_OK;
+   SafeArrayUnaccessData(psa);
+
+   return changed;
 }
 
-STDMETHODIMP ScriptGlobalTable::put_DMDColoredPixels(VARIANT pVal) //!! use 64bit instead of 32bit to reduce overhead??
+static void PutDMDFrame(SAFEARRAY * const psa, const bool colored)
 {
-	SAFEARRAY *psa = pVal.parray;
-
-	if (psa && g_pplayer && g_pplayer->m_dmdx > 0 && g_pplayer->m_dmdy > 0)
-	{
-		const LONG size = g_pplayer->m_dmdx*g_pplayer->m_dmdy;
-		if (!g_pplayer->m_texdmd
+   const LONG size = g_pplayer->m_dmdx*g_pplayer->m_dmdy;
+   bool recreated = false;
+   if (!g_pplayer->m_texdmd
 #ifdef DMD_UPSCALE
-            || (g_pplayer->m_texdmd->width()*g_pplayer->m_texdmd->height() != size*(3*3)))
+       || (g_pplayer->m_texdmd->width()*g_pplayer->m_texdmd->height() != size*(3*3)))
 #else
-            || (g_pplayer->m_texdmd->width()*g_pplayer->m_texdmd->height() != size))
+       || (g_pplayer->m_texdmd->width()*g_pplayer->m_texdmd->height() != size))
 #endif
-		{
-			if (g_pplayer->m_texdmd)
-			{
-				g_pplayer->m_pin3d.m_pd3dPrimaryDevice->DMDShader->SetTexture("Texture0", (D3DTexture*)NULL);
-				g_pplayer->m_pin3d.m_pd3dPrimaryDevice->m_texMan.UnloadTexture(g_pplayer->m_texdmd);
-				delete g_pplayer->m_texdmd;
-			}
+   {
+      if (g_pplayer->m_texdmd)
+      {
+         g_pplayer->m_pin3d.m_pd3dPrimaryDevice->DMDShader->SetTexture("Texture0", (D3DTexture*)NULL);
+         g_pplayer->m_pin3d.m_pd3dPrimaryDevice->m_texMan.UnloadTexture(g_pplayer->m_texdmd);
+         delete g_pplayer->m_texdmd;
+      }
 #ifdef DMD_UPSCALE
-			g_pplayer->m_texdmd = new BaseTexture(g_pplayer->m_dmdx*3, g_pplayer->m_dmdy*3);
+      g_pplayer->m_texdmd = new BaseTexture(g_pplayer->m_dmdx*3, g_pplayer->m_dmdy*3);
 #else
-			g_pplayer->m_texdmd = new BaseTexture(g_pplayer->m_dmdx, g_pplayer->m_dmdy);
+      g_pplayer->m_texdmd = new BaseTexture(g_pplayer->m_dmdx, g_pplayer->m_dmdy);
 #endif
-		}
+      recreated = true;
+   }
 
-		DWORD* const data = (DWORD*)g_pplayer->m_texdmd->data(); //!! assumes tex data to be always 32bit
+   g_pplayer->m_dmdFrames++;
 
-		VARIANT DMDState;
-		DMDState.vt = VT_UI4;
+   // skip upscaling and texture upload if nothing changed (the previous frame is still in the texture)
+   const bool changed = ReadDMDFrame(psa, size, colored);
+   if (!changed && !recreated && g_pplayer->m_dmdFrameColored == colored)
+   {
+      g_pplayer->m_dmdFramesSkipped++;
+      return;
+   }
+   g_pplayer->m_dmdFrameColored = colored;
 
-		for (LONG ofs = 0; ofs < size; ++ofs)
-		{
-			SafeArrayGetElement(psa, &ofs, &DMDState);
-			data[ofs] = DMDState.uintVal | 0xFF000000u; // store RGB values and let shader do the rest (set alpha to let shader know that this is RGB and not just brightness)
-		}
+   DWORD* const data = (DWORD*)g_pplayer->m_texdmd->data(); //!! assumes tex data to be always 32bit
+   memcpy(data, &g_pplayer->m_dmdFrame[0], size*sizeof(DWORD)); // store raw values (brightness 0..100 or RGB), let shader do the rest
 
-        if (g_pplayer->m_scaleFX_DMD)
-            upscale(data, g_pplayer->m_dmdx, g_pplayer->m_dmdy, false);
+   if (g_pplayer->m_scaleFX_DMD)
+      upscale(data, g_pplayer->m_dmdx, g_pplayer->m_dmdy, !colored);
 
-		g_pplayer->m_pin3d.m_pd3dPrimaryDevice->m_texMan.SetDirty(g_pplayer->m_texdmd);
-	}
+   g_pplayer->m_pin3d.m_pd3dPrimaryDevice->m_texMan.SetDirty(g_pplayer->m_texdmd);
+}
 
-	return S_OK;
+STDMETHODIMP ScriptGlobalTable::put_DMDPixels(VARIANT pVal)
+{
+   SAFEARRAY *psa = pVal.parray;
+
+   if (psa && g_pplayer && g_pplayer->m_dmdx > 0 && g_pplayer->m_dmdy > 0)
+      PutDMDFrame(psa, false);
+
+   return S_OK;
+}
+
+STDMETHODIMP ScriptGlobalTable::put_DMDColoredPixels(VARIANT pVal)
+{
+   SAFEARRAY *psa = pVal.parray;
+
+   if (psa && g_pplayer && g_pplayer->m_dmdx > 0 && g_pplayer->m_dmdy > 0)
+      PutDMDFrame(psa, true);
+
+   return S_OK;
 }
 
 STDMETHODIMP ScriptGlobalTable::GetBalls(LPSAFEARRAY *pVal)
@@ -1349,6 +1667,7 @@ PinTable::PinTable()
       m_activeLayers[i] = true;
    m_toggleAllLayers = false;
    m_savingActive = false;
+   m_compressionLevel = g_pvp->m_autosaveCompressionLevel;
    m_renderSolid = GetRegBoolWithDefault("Editor", "RenderSolid", true);
 
    ClearMultiSel();
@@ -1442,6 +1761,7 @@ PinTable::PinTable()
    m_pbTempScreenshot = NULL;
 
    m_tblMirrorEnabled = false;
+   m_soundSerial = 0;
 
    memset(m_szImage, 0, MAXTOKEN);
    memset(m_szEnvImage, 0, MAXTOKEN);
@@ -2586,6 +2906,7 @@ void PinTable::AutoSave()
    FastIStorage * const pstgroot = new FastIStorage();
    pstgroot->AddRef();
 
+   m_compressionLevel = g_pvp->m_autosaveCompressionLevel;
    const HRESULT hr = SaveToStorage(pstgroot);
 
    m_undo.SetCleanPoint((SaveDirtyState)min((int)m_sdsDirtyProp, (int)eSaveAutosaved));
@@ -2709,7 +3030,9 @@ HRESULT PinTable::Save(const bool fSaveAs)
    // merge all elements for saving
    BackupLayers();
 
+   m_compressionLevel = g_pvp->m_saveCompressionLevel;
    const HRESULT hr = SaveToStorage(pstgRoot);
+   m_compressionLevel = g_pvp->m_autosaveCompressionLevel; // for undo and copy&paste
 
    if (!FAILED(hr))
    {
@@ -2772,9 +3095,11 @@ HRESULT PinTable::SaveToStorage(IStorage *pstgRoot)
    BYTE hashval[256];
    DWORD hashlen = 256;
 
-   foo = CryptHashData(hch, (BYTE *)TABLE_KEY, 14, 0);
+   // all integrity hash data is collected in here and hashed in large blocks
+   HashBuffer hashbuf(hch);
+   hashbuf.SetFastHash(CURRENT_FILE_FORMAT_VERSION >= FAST_HASH_FORMAT_VERSION);
 
-   foo = GetLastError();
+   hashbuf.Update(TABLE_KEY, 14);
 
    // create a key hash (we have to use a second hash as deriving a key from the
    // integrity hash actually modifies it and thus it calculates the wrong hash)
@@ -2789,6 +3114,8 @@ HRESULT PinTable::SaveToStorage(IStorage *pstgRoot)
 
    ////////////// End Encryption
 
+   const unsigned long long save_start_usec = usec();
+
    int ctotalitems = (int)(m_vedit.size() + m_vsound.size() + m_vimage.size() + m_vfont.size() + m_vcollection.Size());
    int csaveditems = 0;
 
@@ -2804,7 +3131,7 @@ HRESULT PinTable::SaveToStorage(IStorage *pstgRoot)
          {
             ULONG writ;
             int version = CURRENT_FILE_FORMAT_VERSION;
-            CryptHashData(hch, (BYTE *)&version, sizeof(version), 0);
+            hashbuf.Update(&version, sizeof(version));
             pstmItem->Write(&version, sizeof(version), &writ);
             pstmItem->Release();
             pstmItem = NULL;
@@ -2812,11 +3139,11 @@ HRESULT PinTable::SaveToStorage(IStorage *pstgRoot)
 
          if (SUCCEEDED(hr = pstgRoot->CreateStorage(L"TableInfo", STGM_TRANSACTED | STGM_READWRITE | STGM_SHARE_EXCLUSIVE | STGM_CREATE, 0, 0, &pstgInfo)))
          {
-            SaveInfo(pstgInfo, hch);
+            SaveInfo(pstgInfo, &hashbuf);
 
             if (SUCCEEDED(hr = pstgData->CreateStream(L"CustomInfoTags", STGM_DIRECT | STGM_READWRITE | STGM_SHARE_EXCLUSIVE | STGM_CREATE, 0, 0, &pstmItem)))
             {
-               SaveCustomInfo(pstgInfo, pstmItem, hch);
+               SaveCustomInfo(pstgInfo, pstmItem, &hashbuf);
                pstmItem->Release();
                pstmItem = NULL;
             }
@@ -2824,7 +3151,7 @@ HRESULT PinTable::SaveToStorage(IStorage *pstgRoot)
             pstgInfo->Release();
          }
 
-         if (SUCCEEDED(hr = SaveData(pstmGame, hch)))
+         if (SUCCEEDED(hr = SaveData(pstmGame, &hashbuf)))
          {
             for (size_t i = 0; i < m_vedit.size(); i++)
             {
@@ -2922,7 +3249,7 @@ HRESULT PinTable::SaveToStorage(IStorage *pstgRoot)
 
                if (SUCCEEDED(hr = pstgData->CreateStream(wszStmName, STGM_DIRECT | STGM_READWRITE | STGM_SHARE_EXCLUSIVE | STGM_CREATE, 0, 0, &pstmItem)))
                {
-                  m_vcollection.ElementAt(i)->SaveData(pstmItem, hch);
+                  m_vcollection.ElementAt(i)->SaveData(pstmItem, &hashbuf);
                   pstmItem->Release();
                   pstmItem = NULL;
                }
@@ -2935,10 +3262,9 @@ HRESULT PinTable::SaveToStorage(IStorage *pstgRoot)
       }
 
       // Authentication block
-      foo = CryptGetHashParam(hch, HP_HASHSIZE, hashval, &hashlen, 0);
+      hashbuf.GetHashValue(hashval, &hashlen);
 
-      hashlen = 256;
-      foo = CryptGetHashParam(hch, HP_HASHVAL, hashval, &hashlen, 0);
+      slintf("Table saved in %.1f ms\n", (double)(usec() - save_start_usec) / 1000.0);
 
       if (SUCCEEDED(hr = pstgData->CreateStream(L"MAC", STGM_DIRECT | STGM_READWRITE | STGM_SHARE_EXCLUSIVE | STGM_CREATE, 0, 0, &pstmItem)))
       {
@@ -3014,7 +3340,8 @@ HRESULT PinTable::SaveSoundToStream(PinSound * const pps, IStream *pstm)
    if (FAILED(hr = pstm->Write(&pps->m_cdata, sizeof(int), &writ)))
       return hr;
 
-   if (FAILED(hr = pstm->Write(pps->m_pdata, pps->m_cdata, &writ)))
+   std::vector<char> pcm;
+   if (FAILED(hr = pstm->Write(pps->GetPCM(pcm), pps->m_cdata, &writ)))
       return hr;
 
    if (FAILED(hr = pstm->Write(&pps->m_iOutputTarget, sizeof(bool), &writ)))
@@ -3156,7 +3483,7 @@ HRESULT PinTable::LoadSoundFromStream(IStream *pstm, const int LoadFileVersion)
 }
 
 
-HRESULT PinTable::WriteInfoValue(IStorage* pstg, WCHAR *wzName, char *szValue, HCRYPTHASH hcrypthash)
+HRESULT PinTable::WriteInfoValue(IStorage* pstg, WCHAR *wzName, char *szValue, HashBuffer *phashbuf)
 {
    HRESULT hr;
    IStream *pstm;
@@ -3164,7 +3491,7 @@ HRESULT PinTable::WriteInfoValue(IStorage* pstg, WCHAR *wzName, char *szValue, H
    if (szValue && SUCCEEDED(hr = pstg->CreateStream(wzName, STGM_DIRECT | STGM_READWRITE | STGM_SHARE_EXCLUSIVE | STGM_CREATE, 0, 0, &pstm)))
    {
       ULONG writ;
-      BiffWriter bw(pstm, hcrypthash);
+      BiffWriter bw(pstm, phashbuf);
 
       const int len = lstrlen(szValue);
       WCHAR *wzT = new WCHAR[len + 1];
@@ -3180,17 +3507,17 @@ HRESULT PinTable::WriteInfoValue(IStorage* pstg, WCHAR *wzName, char *szValue, H
 }
 
 
-HRESULT PinTable::SaveInfo(IStorage* pstg, HCRYPTHASH hcrypthash)
+HRESULT PinTable::SaveInfo(IStorage* pstg, HashBuffer *phashbuf)
 {
-   WriteInfoValue(pstg, L"TableName", m_szTableName, hcrypthash);
-   WriteInfoValue(pstg, L"AuthorName", m_szAuthor, hcrypthash);
-   WriteInfoValue(pstg, L"TableVersion", m_szVersion, hcrypthash);
-   WriteInfoValue(pstg, L"ReleaseDate", m_szReleaseDate, hcrypthash);
-   WriteInfoValue(pstg, L"AuthorEmail", m_szAuthorEMail, hcrypthash);
-   WriteInfoValue(pstg, L"AuthorWebSite", m_szWebSite, hcrypthash);
-   WriteInfoValue(pstg, L"TableBlurb", m_szBlurb, hcrypthash);
-   WriteInfoValue(pstg, L"TableDescription", m_szDescription, hcrypthash);
-   WriteInfoValue(pstg, L"TableRules", m_szRules, hcrypthash);
+   WriteInfoValue(pstg, L"TableName", m_szTableName, phashbuf);
+   WriteInfoValue(pstg, L"AuthorName", m_szAuthor, phashbuf);
+   WriteInfoValue(pstg, L"TableVersion", m_szVersion, phashbuf);
+   WriteInfoValue(pstg, L"ReleaseDate", m_szReleaseDate, phashbuf);
+   WriteInfoValue(pstg, L"AuthorEmail", m_szAuthorEMail, phashbuf);
+   WriteInfoValue(pstg, L"AuthorWebSite", m_szWebSite, phashbuf);
+   WriteInfoValue(pstg, L"TableBlurb", m_szBlurb, phashbuf);
+   WriteInfoValue(pstg, L"TableDescription", m_szDescription, phashbuf);
+   WriteInfoValue(pstg, L"TableRules", m_szRules, phashbuf);
 
    Texture *pin = GetImage(m_szScreenShot);
    if (pin != NULL && pin->m_ppb != NULL)
@@ -3200,7 +3527,7 @@ HRESULT PinTable::SaveInfo(IStorage* pstg, HCRYPTHASH hcrypthash)
 
       if (SUCCEEDED(hr = pstg->CreateStream(L"Screenshot", STGM_DIRECT | STGM_READWRITE | STGM_SHARE_EXCLUSIVE | STGM_CREATE, 0, 0, &pstm)))
       {
-         BiffWriter bw(pstm, hcrypthash);
+         BiffWriter bw(pstm, phashbuf);
          ULONG writ;
          bw.WriteBytes(pin->m_ppb->m_pdata, pin->m_ppb->m_cdata, &writ);
          pstm->Release();
@@ -3214,9 +3541,9 @@ HRESULT PinTable::SaveInfo(IStorage* pstg, HCRYPTHASH hcrypthash)
 }
 
 
-HRESULT PinTable::SaveCustomInfo(IStorage* pstg, IStream *pstmTags, HCRYPTHASH hcrypthash)
+HRESULT PinTable::SaveCustomInfo(IStorage* pstg, IStream *pstmTags, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstmTags, hcrypthash);
+   BiffWriter bw(pstmTags, phashbuf);
 
    for (size_t i = 0; i < m_vCustomInfoTag.size(); i++)
    {
@@ -3232,7 +3559,7 @@ HRESULT PinTable::SaveCustomInfo(IStorage* pstg, IStream *pstmTags, HCRYPTHASH h
       WCHAR *wzName = new WCHAR[len + 1];
       MultiByteToWideChar(CP_ACP, 0, szName, -1, wzName, len + 1);
 
-      WriteInfoValue(pstg, wzName, m_vCustomInfoContent[i], hcrypthash);
+      WriteInfoValue(pstg, wzName, m_vCustomInfoContent[i], phashbuf);
 
       delete[] wzName;
    }
@@ -3243,7 +3570,7 @@ HRESULT PinTable::SaveCustomInfo(IStorage* pstg, IStream *pstmTags, HCRYPTHASH h
 }
 
 
-HRESULT PinTable::ReadInfoValue(IStorage* pstg, WCHAR *wzName, char **pszValue, HCRYPTHASH hcrypthash)
+HRESULT PinTable::ReadInfoValue(IStorage* pstg, WCHAR *wzName, char **pszValue, HashBuffer *phashbuf)
 {
    HRESULT hr;
    IStream *pstm;
@@ -3257,9 +3584,12 @@ HRESULT PinTable::ReadInfoValue(IStorage* pstg, WCHAR *wzName, char **pszValue,
       WCHAR *wzT = new WCHAR[len + 1];
       *pszValue = new char[len + 1];
 
-      ULONG read;
-      BiffReader br(pstm, NULL, NULL, 0, hcrypthash, NULL);
-      br.ReadBytes(wzT, ss.cbSize.LowPart, &read);
+      {
+         // destroyed before the stream is released, as it may still seek on it
+         ULONG read;
+         BiffReader br(pstm, NULL, NULL, 0, phashbuf, NULL);
+         br.ReadBytes(wzT, ss.cbSize.LowPart, &read);
+      }
       wzT[len] = L'\0';
 
       WideCharToMultiByte(CP_ACP, 0, wzT, -1, *pszValue, len + 1, NULL, NULL);
@@ -3275,17 +3605,17 @@ HRESULT PinTable::ReadInfoValue(IStorage* pstg, WCHAR *wzName, char **pszValue,
 }
 
 
-HRESULT PinTable::LoadInfo(IStorage* pstg, HCRYPTHASH hcrypthash, int version)
+HRESULT PinTable::LoadInfo(IStorage* pstg, HashBuffer *phashbuf, int version)
 {
-   ReadInfoValue(pstg, L"TableName", &m_szTableName, hcrypthash);
-   ReadInfoValue(pstg, L"AuthorName", &m_szAuthor, hcrypthash);
-   ReadInfoValue(pstg, L"TableVersion", &m_szVersion, hcrypthash);
-   ReadInfoValue(pstg, L"ReleaseDate", &m_szReleaseDate, hcrypthash);
-   ReadInfoValue(pstg, L"AuthorEmail", &m_szAuthorEMail, hcrypthash);
-   ReadInfoValue(pstg, L"AuthorWebSite", &m_szWebSite, hcrypthash);
-   ReadInfoValue(pstg, L"TableBlurb", &m_szBlurb, hcrypthash);
-   ReadInfoValue(pstg, L"TableDescription", &m_szDescription, hcrypthash);
-   ReadInfoValue(pstg, L"TableRules", &m_szRules, hcrypthash);
+   ReadInfoValue(pstg, L"TableName", &m_szTableName, phashbuf);
+   ReadInfoValue(pstg, L"AuthorName", &m_szAuthor, phashbuf);
+   ReadInfoValue(pstg, L"TableVersion", &m_szVersion, phashbuf);
+   ReadInfoValue(pstg, L"ReleaseDate", &m_szReleaseDate, phashbuf);
+   ReadInfoValue(pstg, L"AuthorEmail", &m_szAuthorEMail, phashbuf);
+   ReadInfoValue(pstg, L"AuthorWebSite", &m_szWebSite, phashbuf);
+   ReadInfoValue(pstg, L"TableBlurb", &m_szBlurb, phashbuf);
+   ReadInfoValue(pstg, L"TableDescription", &m_szDescription, phashbuf);
+   ReadInfoValue(pstg, L"TableRules", &m_szRules, phashbuf);
 
    // Check pointer.
    if (m_szVersion != NULL)
@@ -3309,9 +3639,12 @@ HRESULT PinTable::LoadInfo(IStorage* pstg, HCRYPTHASH hcrypthash, int version)
 
       //m_pbTempScreenshot->LoadFromStream(pstm, version);
 
-      ULONG read;
-      BiffReader br(pstm, NULL, NULL, 0, hcrypthash, NULL);
-      br.ReadBytes(m_pbTempScreenshot->m_pdata, m_pbTempScreenshot->m_cdata, &read);
+      {
+         // destroyed before the stream is released, as it may still seek on it
+         ULONG read;
+         BiffReader br(pstm, NULL, NULL, 0, phashbuf, NULL);
+         br.ReadBytes(m_pbTempScreenshot->m_pdata, m_pbTempScreenshot->m_cdata, &read);
+      }
 
       //delete pdata;
 
@@ -3321,9 +3654,9 @@ HRESULT PinTable::LoadInfo(IStorage* pstg, HCRYPTHASH hcrypthash, int version)
    return S_OK;
 }
 
-HRESULT PinTable::LoadCustomInfo(IStorage* pstg, IStream *pstmTags, HCRYPTHASH hcrypthash, int version)
+HRESULT PinTable::LoadCustomInfo(IStorage* pstg, IStream *pstmTags, HashBuffer *phashbuf, int version)
 {
-   BiffReader br(pstmTags, this, NULL, version, hcrypthash, NULL);
+   BiffReader br(pstmTags, this, NULL, version, phashbuf, NULL);
    br.Load();
 
    for (size_t i = 0; i < m_vCustomInfoTag.size(); i++)
@@ -3334,7 +3667,7 @@ HRESULT PinTable::LoadCustomInfo(IStorage* pstg, IStream *pstmTags, HCRYPTHASH h
       MultiByteToWideChar(CP_ACP, 0, szName, -1, wzName, len + 1);
 
 	  char *szValue;
-	  ReadInfoValue(pstg, wzName, &szValue, hcrypthash);
+	  ReadInfoValue(pstg, wzName, &szValue, phashbuf);
       m_vCustomInfoContent.push_back(szValue);
 
       delete[] wzName;
@@ -3343,9 +3676,9 @@ HRESULT PinTable::LoadCustomInfo(IStorage* pstg, IStream *pstmTags, HCRYPTHASH h
    return S_OK;
 }
 
-HRESULT PinTable::SaveData(IStream* pstm, HCRYPTHASH hcrypthash)
+HRESULT PinTable::SaveData(IStream* pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteFloat(FID(LEFT), m_left);
    bw.WriteFloat(FID(TOPX), m_top);
@@ -3513,7 +3846,7 @@ HRESULT PinTable::SaveData(IStream* pstm, HCRYPTHASH hcrypthash)
    // HACK!!!! - Don't save special values when copying for undo.  For instance, don't reset the code.
    // Someday save these values into there own stream, used only when saving to file.
 
-   if (hcrypthash != 0)
+   if (phashbuf != NULL)
    {
       bw.WriteInt(FID(SEDT), (int)m_vedit.size());
       bw.WriteInt(FID(SSND), (int)m_vsound.size());
@@ -3528,7 +3861,7 @@ HRESULT PinTable::SaveData(IStream* pstm, HCRYPTHASH hcrypthash)
       // save the script source code
       bw.WriteTag(FID(CODE));
       // if the script is protected then we pass in the proper cyptokey into the code savestream
-      m_pcv->SaveToStream(pstm, hcrypthash);
+      m_pcv->SaveToStream(pstm, phashbuf);
    }
 
    bw.WriteTag(FID(ENDB));
@@ -3605,9 +3938,11 @@ HRESULT PinTable::LoadGameFromStorage(IStorage *pstgRoot)
    BYTE hashval[256];
    DWORD hashlen = 256;
 
-   foo = CryptHashData(hch, (BYTE *)TABLE_KEY, 14, 0);
+   // all integrity hash data is collected in here and hashed in large blocks,
+   // the hash algorithm is selected as soon as the file version is known
+   HashBuffer hashbuf(hch);
 
-   foo = GetLastError();
+   hashbuf.Update(TABLE_KEY, 14);
 
    // create a key hash (we have to use a second hash as deriving a key from the
    // integrity hash actually modifies it and thus it calculates the wrong hash)
@@ -3621,6 +3956,8 @@ HRESULT PinTable::LoadGameFromStorage(IStorage *pstgRoot)
 
    ////////////// End MAC
 
+   const unsigned long long load_start_usec = usec();
+
    int loadfileversion = CURRENT_FILE_FORMAT_VERSION;
 
    //load our stuff first
@@ -3633,7 +3970,8 @@ HRESULT PinTable::LoadGameFromStorage(IStorage *pstgRoot)
          {
             ULONG read;
             hr = pstmVersion->Read(&loadfileversion, sizeof(int), &read);
-            CryptHashData(hch, (BYTE *)&loadfileversion, sizeof(int), 0);
+            hashbuf.SetFastHash(loadfileversion >= FAST_HASH_FORMAT_VERSION);
+            hashbuf.Update(&loadfileversion, sizeof(int));
             pstmVersion->Release();
             if (loadfileversion > CURRENT_FILE_FORMAT_VERSION)
             {
@@ -3656,10 +3994,10 @@ HRESULT PinTable::LoadGameFromStorage(IStorage *pstgRoot)
 
          if (SUCCEEDED(hr = pstgRoot->OpenStorage(L"TableInfo", NULL, STGM_DIRECT | STGM_READ | STGM_SHARE_EXCLUSIVE, NULL, 0, &pstgInfo)))
          {
-            LoadInfo(pstgInfo, hch, loadfileversion);
+            LoadInfo(pstgInfo, &hashbuf, loadfileversion);
             if (SUCCEEDED(hr = pstgData->OpenStream(L"CustomInfoTags", NULL, STGM_DIRECT | STGM_READ | STGM_SHARE_EXCLUSIVE, 0, &pstmItem)))
             {
-               hr = LoadCustomInfo(pstgInfo, pstmItem, hch, loadfileversion);
+               hr = LoadCustomInfo(pstgInfo, pstmItem, &hashbuf, loadfileversion);
                pstmItem->Release();
                pstmItem = NULL;
             }
@@ -3672,7 +4010,7 @@ HRESULT PinTable::LoadGameFromStorage(IStorage *pstgRoot)
          int cfonts = 0;
          int ccollection = 0;
 
-         if (SUCCEEDED(hr = LoadData(pstmGame, csubobj, csounds, ctextures, cfonts, ccollection, loadfileversion, hch, (loadfileversion < NO_ENCRYPTION_FORMAT_VERSION) ? hkey : NULL)))
+         if (SUCCEEDED(hr = LoadData(pstmGame, csubobj, csounds, ctextures, cfonts, ccollection, loadfileversion, &hashbuf, (loadfileversion < NO_ENCRYPTION_FORMAT_VERSION) ? hkey : NULL)))
          {
             ctotalitems = csubobj + csounds + ctextures + cfonts;
             cloadeditems = 0;
@@ -3697,7 +4035,7 @@ HRESULT PinTable::LoadGameFromStorage(IStorage *pstgRoot)
 
                   //AddSpriteProjItem();
                   int id = 0; // VBA id for this item
-                  hr = piedit->InitLoad(pstmItem, this, &id, loadfileversion, (loadfileversion < 1000) ? hch : NULL, (loadfileversion < 1000) ? hkey : NULL); // 1000 (VP10 beta) removed the encryption
+                  hr = piedit->InitLoad(pstmItem, this, &id, loadfileversion, (loadfileversion < 1000) ? &hashbuf : NULL, (loadfileversion < 1000) ? hkey : NULL); // 1000 (VP10 beta) removed the encryption
                   piedit->InitVBA(fFalse, id, NULL);
                   pstmItem->Release();
                   pstmItem = NULL;
@@ -3786,7 +4124,7 @@ HRESULT PinTable::LoadGameFromStorage(IStorage *pstgRoot)
                   CComObject<Collection> *pcol;
                   CComObject<Collection>::CreateInstance(&pcol);
                   pcol->AddRef();
-                  pcol->LoadData(pstmItem, this, loadfileversion, hch, (loadfileversion < NO_ENCRYPTION_FORMAT_VERSION) ? hkey : NULL);
+                  pcol->LoadData(pstmItem, this, loadfileversion, &hashbuf, (loadfileversion < NO_ENCRYPTION_FORMAT_VERSION) ? hkey : NULL);
                   m_vcollection.AddElement(pcol);
                   m_pcv->AddItem((IScriptable *)pcol, false);
                   pstmItem->Release();
@@ -3815,10 +4153,9 @@ HRESULT PinTable::LoadGameFromStorage(IStorage *pstgRoot)
                ULONG read;
                hr = pstmVersion->Read(&hashvalOld, HASHLENGTH, &read);
 
-               foo = CryptGetHashParam(hch, HP_HASHSIZE, hashval, &hashlen, 0);
+               hashbuf.GetHashValue(hashval, &hashlen);
 
-               hashlen = 256;
-               foo = CryptGetHashParam(hch, HP_HASHVAL, hashval, &hashlen, 0);
+               slintf("Table loaded in %.1f ms\n", (double)(usec() - load_start_usec) / 1000.0);
 
                foo = CryptDestroyHash(hch);
 
@@ -3944,13 +4281,13 @@ void PinTable::SetLoadDefaults()
    m_overridePhysicsFlipper = false;
 }
 
-HRESULT PinTable::LoadData(IStream* pstm, int& csubobj, int& csounds, int& ctextures, int& cfonts, int& ccollection, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT PinTable::LoadData(IStream* pstm, int& csubobj, int& csounds, int& ctextures, int& cfonts, int& ccollection, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetLoadDefaults();
 
    int rgi[6] = { 0, 0, 0, 0, 0, 0 };
 
-   BiffReader br(pstm, this, rgi, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, rgi, version, phashbuf, hcryptkey);
 
    br.Load();
 
@@ -4393,7 +4730,7 @@ BOOL PinTable::LoadToken(int id, BiffReader *pbr)
       const bool script_protected = (((m_protectionData.flags & DISABLE_EVERYTHING) == DISABLE_EVERYTHING) ||
           ((m_protectionData.flags & DISABLE_SCRIPT_EDITING) == DISABLE_SCRIPT_EDITING));
 
-      m_pcv->LoadFromStream(pbr->m_pistream, pbr->m_hcrypthash, script_protected ? pbr->m_hcryptkey : NULL);
+      m_pcv->LoadFromStream(pbr->GetStream(), pbr->m_phashbuf, script_protected ? pbr->m_hcryptkey : NULL);
    }
    else if (id == FID(CCUS))
    {
@@ -4542,7 +4879,8 @@ bool PinTable::ExportSound(PinSound * const pps, const char * const szfilename)
       mmioWrite(hmmio, "data", 4);						//data chunk
       i = pps->m_cdata; mmioWrite(hmmio, (char *)&i, 4);	// data size bytes
 
-      const LONG wcch = mmioWrite(hmmio, pps->m_pdata, pps->m_cdata);
+      std::vector<char> pcm;
+      const LONG wcch = mmioWrite(hmmio, pps->GetPCM(pcm), pps->m_cdata);
       result = mmioClose(hmmio, 0);
 
       if (wcch != pps->m_cdata) 
@@ -6841,13 +7179,13 @@ void PinTable::UIRenderPass1(Sur * const psur)
 {
 }
 
-HRESULT PinTable::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT PinTable::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
 
    int csubobj, csounds, ctextures, cfonts, ccollection;
 
-   LoadData(pstm, csubobj, csounds, ctextures, cfonts, ccollection, version, hcrypthash, hcryptkey);
+   LoadData(pstm, csubobj, csounds, ctextures, cfonts, ccollection, version, phashbuf, hcryptkey);
 
    return S_OK;
 }
@@ -7009,8 +7347,8 @@ void PinTable::AddMultiSel(ISelect *psel, bool fAdd, bool fUpdate, bool fContext
       if (piSelect->GetItemType() == eItemPrimitive)
       {
          Primitive *prim = (Primitive*)piSelect;
-         if (prim->m_mesh.m_animationFrames.size() > 0)
-            info = info + " (animated " + std::to_string((unsigned long long)prim->m_mesh.m_animationFrames.size() - 1) + " frames)";
+         if (prim->m_mesh.m_animation.NumFrames() > 0)
+            info = info + " (animated " + std::to_string((unsigned long long)prim->m_mesh.m_animation.NumFrames() - 1) + " frames)";
       }
       g_pvp->SetStatusBarElementInfo(info.c_str());
       m_pcv->SelectItem(piSelect->GetIEditable()->GetScriptable());
@@ -7731,17 +8069,44 @@ void PinTable::ClearOldSounds()
       PinSoundCopy * const ppsc = m_voldsound[i];
       DWORD status;
       ppsc->m_pDSBuffer->GetStatus(&status);
-      if (!(status & DSBSTATUS_PLAYING)) //sound is done, we can throw it away now
+      if (!(status & DSBSTATUS_PLAYING)) //sound is done, keep it around for the next PlaySound of the same sound
       {
-         ppsc->m_pDSBuffer->Release();
          m_voldsound.erase(m_voldsound.begin() + i);
-         delete ppsc;
+         ppsc->m_ppsOriginal->ReleaseCopy(ppsc);
       }
       else
          i++;
    }
 }
 
+// Frees a voice when the budget is used up: the quietest non-looping copy goes first, the oldest one on equal volume.
+// Returns false if all of them are louder than the new sound (which is then not played at all).
+bool PinTable::StealSoundVoice(const float volume)
+{
+   size_t victim = m_voldsound.size();
+   for (size_t i = 0; i < m_voldsound.size(); i++)
+   {
+      PinSoundCopy * const ppsc = m_voldsound[i];
+      DWORD status;
+      ppsc->m_pDSBuffer->GetStatus(&status);
+      if (status & DSBSTATUS_LOOPING)
+         continue;
+      if (victim == m_voldsound.size() || ppsc->m_volume < m_voldsound[victim]->m_volume
+         || (ppsc->m_volume == m_voldsound[victim]->m_volume && (int)(ppsc->m_serial - m_voldsound[victim]->m_serial) < 0))
+         victim = i;
+   }
+
+   g_pplayer->m_soundStats.steals++;
+   if (victim == m_voldsound.size() || m_voldsound[victim]->m_volume > volume)
+      return false;
+
+   PinSoundCopy * const ppsc = m_voldsound[victim];
+   ppsc->m_pDSBuffer->Stop();
+   m_voldsound.erase(m_voldsound.begin() + victim);
+   ppsc->m_ppsOriginal->ReleaseCopy(ppsc);
+   return true;
+}
+
 HRESULT PinTable::StopSound(BSTR Sound)
 {
    MAKE_ANSIPTR_FROMWIDE(szName, Sound);
@@ -7753,6 +8118,8 @@ HRESULT PinTable::StopSound(BSTR Sound)
       if (!lstrcmp(m_vsound[i]->m_szInternalName, szName))
       {
          m_vsound[i]->m_pDSBuffer->Stop();
+         if (g_pplayer && g_pplayer->m_psoundmixer)
+            g_pplayer->m_psoundmixer->Stop(m_vsound[i]);
          break;
       }
    }
@@ -7772,6 +8139,9 @@ HRESULT PinTable::StopSound(BSTR Sound)
 
 void PinTable::StopAllSounds()
 {
+	if (g_pplayer && g_pplayer->m_psoundmixer)
+		g_pplayer->m_psoundmixer->StopAll();
+
 	// In case we were playing any of the main buffers
 	for (size_t i = 0; i < m_vsound.size(); i++)
 	{
@@ -7825,6 +8195,13 @@ STDMETHODIMP PinTable::PlaySound(BSTR bstr, int loopcount, float volume, float p
    const int flags = (loopcount == -1) ? DSBPLAY_LOOPING : 0;
    // 10 volume = -10Db
 
+   if (m_tblMirrorEnabled)
+      pan = -pan;
+
+   if (g_pplayer->m_psoundmixer && pps->m_iOutputTarget == SNDOUT_TABLE
+      && g_pplayer->m_psoundmixer->Play(pps, volume * m_TableSoundVolume * ((float)g_pplayer->m_SoundVolume), randompitch, pitch, pan, front_rear_fade, loopcount == -1, !!usesame, !!restart))
+      return S_OK;
+
    const LPDIRECTSOUNDBUFFER pdsb = pps->m_pDSBuffer;
    //PinDirectSound *pDS = pps->m_pPinDirectSound;
    PinSoundCopy * ppsc = NULL;
@@ -7842,17 +8219,30 @@ STDMETHODIMP PinTable::PlaySound(BSTR bstr, int loopcount, float volume, float p
       }
    }
 
+   const float totalvolume = volume * m_TableSoundVolume * ((float)g_pplayer->m_SoundVolume);
+
    if (ppsc == NULL)
    {
-      ppsc = new PinSoundCopy(pps);
-   }
+      const unsigned long long start = usec();
 
-   if (m_tblMirrorEnabled)
-      pan = -pan;
+      // stay within the voice budget (streamed sounds only play the original), compared on the clamped volume that PinSoundCopy::Play() remembers
+      if (g_pplayer->m_maxSoundVoices > 0 && !pps->m_streaming && m_voldsound.size() >= (size_t)g_pplayer->m_maxSoundVoices
+         && !StealSoundVoice(max(min(totalvolume, 100.0f), 0.0f)))
+      {
+         g_pplayer->m_soundStats.allocUsec += usec() - start;
+         return S_OK;
+      }
+
+      ppsc = pps->GetCopy();
+      ppsc->m_serial = m_soundSerial++;
+
+      g_pplayer->m_soundStats.allocs++;
+      g_pplayer->m_soundStats.allocUsec += usec() - start;
+   }
 
    if (ppsc->m_pDSBuffer)
    {
-	  ppsc->Play(volume * m_TableSoundVolume* ((float)g_pplayer->m_SoundVolume), randompitch, pitch, pan, front_rear_fade, flags, !!restart);
+      ppsc->Play(totalvolume, randompitch, pitch, pan, front_rear_fade, flags, !!restart);
       if (!foundsame)
       {
          m_voldsound.push_back(ppsc);
@@ -7862,7 +8252,7 @@ STDMETHODIMP PinTable::PlaySound(BSTR bstr, int loopcount, float volume, float p
    {
       delete ppsc;
 
-	  pps->Play(volume * m_TableSoundVolume * ((float)g_pplayer->m_SoundVolume), randompitch, pitch, pan, front_rear_fade, flags, !!restart);
+      pps->Play(totalvolume, randompitch, pitch, pan, front_rear_fade, flags, !!restart);
    }
 
    return S_OK;
@@ -329,6 +329,7 @@ public:
    HRESULT SaveSoundToStream(PinSound * const pps, IStream *pstm);
    HRESULT LoadSoundFromStream(IStream *pstm, const int LoadFileVersion);
    void ClearOldSounds();
+   bool StealSoundVoice(const float volume);
    bool ExportImage(Texture * const ppi, const char * const filename);
    void ImportImage(HWND hwndListView, const char * const filename);
    void ReImportImage(Texture * const ppi, const char * const filename);
@@ -376,7 +377,7 @@ public:
    // IEditable (mostly bogus for now)
    virtual void UIRenderPass1(Sur * const psur);
    virtual ItemTypeEnum GetItemType() const { return eItemTable; }
-   virtual HRESULT InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey);
+   virtual HRESULT InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey);
    virtual HRESULT InitPostLoad();
    virtual HRESULT InitVBA(BOOL fNew, int id, WCHAR *wzName);
    virtual ISelect *GetISelect();
@@ -417,16 +418,16 @@ public:
    virtual HRESULT ApcProject_Save();
    HRESULT Save(const bool fSaveAs);
    HRESULT SaveToStorage(IStorage *pstg);
-   HRESULT SaveInfo(IStorage* pstg, HCRYPTHASH hcrypthash);
-   HRESULT SaveCustomInfo(IStorage* pstg, IStream *pstmTags, HCRYPTHASH hcrypthash);
-   HRESULT WriteInfoValue(IStorage* pstg, WCHAR *wzName, char *szValue, HCRYPTHASH hcrypthash);
-   HRESULT ReadInfoValue(IStorage* pstg, WCHAR *wzName, char **pszValue, HCRYPTHASH hcrypthash);
-   HRESULT SaveData(IStream* pstm, HCRYPTHASH hcrypthash);
+   HRESULT SaveInfo(IStorage* pstg, HashBuffer *phashbuf);
+   HRESULT SaveCustomInfo(IStorage* pstg, IStream *pstmTags, HashBuffer *phashbuf);
+   HRESULT WriteInfoValue(IStorage* pstg, WCHAR *wzName, char *szValue, HashBuffer *phashbuf);
+   HRESULT ReadInfoValue(IStorage* pstg, WCHAR *wzName, char **pszValue, HashBuffer *phashbuf);
+   HRESULT SaveData(IStream* pstm, HashBuffer *phashbuf);
    HRESULT LoadGameFromFilename(char *szFileName);
    HRESULT LoadGameFromStorage(IStorage *pstgRoot);
-   HRESULT LoadInfo(IStorage* pstg, HCRYPTHASH hcrypthash, int version);
-   HRESULT LoadCustomInfo(IStorage* pstg, IStream *pstmTags, HCRYPTHASH hcrypthash, int version);
-   HRESULT LoadData(IStream* pstm, int& csubobj, int& csounds, int& ctextures, int& cfonts, int& ccollection, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey);
+   HRESULT LoadInfo(IStorage* pstg, HashBuffer *phashbuf, int version);
+   HRESULT LoadCustomInfo(IStorage* pstg, IStream *pstmTags, HashBuffer *phashbuf, int version);
+   HRESULT LoadData(IStream* pstm, int& csubobj, int& csounds, int& ctextures, int& cfonts, int& ccollection, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey);
    void ReadAccelerometerCalibration();
    virtual IEditable *GetIEditable() { return (IEditable *)this; }
    virtual void Delete() {} // Can't delete table itself
@@ -672,6 +673,7 @@ public:
    COLORREF m_rgcolorcustom[16];		// array for the choosecolor in property browser
 
    vector< PinSoundCopy* > m_voldsound; // copied sounds currently playing
+   unsigned int m_soundSerial; // play order of the copies, for voice stealing
 
    float m_TableSoundVolume;
    float m_TableMusicVolume;
@@ -747,6 +749,7 @@ public:
    bool  m_activeLayers[MAX_LAYERS];
    bool  m_toggleAllLayers;
    volatile bool m_savingActive;
+   int   m_compressionLevel; // deflate level of the mesh and image data for the current save, see VPinball::m_saveCompressionLevel
 
    bool  m_renderSolid;
 
@@ -901,4 +904,7 @@ public:
    PinTable *m_pt;
 };
 
+// checks the DMD upscaler (ScaleFX) output against known digests, appends the mismatches to result
+bool ScaleFXTest(std::string &result);
+
 #endif // !defined(AFX_PINTABLE_H__D14A2DAB_2984_4FE7_A102_D0283ECE31B4__INCLUDED_)
@@ -9,9 +9,6 @@
 #include "inc\progmesh.h"
 
 // defined in objloader.cpp
-extern bool WaveFrontObj_Load(const char *filename, const bool flipTv, const bool convertToLeftHanded);
-extern void WaveFrontObj_GetVertices(std::vector<Vertex3D_NoTex2>& verts);
-extern void WaveFrontObj_GetIndices(std::vector<unsigned int>& list);
 extern void WaveFrontObj_Save(const char *filename, const char *description, const Mesh& mesh);
 //
 
@@ -23,17 +20,330 @@ void Mesh::Clear()
    for (size_t i = 0; i < m_animationFrames.size(); i++)
       m_animationFrames[i].m_frameVerts.clear();
    m_animationFrames.clear();
+   m_animation.Clear();
    middlePoint.x = 0.0f;
    middlePoint.y = 0.0f;
    middlePoint.z = 0.0f;
 }
 
+void Mesh::Animation::Clear()
+{
+   m_keyInterval = KEY_INTERVAL;
+   m_numVertices = 0;
+   m_posMin[0] = m_posMin[1] = m_posMin[2] = 0.f;
+   m_posStep[0] = m_posStep[1] = m_posStep[2] = 0.f;
+   m_data.clear();
+   m_frameOffsets.clear();
+   m_state.clear();
+   m_stateFrame = -1;
+   m_cache[0].clear();
+   m_cache[1].clear();
+   m_cacheFrame[0] = m_cacheFrame[1] = -1;
+   m_cacheLast = 0;
+}
+
+static unsigned short QuantizeSnorm16(const float f)
+{
+   return (unsigned short)(short)floorf(clamp(f, -1.f, 1.f) * 32767.f + 0.5f);
+}
+
+// octahedral mapping of the unit sphere onto [-1,1]^2 (the lower hemisphere folded over the diagonals)
+static void EncodeOctahedral(const Mesh::VertData &vd, unsigned short &u, unsigned short &v)
+{
+   const float l1 = fabsf(vd.nx) + fabsf(vd.ny) + fabsf(vd.nz);
+   if (l1 == 0.f) // degenerate normal, decodes to (0,0,1)
+   {
+      u = v = 0;
+      return;
+   }
+   float x = vd.nx / l1;
+   float y = vd.ny / l1;
+   if (vd.nz < 0.f)
+   {
+      const float tx = x;
+      x = (1.f - fabsf(y)) * (tx >= 0.f ? 1.f : -1.f);
+      y = (1.f - fabsf(tx)) * (y >= 0.f ? 1.f : -1.f);
+   }
+   u = QuantizeSnorm16(x);
+   v = QuantizeSnorm16(y);
+}
+
+static void DecodeOctahedral(const unsigned short u, const unsigned short v, Mesh::VertData &vd)
+{
+   float x = (float)(short)u * (float)(1.0 / 32767.0);
+   float y = (float)(short)v * (float)(1.0 / 32767.0);
+   const float z = 1.f - fabsf(x) - fabsf(y);
+   if (z < 0.f)
+   {
+      const float tx = x;
+      x = (1.f - fabsf(y)) * (tx >= 0.f ? 1.f : -1.f);
+      y = (1.f - fabsf(tx)) * (y >= 0.f ? 1.f : -1.f);
+   }
+   const float inv_len = 1.0f / sqrtf(x*x + y*y + z*z);
+   vd.nx = x * inv_len;
+   vd.ny = y * inv_len;
+   vd.nz = z * inv_len;
+}
+
+void Mesh::Animation::Encode(const std::vector<FrameData> &frames, const size_t numVertices)
+{
+   Clear();
+   if (frames.empty())
+      return;
+   m_numVertices = numVertices;
+
+   // quantization range over all frames
+   float posMax[3];
+   for (int c = 0; c < 3; ++c)
+   {
+      m_posMin[c] = FLT_MAX;
+      posMax[c] = -FLT_MAX;
+   }
+   for (size_t f = 0; f < frames.size(); ++f)
+      for (size_t i = 0; i < numVertices; ++i)
+      {
+         const VertData &vd = frames[f].m_frameVerts[i];
+         m_posMin[0] = min(m_posMin[0], vd.x); posMax[0] = max(posMax[0], vd.x);
+         m_posMin[1] = min(m_posMin[1], vd.y); posMax[1] = max(posMax[1], vd.y);
+         m_posMin[2] = min(m_posMin[2], vd.z); posMax[2] = max(posMax[2], vd.z);
+      }
+   float scale[3];
+   for (int c = 0; c < 3; ++c)
+   {
+      const float extent = posMax[c] - m_posMin[c];
+      m_posStep[c] = extent * (float)(1.0 / 65535.0);
+      scale[c] = (extent > 0.f) ? 65535.f / extent : 0.f;
+   }
+
+   std::vector<unsigned short> prev(numVertices * 5), cur(numVertices * 5);
+   m_frameOffsets.resize(frames.size());
+   m_data.reserve(frames.size() * numVertices * 5); // mostly one byte per delta
+   for (size_t f = 0; f < frames.size(); ++f)
+   {
+      const VertData * const v = frames[f].m_frameVerts.data();
+      for (size_t i = 0; i < numVertices; ++i)
+      {
+         unsigned short * const q = &cur[i * 5];
+         q[0] = (unsigned short)min((int)((v[i].x - m_posMin[0]) * scale[0] + 0.5f), 65535);
+         q[1] = (unsigned short)min((int)((v[i].y - m_posMin[1]) * scale[1] + 0.5f), 65535);
+         q[2] = (unsigned short)min((int)((v[i].z - m_posMin[2]) * scale[2] + 0.5f), 65535);
+         EncodeOctahedral(v[i], q[3], q[4]);
+      }
+
+      // key frames are stored as deltas to zero
+      if (f % m_keyInterval == 0)
+         memset(prev.data(), 0, prev.size() * sizeof(unsigned short));
+
+      m_frameOffsets[f] = (unsigned int)m_data.size();
+      for (size_t k = 0; k < cur.size(); ++k)
+      {
+         const short d = (short)(cur[k] - prev[k]);
+         unsigned int zz = (unsigned short)((d << 1) ^ (d >> 15));
+         while (zz >= 0x80)
+         {
+            m_data.push_back((unsigned char)(zz | 0x80));
+            zz >>= 7;
+         }
+         m_data.push_back((unsigned char)zz);
+      }
+      prev.swap(cur);
+   }
+
+   m_state.resize(numVertices * 5);
+}
+
+void Mesh::Animation::DecodeFrame(const unsigned int frame) const
+{
+   unsigned short * const __restrict state = m_state.data();
+   if (frame % m_keyInterval == 0)
+      memset(state, 0, m_state.size() * sizeof(unsigned short));
+
+   const unsigned char * __restrict p = m_data.data() + m_frameOffsets[frame];
+   for (size_t k = 0; k < m_state.size(); ++k)
+   {
+      unsigned int zz = *p++;
+      if (zz & 0x80)
+      {
+         zz = (zz & 0x7F) | ((unsigned int)*p++ << 7);
+         if (zz & 0x4000)
+            zz = (zz & 0x3FFF) | ((unsigned int)*p++ << 14);
+      }
+      state[k] += (unsigned short)((zz >> 1) ^ (0u - (zz & 1)));
+   }
+   m_stateFrame = frame;
+}
+
+const Mesh::VertData* Mesh::Animation::GetFrame(unsigned int frame) const
+{
+   if (frame >= NumFrames())
+      frame = (unsigned int)NumFrames() - 1;
+
+   for (unsigned int slot = 0; slot < 2; ++slot)
+      if (m_cacheFrame[slot] == (int)frame)
+      {
+         m_cacheLast = slot;
+         return m_cache[slot].data();
+      }
+
+   // playback mostly advances by one frame, so continue from the current state, otherwise restart at the key frame
+   const int key = (int)(frame - frame % m_keyInterval);
+   if (m_stateFrame > (int)frame || m_stateFrame < key - 1)
+      m_stateFrame = key - 1;
+   while (m_stateFrame < (int)frame)
+      DecodeFrame(m_stateFrame + 1);
+
+   const unsigned int slot = m_cacheLast ^ 1;
+   std::vector<VertData> &out = m_cache[slot];
+   out.resize(m_numVertices);
+   const unsigned short *q = m_state.data();
+   for (size_t i = 0; i < m_numVertices; ++i, q += 5)
+   {
+      VertData &vd = out[i];
+      vd.x = m_posMin[0] + (float)q[0] * m_posStep[0];
+      vd.y = m_posMin[1] + (float)q[1] * m_posStep[1];
+      vd.z = m_posMin[2] + (float)q[2] * m_posStep[2];
+      DecodeOctahedral(q[3], q[4], vd);
+   }
+   m_cacheFrame[slot] = (int)frame;
+   m_cacheLast = slot;
+   return out.data();
+}
+
+// layout: key interval, frame count, position min and step (3 floats each), frame offsets, data
+void Mesh::Animation::Serialize(std::vector<unsigned char> &out) const
+{
+   const unsigned int header[2] = { m_keyInterval, (unsigned int)m_frameOffsets.size() };
+   out.resize(sizeof(header) + sizeof(m_posMin) + sizeof(m_posStep) + m_frameOffsets.size() * sizeof(unsigned int) + m_data.size());
+   unsigned char *p = out.data();
+   memcpy(p, header, sizeof(header)); p += sizeof(header);
+   memcpy(p, m_posMin, sizeof(m_posMin)); p += sizeof(m_posMin);
+   memcpy(p, m_posStep, sizeof(m_posStep)); p += sizeof(m_posStep);
+   if (!m_frameOffsets.empty())
+   {
+      memcpy(p, m_frameOffsets.data(), m_frameOffsets.size() * sizeof(unsigned int));
+      p += m_frameOffsets.size() * sizeof(unsigned int);
+   }
+   if (!m_data.empty())
+      memcpy(p, m_data.data(), m_data.size());
+}
+
+bool Mesh::Animation::Deserialize(const unsigned char * const data, const size_t size, const size_t numVertices)
+{
+   Clear();
+
+   unsigned int header[2];
+   const size_t headerSize = sizeof(header) + sizeof(m_posMin) + sizeof(m_posStep);
+   if (size < headerSize)
+      return false;
+   const unsigned char *p = data;
+   memcpy(header, p, sizeof(header)); p += sizeof(header);
+   memcpy(m_posMin, p, sizeof(m_posMin)); p += sizeof(m_posMin);
+   memcpy(m_posStep, p, sizeof(m_posStep)); p += sizeof(m_posStep);
+   const unsigned int numFrames = header[1];
+   if (header[0] == 0 || (size - headerSize) / sizeof(unsigned int) < numFrames)
+      return false;
+   m_keyInterval = header[0];
+   m_frameOffsets.resize(numFrames);
+   if (numFrames > 0)
+      memcpy(m_frameOffsets.data(), p, numFrames * sizeof(unsigned int));
+   p += numFrames * sizeof(unsigned int);
+   m_data.assign(p, data + size);
+   m_numVertices = numVertices;
+
+   // check that every frame holds exactly 5 deltas per vertex, so that decoding can skip all checks
+   for (unsigned int f = 0; f < numFrames; ++f)
+   {
+      const size_t end = (f + 1 < numFrames) ? m_frameOffsets[f + 1] : m_data.size();
+      size_t pos = m_frameOffsets[f];
+      size_t count = 0;
+      while (pos < end && end <= m_data.size())
+      {
+         unsigned int len = 1;
+         while ((m_data[pos + len - 1] & 0x80) && len < 3 && pos + len < end)
+            ++len;
+         if (m_data[pos + len - 1] & 0x80)
+            break;
+         pos += len;
+         ++count;
+      }
+      if (pos != end || count != numVertices * 5)
+      {
+         Clear();
+         return false;
+      }
+   }
+
+   m_state.resize(numVertices * 5);
+   return true;
+}
+
+// frame number of a <meshname>_x.obj file
+static int AnimationFrameNumber(const string &filename)
+{
+   const size_t idx = filename.find_last_of('_');
+   return (idx != string::npos) ? atoi(filename.c_str() + idx + 1) : 0;
+}
+
+static bool AnimationFrameLess(const string &a, const string &b)
+{
+   const int fa = AnimationFrameNumber(a);
+   const int fb = AnimationFrameNumber(b);
+   return (fa != fb) ? (fa < fb) : (a < b);
+}
+
+struct AnimationLoadJob
+{
+   Mesh *mesh;
+   const std::vector<string> *files;
+   bool flipTV;
+   bool convertToLeftHanded;
+   std::vector<string> errors; // per frame, empty if the frame was loaded fine
+};
+
+static void LoadAnimationFrames(void *param, const unsigned int begin, const unsigned int end)
+{
+   AnimationLoadJob * const job = (AnimationLoadJob*)param;
+   const Mesh * const mesh = job->mesh;
+   std::vector<Vertex3D_NoTex2> verts;
+   std::vector<unsigned int> indices;
+   for (unsigned int i = begin; i < end; i++)
+   {
+      const string &filename = (*job->files)[i];
+      string &error = job->errors[i];
+      if (!WaveFrontObj_Load(filename.c_str(), job->flipTV, job->convertToLeftHanded, verts, indices, &error))
+      {
+         error = "Unable to load file " + filename + (error.empty() ? string() : ": " + error);
+         continue;
+      }
+
+      // all frames must match the mesh, as only the positions and normals are animated
+      if (verts.size() != mesh->m_vertices.size())
+      {
+         error = "Frame " + filename + " has " + std::to_string((long long)verts.size()) + " vertices, but the mesh has " + std::to_string((long long)mesh->m_vertices.size()) + "!";
+         continue;
+      }
+      if (indices != mesh->m_indices)
+      {
+         error = "Frame " + filename + " has a different topology (faces) than the mesh!";
+         continue;
+      }
+
+      // storage was already allocated by the caller
+      std::vector<Mesh::VertData> &frameVerts = job->mesh->m_animationFrames[i].m_frameVerts;
+      for (size_t t = 0; t < verts.size(); t++)
+      {
+         Mesh::VertData &vd = frameVerts[t];
+         vd.x = verts[t].x; vd.y = verts[t].y; vd.z = verts[t].z;
+         vd.nx = verts[t].nx; vd.ny = verts[t].ny; vd.nz = verts[t].nz;
+      }
+   }
+}
+
 bool Mesh::LoadAnimation(const char *fname, const bool flipTV, const bool convertToLeftHanded)
 {
    WIN32_FIND_DATA data;
    HANDLE h;
    string name(fname);
-   int frameCounter = 0;
    size_t idx = name.find_last_of("_");
    std::vector<string> allFiles;
    if (idx == string::npos)
@@ -43,41 +353,49 @@ bool Mesh::LoadAnimation(const char *fname, const bool flipTV, const bool conver
    }
    idx++;
    name = name.substr(0,idx);
+   // FindFirstFile only returns the file names, so keep the directory
+   const size_t dirEnd = name.find_last_of("\\/");
+   const string dir = (dirEnd != string::npos) ? name.substr(0, dirEnd + 1) : string();
    string sname = name + "*.obj";
    h = FindFirstFile(sname.c_str(), &data);
    if (h != INVALID_HANDLE_VALUE)
    {
       do
       {
-         allFiles.push_back(string(data.cFileName));
-         frameCounter++;
+         allFiles.push_back(dir + data.cFileName);
       } while (FindNextFile(h, &data));
+      FindClose(h);
    }
-   m_animationFrames.resize(frameCounter);
-   for (size_t i = 0; i < allFiles.size(); i++)
-   {
-      sname = allFiles[i];
-      if (WaveFrontObj_Load(sname.c_str(), flipTV, convertToLeftHanded))
-      {
-         std::vector<Vertex3D_NoTex2> verts;
-         WaveFrontObj_GetVertices(verts);
-         for (size_t t = 0; t < verts.size(); t++)
-         {
-            VertData vd;
-            vd.x = verts[t].x; vd.y = verts[t].y; vd.z = verts[t].z;
-            vd.nx = verts[t].nx; vd.ny = verts[t].ny; vd.nz = verts[t].nz;
-            m_animationFrames[i].m_frameVerts.push_back(vd);
-         }
-      }
-      else
+   // by frame number, as the file system returns _10 before _2
+   std::sort(allFiles.begin(), allFiles.end(), AnimationFrameLess);
+
+   const unsigned long long start_usec = usec();
+
+   // preallocate all frames, so that the workers only fill them in
+   m_animationFrames.clear();
+   m_animationFrames.resize(allFiles.size());
+   for (size_t i = 0; i < m_animationFrames.size(); i++)
+      m_animationFrames[i].m_frameVerts.resize(m_vertices.size());
+
+   AnimationLoadJob job;
+   job.mesh = this;
+   job.files = &allFiles;
+   job.flipTV = flipTV;
+   job.convertToLeftHanded = convertToLeftHanded;
+   job.errors.resize(allFiles.size());
+   ParallelFor(LoadAnimationFrames, &job, (unsigned int)allFiles.size(), GetNumCPUCores());
+
+   for (size_t i = 0; i < job.errors.size(); i++)
+      if (!job.errors[i].empty())
       {
-         name = "Unable to load file " + sname;
-         ShowError((char*)name.c_str());
+         m_animationFrames.clear();
+         ShowError(job.errors[i].c_str());
          return false;
       }
 
-   }
-   sname = std::to_string((long long)frameCounter)+" frames imported!";
+   slintf("Mesh::LoadAnimation: %u frames loaded in %.1f ms\n", (unsigned int)allFiles.size(), (double)(usec() - start_usec) / 1000.);
+
+   sname = std::to_string((long long)allFiles.size())+" frames imported!";
    MessageBox(NULL, sname.c_str(), "Info", MB_OK | MB_ICONEXCLAMATION);
    return true;
 }
@@ -86,10 +404,8 @@ bool Mesh::LoadWavefrontObj(const char *fname, const bool flipTV, const bool con
 {
    Clear();
 
-   if (WaveFrontObj_Load(fname, flipTV, convertToLeftHanded))
+   if (WaveFrontObj_Load(fname, flipTV, convertToLeftHanded, m_vertices, m_indices))
    {
-      WaveFrontObj_GetVertices(m_vertices);
-      WaveFrontObj_GetIndices(m_indices);
       float maxX = FLT_MIN, minX = FLT_MAX;
       float maxY = FLT_MIN, minY = FLT_MAX;
       float maxZ = FLT_MIN, minZ = FLT_MAX;
@@ -113,6 +429,15 @@ bool Mesh::LoadWavefrontObj(const char *fname, const bool flipTV, const bool con
       return false;
 }
 
+void Mesh::CompressAnimation()
+{
+   const unsigned long long start_usec = usec();
+   m_animation.Encode(m_animationFrames, m_vertices.size());
+   slintf("Mesh::CompressAnimation: %u frames, %u bytes compressed to %u bytes in %.1f ms\n", (unsigned int)m_animationFrames.size(), (unsigned int)(m_animationFrames.size() * m_vertices.size() * sizeof(VertData)),
+      (unsigned int)m_animation.MemorySize(), (double)(usec() - start_usec) / 1000.);
+   std::vector<FrameData>().swap(m_animationFrames);
+}
+
 void Mesh::SaveWavefrontObj(const char *fname, const char *description)
 {
    if (description == NULL)
@@ -127,11 +452,13 @@ void Mesh::UploadToVB(VertexBuffer * vb, const float frame)
    const float fractpart = modf(frame, &intPart);
    const int iFrame = (int)intPart;
 
-   if (frame != -1.f)
+   if (frame != -1.f && m_animation.NumFrames() > 0)
    {
+      const VertData * const frameVerts = m_animation.GetFrame(iFrame);
+      const VertData * const nextFrameVerts = (fractpart != 0.f && iFrame + 1 < (int)m_animation.NumFrames()) ? m_animation.GetFrame(iFrame + 1) : NULL;
       for (size_t i = 0; i < m_vertices.size(); i++)
       {
-         const VertData &v = m_animationFrames[iFrame].m_frameVerts[i];
+         const VertData &v = frameVerts[i];
          m_vertices[i].x = v.x;
          m_vertices[i].y = v.y;
          m_vertices[i].z = v.z;
@@ -139,9 +466,9 @@ void Mesh::UploadToVB(VertexBuffer * vb, const float frame)
          m_vertices[i].ny = v.ny;
          m_vertices[i].nz = v.nz;
 
-         if (iFrame + 1 < (int)m_animationFrames.size())
+         if (nextFrameVerts)
          {
-            const VertData &v2 = m_animationFrames[iFrame + 1].m_frameVerts[i];
+            const VertData &v2 = nextFrameVerts[i];
             m_vertices[i].x += (v2.x - m_vertices[i].x)*fractpart;
             m_vertices[i].y += (v2.y - m_vertices[i].y)*fractpart;
             m_vertices[i].z += (v2.z - m_vertices[i].z)*fractpart;
@@ -611,7 +938,8 @@ void Primitive::SetupHitObject(vector<HitObject*> &pvho, HitObject * obj)
 
    obj->m_ObjType = ePrimitive;
    obj->m_obj = (IFireEvents *) this;
-   obj->m_e = true;
+   obj->m_group = &m_hitGroup;
+   m_hitGroup.m_fEnabled = obj->m_fEnabled;
 
    if(m_d.m_fHitEvent)
        obj->m_fe = true;
@@ -1139,13 +1467,13 @@ void Primitive::RenderObject(RenderDevice *pd3dDevice)
          if (m_currentFrame != -1.0f && m_DoAnimation)
          {
             m_currentFrame+=m_speed;
-            if (m_currentFrame >= (float)m_mesh.m_animationFrames.size())
+            if (m_currentFrame >= (float)m_mesh.m_animation.NumFrames())
             {
                if (m_Endless)
                   m_currentFrame = 0.0f;
                else
                {
-                  m_currentFrame = (float)(m_mesh.m_animationFrames.size() - 1);
+                  m_currentFrame = (float)(m_mesh.m_animation.NumFrames() - 1);
                   m_DoAnimation = false;
                   vertexBufferRegenerate = false;
                }
@@ -1331,9 +1659,9 @@ void Primitive::PutCenter(const Vertex2D& pv)
 // Save and Load
 //////////////////////////////
 
-HRESULT Primitive::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT Primitive::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    /*
     * Someone decided that it was a good idea to write these vectors including
@@ -1394,14 +1722,11 @@ HRESULT Primitive::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
       lzwwriter.CompressBits(8 + 1);
       }*/
       {
-      const mz_ulong slen = (mz_ulong)(sizeof(Vertex3D_NoTex2)*m_mesh.NumVertices());
-      mz_ulong clen = compressBound(slen);
-      mz_uint8 * c = (mz_uint8 *)malloc(clen);
-      if (compress2(c, &clen, (const unsigned char *)&m_mesh.m_vertices[0], slen, MZ_BEST_COMPRESSION) != Z_OK)
+      std::vector<unsigned char> c;
+      if (!ChunkedDeflate(m_mesh.m_vertices.data(), sizeof(Vertex3D_NoTex2)*m_mesh.NumVertices(), m_ptable->m_compressionLevel, c))
          ShowError("Could not compress primitive vertex data");
-      bw.WriteInt(FID(M3CY), (int)clen);
-      bw.WriteStruct(FID(M3CX), c, clen);
-      free(c);
+      bw.WriteInt(FID(M3CY), (int)c.size());
+      bw.WriteStruct(FID(M3CX), c.data(), (int)c.size());
       }
 #endif
 
@@ -1414,14 +1739,11 @@ HRESULT Primitive::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
          /*bw.WriteTag(FID(M3CI));
           LZWWriter lzwwriter(pstm, (int *)&m_mesh.m_indices[0], sizeof(unsigned int)*m_mesh.NumIndices(), 1, sizeof(unsigned int)*m_mesh.NumIndices());
           lzwwriter.CompressBits(8 + 1);*/
-         const mz_ulong slen = (mz_ulong)(sizeof(unsigned int)*m_mesh.NumIndices());
-         mz_ulong clen = compressBound(slen);
-         mz_uint8 * c = (mz_uint8 *)malloc(clen);
-         if (compress2(c, &clen, (const unsigned char *)&m_mesh.m_indices[0], slen, MZ_BEST_COMPRESSION) != Z_OK)
+         std::vector<unsigned char> c;
+         if (!ChunkedDeflate(m_mesh.m_indices.data(), sizeof(unsigned int)*m_mesh.NumIndices(), m_ptable->m_compressionLevel, c))
             ShowError("Could not compress primitive index data");
-         bw.WriteInt(FID(M3CJ), (int)clen);
-         bw.WriteStruct(FID(M3CI), c, clen);
-         free(c);
+         bw.WriteInt(FID(M3CJ), (int)c.size());
+         bw.WriteStruct(FID(M3CI), c.data(), (int)c.size());
 #endif
       }
       else
@@ -1435,47 +1757,41 @@ HRESULT Primitive::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
          /*bw.WriteTag(FID(M3CI));
           LZWWriter lzwwriter(pstm, (int *)&tmp[0], sizeof(WORD)*m_mesh.NumIndices(), 1, sizeof(WORD)*m_mesh.NumIndices());
           lzwwriter.CompressBits(8 + 1);*/
-         const mz_ulong slen = (mz_ulong)(sizeof(WORD)*m_mesh.NumIndices());
-         mz_ulong clen = compressBound(slen);
-         mz_uint8 * c = (mz_uint8 *)malloc(clen);
-         if (compress2(c, &clen, (const unsigned char *)&tmp[0], slen, MZ_BEST_COMPRESSION) != Z_OK)
+         std::vector<unsigned char> c;
+         if (!ChunkedDeflate(tmp.data(), sizeof(WORD)*m_mesh.NumIndices(), m_ptable->m_compressionLevel, c))
             ShowError("Could not compress primitive index data");
-         bw.WriteInt(FID(M3CJ), (int)clen);
-         bw.WriteStruct(FID(M3CI), c, clen);
-         free(c);
+         bw.WriteInt(FID(M3CJ), (int)c.size());
+         bw.WriteStruct(FID(M3CI), c.data(), (int)c.size());
 #endif
       }
       
-      if (m_mesh.m_animationFrames.size() > 0)
+      if (m_mesh.m_animation.NumFrames() > 0)
       {
-         const mz_ulong slen = (mz_ulong)(sizeof(Mesh::VertData)*m_mesh.NumVertices());
-         for (size_t i = 0; i < m_mesh.m_animationFrames.size(); i++)
-         {
-            mz_ulong clen = compressBound(slen);
-            mz_uint8 * c = (mz_uint8 *)malloc(clen);
-            if (compress2(c, &clen, (const unsigned char *)&m_mesh.m_animationFrames[i].m_frameVerts[0], slen, MZ_BEST_COMPRESSION) != Z_OK)
-               ShowError("Could not compress primitive animation vertex data");
-            bw.WriteInt(FID(M3AY), (int)clen);
-            bw.WriteStruct(FID(M3AX), c, clen);
-            free(c);
-         }
-
+         std::vector<unsigned char> raw;
+         m_mesh.m_animation.Serialize(raw);
+         std::vector<unsigned char> c;
+         if (!ChunkedDeflate(raw.data(), raw.size(), m_ptable->m_compressionLevel, c))
+            ShowError("Could not compress primitive animation vertex data");
+         bw.WriteInt(FID(M3QS), (int)raw.size());
+         bw.WriteInt(FID(M3QY), (int)c.size());
+         bw.WriteStruct(FID(M3QX), c.data(), (int)c.size());
+         slintf("Primitive::SaveData: %u animation frames saved as %u bytes\n", (unsigned int)m_mesh.m_animation.NumFrames(), (unsigned int)c.size());
       }
    }
    bw.WriteFloat(FID(PIDB), m_d.m_depthBias);
 
-   ISelect::SaveData(pstm, hcrypthash);
+   ISelect::SaveData(pstm, phashbuf);
 
    bw.WriteTag(FID(ENDB));
 
    return S_OK;
 }
 
-HRESULT Primitive::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT Primitive::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
 
-   BiffReader br(pstm, this, pid, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, pid, version, phashbuf, hcryptkey);
 
    m_ptable = ptable;
 
@@ -1483,6 +1799,10 @@ HRESULT Primitive::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int versi
    if (!m_d.m_use3DMesh)
       CalculateBuiltinOriginal();
 
+   // tables saved with full precision animation frames
+   if (!m_mesh.m_animationFrames.empty())
+      m_mesh.CompressAnimation();
+
    unsigned int* tmp = reorderForsyth(m_mesh.m_indices.data(), (int)(m_mesh.NumIndices() / 3), (int)m_mesh.NumVertices());
    if (tmp != NULL)
    {
@@ -1494,6 +1814,16 @@ HRESULT Primitive::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int versi
    return S_OK;
 }
 
+// mesh data is stored as chunked deflate since CHUNKED_DEFLATE_FORMAT_VERSION, so that it can be inflated on all cores
+static int UncompressMeshData(const int version, void * const dest, const size_t size, const unsigned char * const src, const int srcSize)
+{
+   if (version >= CHUNKED_DEFLATE_FORMAT_VERSION)
+      return ChunkedInflate(src, srcSize, dest, size) ? Z_OK : Z_DATA_ERROR;
+
+   mz_ulong uclen = (mz_ulong)size;
+   return uncompress((unsigned char *)dest, &uclen, src, srcSize);
+}
+
 BOOL Primitive::LoadToken(int id, BiffReader *pbr)
 {
    if (id == FID(PIID))
@@ -1667,6 +1997,7 @@ BOOL Primitive::LoadToken(int id, BiffReader *pbr)
             m_mesh.m_animationFrames[i].m_frameVerts.clear();
          m_mesh.m_animationFrames.clear();
       }
+      m_mesh.m_animation.Clear();
    }
    else if (id == FID(M3DX))
    {
@@ -1700,6 +2031,30 @@ BOOL Primitive::LoadToken(int id, BiffReader *pbr)
       free(c);
       m_mesh.m_animationFrames.push_back(frameData);
    }
+   else if (id == FID(M3QS))
+   {
+      pbr->GetInt(&animationSize);
+   }
+   else if (id == FID(M3QY))
+   {
+      pbr->GetInt(&compressedAnimationVertices);
+   }
+   else if (id == FID(M3QX))
+   {
+      std::vector<unsigned char> raw(animationSize);
+      mz_uint8 * c = (mz_uint8 *)malloc(compressedAnimationVertices);
+      pbr->GetStruct(c, compressedAnimationVertices);
+      const int error = UncompressMeshData(pbr->m_version, raw.data(), raw.size(), c, compressedAnimationVertices);
+      if (error != Z_OK)
+      {
+         char err[128];
+         sprintf_s(err, "Could not uncompress primitive animation vertex data, error %d", error);
+         ShowError(err);
+      }
+      else if (!m_mesh.m_animation.Deserialize(raw.data(), raw.size(), numVertices))
+         ShowError("Invalid primitive animation vertex data");
+      free(c);
+   }
    else if (id == FID(M3CY))
    {
       pbr->GetInt(&compressedVertices);
@@ -1710,10 +2065,9 @@ BOOL Primitive::LoadToken(int id, BiffReader *pbr)
       m_mesh.m_vertices.resize(numVertices);
       /*LZWReader lzwreader(pbr->m_pistream, (int *)m_mesh.m_vertices.data(), sizeof(Vertex3D_NoTex2)*numVertices, 1, sizeof(Vertex3D_NoTex2)*numVertices);
        lzwreader.Decoder();*/
-      mz_ulong uclen = (mz_ulong)(sizeof(Vertex3D_NoTex2)*m_mesh.NumVertices());
       mz_uint8 * c = (mz_uint8 *)malloc(compressedVertices);
       pbr->GetStruct(c, compressedVertices);
-      const int error = uncompress((unsigned char *)m_mesh.m_vertices.data(), &uclen, c, compressedVertices);
+      const int error = UncompressMeshData(pbr->m_version, m_mesh.m_vertices.data(), sizeof(Vertex3D_NoTex2)*m_mesh.NumVertices(), c, compressedVertices);
       if (error != Z_OK)
       {
          char err[128];
@@ -1752,10 +2106,9 @@ BOOL Primitive::LoadToken(int id, BiffReader *pbr)
       {
          //LZWReader lzwreader(pbr->m_pistream, (int *)m_mesh.m_indices.data(), sizeof(unsigned int)*numIndices, 1, sizeof(unsigned int)*numIndices);
          //lzwreader.Decoder();
-         mz_ulong uclen = (mz_ulong)(sizeof(unsigned int)*m_mesh.NumIndices());
          mz_uint8 * c = (mz_uint8 *)malloc(compressedIndices);
          pbr->GetStruct(c, compressedIndices);
-         const int error = uncompress((unsigned char *)m_mesh.m_indices.data(), &uclen, c, compressedIndices);
+         const int error = UncompressMeshData(pbr->m_version, m_mesh.m_indices.data(), sizeof(unsigned int)*m_mesh.NumIndices(), c, compressedIndices);
          if (error != Z_OK)
          {
             char err[128];
@@ -1770,10 +2123,9 @@ BOOL Primitive::LoadToken(int id, BiffReader *pbr)
 
          //LZWReader lzwreader(pbr->m_pistream, (int *)tmp.data(), sizeof(WORD)*numIndices, 1, sizeof(WORD)*numIndices);
          //lzwreader.Decoder();
-         mz_ulong uclen = (mz_ulong)(sizeof(WORD)*m_mesh.NumIndices());
          mz_uint8 * c = (mz_uint8 *)malloc(compressedIndices);
          pbr->GetStruct(c, compressedIndices);
-         const int error = uncompress((unsigned char *)tmp.data(), &uclen, c, compressedIndices);
+         const int error = UncompressMeshData(pbr->m_version, tmp.data(), sizeof(WORD)*m_mesh.NumIndices(), c, compressedIndices);
          if (error != Z_OK)
          {
             char err[128];
@@ -1921,6 +2273,7 @@ INT_PTR CALLBACK Primitive::ObjImportProc(HWND hwndDlg, UINT uMsg, WPARAM wParam
                            }
                         }
                      }
+                     prim->m_mesh.CompressAnimation();
                   }
                }
                prim->m_d.m_use3DMesh = true;
@@ -2924,6 +3277,7 @@ STDMETHODIMP Primitive::put_Collidable(VARIANT_BOOL newVal)
        if (m_vhoCollidable.size() > 0 && m_vhoCollidable[0]->m_fEnabled != b)
            for (size_t i = 0; i < m_vhoCollidable.size(); i++) //!! costly
                m_vhoCollidable[i]->m_fEnabled = b; //copy to hit-testing on entities composing the object
+       m_hitGroup.m_fEnabled = b;
    }
 
    return S_OK;
@@ -3098,9 +3452,9 @@ STDMETHODIMP Primitive::put_DisplayTexture(VARIANT_BOOL newVal)
 STDMETHODIMP Primitive::PlayAnim(float startFrame, float speed)
 {
    int iFrame = (int)startFrame;
-   if (m_mesh.m_animationFrames.size() > 0 )
+   if (m_mesh.m_animation.NumFrames() > 0 )
    {
-      if (startFrame >= m_mesh.m_animationFrames.size())
+      if (startFrame >= m_mesh.m_animation.NumFrames())
          startFrame = 0.0f;
       if (startFrame < 0.0f)
          startFrame *= 1.0f;
@@ -3117,7 +3471,7 @@ STDMETHODIMP Primitive::PlayAnim(float startFrame, float speed)
 
 STDMETHODIMP Primitive::PlayAnimEndless(float speed)
 {
-   if (m_mesh.m_animationFrames.size() > 0)
+   if (m_mesh.m_animation.NumFrames() > 0)
    {
       m_currentFrame = 0.0f;
       if (speed < 0.0f) speed *= -1.0f;
@@ -3151,8 +3505,8 @@ STDMETHODIMP Primitive::ShowFrame(float frame)
 {
    int iFrame = (int)frame;
    m_DoAnimation = false;
-   if (iFrame >= (int)m_mesh.m_animationFrames.size())
-      frame = (float)(m_mesh.m_animationFrames.size() - 1);
+   if (iFrame >= (int)m_mesh.m_animation.NumFrames())
+      frame = (float)(m_mesh.m_animation.NumFrames() - 1);
    m_currentFrame = frame;
    vertexBufferRegenerate = true;
    return S_OK;
@@ -22,7 +22,49 @@ public:
       std::vector<VertData> m_frameVerts;
    };
 
-   std::vector<FrameData> m_animationFrames;
+   // animation frames in compact form, decoded on the fly during playback:
+   // positions are quantized to 16 bit within the bounds of the whole animation, normals are octahedral encoded with 16 bit per component,
+   // and each frame is stored as zigzag/varint coded deltas to the previous one (with a key frame every KEY_INTERVAL frames for seeking)
+   class Animation
+   {
+   public:
+      enum { KEY_INTERVAL = 16 };
+
+      Animation() { Clear(); }
+      void Clear();
+
+      void Encode(const std::vector<FrameData> &frames, const size_t numVertices);
+
+      // returns the decoded frame, which stays valid until two other frames were requested (so that two neighbours can be interpolated)
+      const VertData* GetFrame(unsigned int frame) const;
+
+      size_t NumFrames() const  { return m_frameOffsets.size(); }
+      size_t MemorySize() const { return m_data.size() + m_frameOffsets.size() * sizeof(unsigned int); }
+
+      // raw (not yet deflated) file representation
+      void Serialize(std::vector<unsigned char> &out) const;
+      bool Deserialize(const unsigned char * const data, const size_t size, const size_t numVertices);
+
+   private:
+      void DecodeFrame(const unsigned int frame) const; // applies the deltas of frame to m_state
+
+      unsigned int m_keyInterval;
+      size_t m_numVertices;
+      float m_posMin[3];
+      float m_posStep[3];
+      std::vector<unsigned char> m_data;         // all frames
+      std::vector<unsigned int> m_frameOffsets;  // start of each frame in m_data
+
+      // decoding state, not part of the data itself
+      mutable std::vector<unsigned short> m_state;       // quantized values of m_stateFrame, 5 per vertex
+      mutable int m_stateFrame;
+      mutable std::vector<VertData> m_cache[2];          // the last two decoded frames
+      mutable int m_cacheFrame[2];
+      mutable unsigned int m_cacheLast;                  // slot of the last requested frame
+   };
+
+   std::vector<FrameData> m_animationFrames;  // full precision, only used while importing/loading, see CompressAnimation()
+   Animation m_animation;
    std::vector<Vertex3D_NoTex2> m_vertices;
    std::vector<unsigned int> m_indices;
 
@@ -31,6 +73,8 @@ public:
    bool LoadWavefrontObj(const char *fname, const bool flipTV, const bool convertToLeftHanded);
    void SaveWavefrontObj(const char *fname, const char *description = NULL);
    bool LoadAnimation(const char *fname, const bool flipTV, const bool convertToLeftHanded);
+   // encodes m_animationFrames into m_animation and frees them
+   void CompressAnimation();
 
    size_t NumVertices() const    { return m_vertices.size(); }
    size_t NumIndices() const     { return m_indices.size(); }
@@ -316,6 +360,7 @@ private:        // private member functions
    int compressedIndices;  // only used during loading
    int compressedVertices; // only used during loading
    int compressedAnimationVertices; // only used during loading
+   int animationSize;      // only used during loading
 #endif
 
    void UpdateEditorView();
@@ -334,6 +379,8 @@ private:        // private data members
 
    std::vector<HitObject*> m_vhoCollidable; // Objects to that may be collide selectable
 
+   HitGroup m_hitGroup; // shared enable flag/bounds of all of the above for the collision tree
+
    //!! outdated(?) information (along with the variable decls) for the old builtin primitive code, kept for reference:
 
    // Vertices for 3d Display
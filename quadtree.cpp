@@ -34,6 +34,7 @@ void HitQuadtree::Initialize()
    g_pplayer->c_quadObjects = (U32)m_vho.size();
 #endif
 
+   InitGroupBounds();
    CreateNextLevel(bounds, 0, 0);
 }
 
@@ -43,11 +44,26 @@ void HitQuadtree::Initialize(const FRect3D& bounds)
    g_pplayer->c_quadObjects = (U32)m_vho.size();
 #endif
 
+   InitGroupBounds();
    CreateNextLevel(bounds, 0, 0);
 }
 
+void HitQuadtree::InitGroupBounds()
+{
+   // the enable flags are left alone, these are maintained by the elements themselves
+   for (size_t i = 0; i < m_vho.size(); ++i)
+      if (m_vho[i]->m_group)
+         m_vho[i]->m_group->m_bounds.Clear();
+
+   for (size_t i = 0; i < m_vho.size(); ++i)
+      if (m_vho[i]->m_group)
+         m_vho[i]->m_group->m_bounds.Extend(m_vho[i]->m_hitBBox);
+}
+
 void HitQuadtree::CreateNextLevel(const FRect3D& bounds, const unsigned int level, unsigned int level_empty)
 {
+   InitUnique();
+
    if (m_vho.size() <= 4) //!! magic
       return;
 
@@ -66,17 +82,12 @@ void HitQuadtree::CreateNextLevel(const FRect3D& bounds, const unsigned int leve
 
    std::vector<HitObject*> vRemain; // hit objects which did not go to a quadrant
 
-   m_unique = m_vho[0]->m_e ? (Primitive *)(m_vho[0]->m_obj) : NULL;
-
    // sort items into appropriate child nodes
    for (size_t i = 0; i < m_vho.size(); i++)
    {
       int oct;
       HitObject * const pho = m_vho[i];
 
-      if ((pho->m_e ? (Primitive *)(pho->m_obj) : NULL) != m_unique) // are all objects in current node unique/belong to the same primitive?
-         m_unique = NULL;
-
       if (pho->m_hitBBox.right < m_vcenter.x)
          oct = 0;
       else if (pho->m_hitBBox.left > m_vcenter.x)
@@ -127,12 +138,29 @@ void HitQuadtree::CreateNextLevel(const FRect3D& bounds, const unsigned int leve
 
          m_children[i]->CreateNextLevel(childBounds, level + 1, level_empty);
       }
+   else
+      for (int i = 0; i < 4; ++i)
+         m_children[i]->InitUnique();
 
    InitSseArrays();
    for (int i = 0; i < 4; ++i)
       m_children[i]->InitSseArrays();
 }
 
+void HitQuadtree::InitUnique()
+{
+   // called before subdividing, so this covers all hit objects of the subtree
+   m_subtreeItems = (unsigned int)m_vho.size();
+
+   m_unique = m_vho.empty() ? NULL : m_vho[0]->m_group;
+   for (size_t i = 1; i < m_vho.size(); i++)
+      if (m_vho[i]->m_group != m_unique) // are all objects in current node unique/belong to the same element?
+      {
+         m_unique = NULL;
+         break;
+      }
+}
+
 void HitQuadtree::InitSseArrays()
 {
    // build SSE boundary arrays of the local hit-object list
@@ -262,7 +290,15 @@ void HitQuadtree::HitTestBallSse(Ball * const pball, CollisionEvent& coll) const
 
    do
    {
-      if (current->m_unique == NULL || current->m_unique->m_d.m_fCollidable) // early out if only one unique primitive stored inside all of the subtree/current node that is also not collidable (at the moment)
+      // early out if only one unique element stored inside all of the subtree/current node that is also not collidable (at the moment) or out of reach of the ball
+      if (current->m_unique != NULL && (!current->m_unique->m_fEnabled || !fRectIntersect3D(pball->m_hitBBox, current->m_unique->m_bounds)))
+      {
+#ifdef DEBUGPHYSICS
+         g_pplayer->c_groupSkipped++;
+         g_pplayer->c_groupSkippedTests += current->m_subtreeItems;
+#endif
+      }
+      else
       {
          if (current->lefts != 0) // does node contain hitables?
          {
@@ -369,6 +405,9 @@ void HitQuadtree::HitTestBallSse(Ball * const pball, CollisionEvent& coll) const
 
 void HitQuadtree::HitTestXRay(Ball * const pball, vector<HitObject*> &pvhoHit, CollisionEvent& coll) const
 {
+   if (m_unique != NULL && !fRectIntersect3D(pball->m_hitBBox, m_unique->m_bounds)) // whole subtree out of reach
+      return;
+
    for (size_t i = 0; i < m_vho.size(); i++)
    {
 #ifdef DEBUGPHYSICS
@@ -8,6 +8,7 @@ public:
    HitQuadtree()
    {
       m_unique = NULL;
+      m_subtreeItems = 0;
       m_fLeaf = true;
       lefts = 0;
       rights = 0;
@@ -31,7 +32,11 @@ private:
    void CreateNextLevel(const FRect3D& bounds, const unsigned int level, unsigned int level_empty);
    void HitTestBallSse(Ball * const pball, CollisionEvent& coll) const;
 
-   Primitive* m_unique; // everything below/including this node shares the same original primitive object (just for early outs if not collidable)
+   void InitGroupBounds();
+   void InitUnique();
+
+   HitGroup* m_unique; // everything below/including this node belongs to the same element (just for early outs if not collidable or out of reach)
+   unsigned int m_subtreeItems; // number of hit objects below/including this node (for the skipped HitTest statistics)
 
    std::vector<HitObject*> m_vho;
    HitQuadtree * __restrict m_children[4];
@@ -858,6 +858,8 @@ void Ramp::SetupHitObject(vector<HitObject*> &pvho, HitObject * obj)
    obj->m_fEnabled = m_d.m_fCollidable;
    obj->m_obj = (IFireEvents*) this;
    obj->m_fe = m_d.m_fHitEvent;
+   obj->m_group = &m_hitGroup;
+   m_hitGroup.m_fEnabled = obj->m_fEnabled;
 
    pvho.push_back(obj);
    m_vhoCollidable.push_back(obj); //remember hit components of primitive
@@ -1284,9 +1286,9 @@ void Ramp::ClearForOverwrite()
    ClearPointsForOverwrite();
 }
 
-HRESULT Ramp::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT Ramp::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteFloat(FID(HTBT), m_d.m_heightbottom);
    bw.WriteFloat(FID(HTTP), m_d.m_heighttop);
@@ -1319,11 +1321,11 @@ HRESULT Ramp::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    bw.WriteString(FID(MAPH), m_d.m_szPhysicsMaterial );
    bw.WriteBool(FID(OVPH), m_d.m_fOverwritePhysics );
 
-   ISelect::SaveData(pstm, hcrypthash);
+   ISelect::SaveData(pstm, phashbuf);
 
    bw.WriteTag(FID(PNTS));
    HRESULT hr;
-   if (FAILED(hr = SavePointData(pstm, hcrypthash)))
+   if (FAILED(hr = SavePointData(pstm, phashbuf)))
       return hr;
 
    bw.WriteTag(FID(ENDB));
@@ -1331,11 +1333,11 @@ HRESULT Ramp::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    return S_OK;
 }
 
-HRESULT Ramp::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT Ramp::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
 
-   BiffReader br(pstm, this, pid, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, pid, version, phashbuf, hcryptkey);
 
    m_ptable = ptable;
 
@@ -2003,6 +2005,7 @@ STDMETHODIMP Ramp::put_Collidable(VARIANT_BOOL newVal)
        if (m_vhoCollidable.size() > 0 && m_vhoCollidable[0]->m_fEnabled != b)
            for (size_t i = 0; i < m_vhoCollidable.size(); i++) //!! costly
                m_vhoCollidable[i]->m_fEnabled = b; //copy to hit checking on entities composing the object
+       m_hitGroup.m_fEnabled = b;
    }
 
    return S_OK;
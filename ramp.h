@@ -152,6 +152,8 @@ private:
 
    std::vector<HitObject*> m_vhoCollidable; // Objects to that may be collide selectable
 
+   HitGroup m_hitGroup; // shared enable flag/bounds of all of the above for the collision tree
+
    VertexBuffer *dynamicVertexBuffer;
    IndexBuffer *dynamicIndexBuffer;
    VertexBuffer *dynamicVertexBuffer2;
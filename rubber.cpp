@@ -606,6 +606,8 @@ void Rubber::SetupHitObject(vector<HitObject*> &pvho, HitObject * obj)
    obj->m_threshold = 2.0f;
    obj->m_obj = (IFireEvents *) this;
    obj->m_fe = m_d.m_fHitEvent;
+   obj->m_group = &m_hitGroup;
+   m_hitGroup.m_fEnabled = obj->m_fEnabled;
 
    pvho.push_back(obj);
    m_vhoCollidable.push_back(obj);	//remember hit components of primitive
@@ -680,9 +682,9 @@ void Rubber::ClearForOverwrite()
    ClearPointsForOverwrite();
 }
 
-HRESULT Rubber::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT Rubber::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteFloat(FID(HTTP), m_d.m_height);
    bw.WriteFloat(FID(HTHI), m_d.m_hitHeight);
@@ -708,11 +710,11 @@ HRESULT Rubber::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    bw.WriteString( FID( MAPH ), m_d.m_szPhysicsMaterial );
    bw.WriteBool( FID( OVPH ), m_d.m_fOverwritePhysics );
 
-   ISelect::SaveData(pstm, hcrypthash);
+   ISelect::SaveData(pstm, phashbuf);
 
    bw.WriteTag(FID(PNTS));
    HRESULT hr;
-   if (FAILED(hr = SavePointData(pstm, hcrypthash)))
+   if (FAILED(hr = SavePointData(pstm, phashbuf)))
       return hr;
 
    bw.WriteTag(FID(ENDB));
@@ -720,11 +722,11 @@ HRESULT Rubber::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    return S_OK;
 }
 
-HRESULT Rubber::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT Rubber::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
    m_d.m_hitHeight = -1.0f;
-   BiffReader br(pstm, this, pid, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, pid, version, phashbuf, hcryptkey);
 
    m_ptable = ptable;
 
@@ -1213,6 +1215,7 @@ STDMETHODIMP Rubber::put_Collidable(VARIANT_BOOL newVal)
        if (m_vhoCollidable.size() > 0 && m_vhoCollidable[0]->m_fEnabled != b)
            for (size_t i = 0; i < m_vhoCollidable.size(); i++) //!! costly
                m_vhoCollidable[i]->m_fEnabled = b; //copy to hit checking on entities composing the object
+       m_hitGroup.m_fEnabled = b;
    }
 
    return S_OK;
@@ -135,6 +135,8 @@ private:
    int m_numIndices;
 
    std::vector<HitObject*> m_vhoCollidable; // Objects to that may be collide selectable
+
+   HitGroup m_hitGroup; // shared enable flag/bounds of all of the above for the collision tree
    std::vector<Vertex3D_NoTex2> m_vertices;
    std::vector<WORD> ringIndices;
 
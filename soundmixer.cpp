@@ -0,0 +1,595 @@
+#include "StdAfx.h"
+
+DSoundMixerSink::DSoundMixerSink(LPDIRECTSOUND pDS, const unsigned int sampleRate, const unsigned int periodFrames, const unsigned int numPeriods)
+{
+   m_pDSBuffer = NULL;
+   m_bufferBytes = periodFrames * numPeriods * 4;
+   m_writePos = 0;
+   m_prefilled = 0;
+   m_queued = 0;
+   m_lastPlayPos = 0;
+   m_underruns = 0;
+
+   if (pDS == NULL)
+      return;
+
+   WAVEFORMATEX wfx;
+   ZeroMemory(&wfx, sizeof(WAVEFORMATEX));
+   wfx.wFormatTag = WAVE_FORMAT_PCM;
+   wfx.nChannels = 2;
+   wfx.nSamplesPerSec = sampleRate;
+   wfx.wBitsPerSample = 16;
+   wfx.nBlockAlign = 4;
+   wfx.nAvgBytesPerSec = sampleRate * 4;
+
+   DSBUFFERDESC dsbd;
+   ZeroMemory(&dsbd, sizeof(DSBUFFERDESC));
+   dsbd.dwSize = sizeof(DSBUFFERDESC);
+   dsbd.dwFlags = DSBCAPS_GETCURRENTPOSITION2 | DSBCAPS_CTRLVOLUME;
+   dsbd.dwBufferBytes = m_bufferBytes;
+   dsbd.lpwfxFormat = &wfx;
+
+   if (FAILED(pDS->CreateSoundBuffer(&dsbd, &m_pDSBuffer, NULL)))
+   {
+      ShowError("Could not create sound mixer buffer.");
+      m_pDSBuffer = NULL;
+   }
+}
+
+DSoundMixerSink::~DSoundMixerSink()
+{
+   if (m_underruns > 0)
+      slintf("DSoundMixerSink: %u underruns\n", m_underruns);
+
+   if (m_pDSBuffer)
+      m_pDSBuffer->Stop();
+   SAFE_RELEASE(m_pDSBuffer);
+}
+
+bool DSoundMixerSink::Write(const short * const frames, const unsigned int count)
+{
+   if (m_pDSBuffer == NULL)
+      return false;
+
+   const DWORD bytes = count * 4;
+   if (m_prefilled >= m_bufferBytes)
+   {
+      // wait until the play cursor has left enough room behind it
+      while (true)
+      {
+         DWORD playPos, writeCursor;
+         if (FAILED(m_pDSBuffer->GetCurrentPosition(&playPos, &writeCursor)))
+            return false;
+         const DWORD played = (playPos + m_bufferBytes - m_lastPlayPos) % m_bufferBytes;
+         m_lastPlayPos = playPos;
+         if (played > 0 && played >= m_queued)
+         {
+            // underrun: the play cursor has caught up with the written data and is playing stale periods,
+            // so continue behind the write cursor instead of at a position that has already been played
+            m_writePos = writeCursor & ~3u;
+            m_queued = (m_writePos + m_bufferBytes - playPos) % m_bufferBytes;
+            m_underruns++;
+         }
+         else
+            m_queued -= played;
+         if (m_bufferBytes - m_queued >= bytes)
+            break;
+         Sleep(1);
+      }
+   }
+
+   VOID *pbData = NULL;
+   VOID *pbData2 = NULL;
+   DWORD dwLength;
+   DWORD dwLength2;
+   if (FAILED(m_pDSBuffer->Lock(m_writePos, bytes, &pbData, &dwLength, &pbData2, &dwLength2, 0L)))
+      return false;
+   memcpy(pbData, frames, dwLength);
+   if (pbData2)
+      memcpy(pbData2, (const char*)frames + dwLength, dwLength2);
+   m_pDSBuffer->Unlock(pbData, dwLength, pbData2, dwLength2);
+   m_writePos = (m_writePos + bytes) % m_bufferBytes;
+   m_queued += bytes;
+
+   if (m_prefilled < m_bufferBytes)
+   {
+      m_prefilled += bytes;
+      if (m_prefilled >= m_bufferBytes)
+         m_pDSBuffer->Play(0, 0, DSBPLAY_LOOPING);
+   }
+
+   return true;
+}
+
+NullMixerSink::NullMixerSink(const unsigned int sampleRate, const bool realTime)
+{
+   m_sampleRate = sampleRate;
+   m_realTime = realTime;
+   m_startUsec = 0;
+   m_frames = 0;
+}
+
+bool NullMixerSink::Write(const short * const frames, const unsigned int count)
+{
+   if (!m_realTime)
+      return true;
+
+   if (m_frames == 0)
+      m_startUsec = usec();
+   m_frames += count;
+
+   // stay at most one period ahead of real time
+   const unsigned long long due = m_startUsec + (m_frames - count) * 1000000ull / m_sampleRate;
+   const unsigned long long now = usec();
+   if (due > now)
+      Sleep((DWORD)((due - now) / 1000));
+
+   return true;
+}
+
+FileMixerSink::FileMixerSink(const char * const szFilename, const unsigned int sampleRate, const bool realTime) : m_pacing(sampleRate, realTime)
+{
+   m_dataBytes = 0;
+   if (fopen_s(&m_file, szFilename, "wb") != 0)
+   {
+      m_file = NULL;
+      return;
+   }
+
+   // header, sizes are patched in the destructor
+   const unsigned int fmt[4] = { 0x00020001 /* PCM, 2 channels */, sampleRate, sampleRate * 4, 0x00100004 /* block align 4, 16 bits */ };
+   const unsigned int size = 0;
+   const unsigned int fmtSize = sizeof(fmt);
+   fwrite("RIFF", 4, 1, m_file);
+   fwrite(&size, 4, 1, m_file);
+   fwrite("WAVEfmt ", 8, 1, m_file);
+   fwrite(&fmtSize, 4, 1, m_file);
+   fwrite(fmt, sizeof(fmt), 1, m_file);
+   fwrite("data", 4, 1, m_file);
+   fwrite(&size, 4, 1, m_file);
+}
+
+FileMixerSink::~FileMixerSink()
+{
+   if (m_file == NULL)
+      return;
+
+   const unsigned int riffSize = 36 + m_dataBytes;
+   fseek(m_file, 4, SEEK_SET);
+   fwrite(&riffSize, 4, 1, m_file);
+   fseek(m_file, 40, SEEK_SET);
+   fwrite(&m_dataBytes, 4, 1, m_file);
+   fclose(m_file);
+}
+
+bool FileMixerSink::Write(const short * const frames, const unsigned int count)
+{
+   if (m_file == NULL)
+      return false;
+
+   m_dataBytes += (unsigned int)fwrite(frames, 4, count, m_file) * 4;
+   return m_pacing.Write(frames, count);
+}
+
+
+SoundMixer::SoundMixer(SoundMixerSink * const sink, const unsigned int sampleRate, const unsigned int periodFrames, const SoundConfigTypes mode)
+{
+   m_sink = sink;
+   m_sampleRate = sampleRate;
+   m_periodFrames = (max(periodFrames, 4u) + 3) & ~3u;
+   m_mode = mode;
+
+   InitializeCriticalSection(&m_cs);
+
+   m_mix = (float*)_aligned_malloc(sizeof(float) * 2 * m_periodFrames, 16);
+   m_out.resize(2 * m_periodFrames);
+
+   m_voiceBudget = 0;
+   m_voiceSerial = 0;
+   m_steals = 0;
+
+   m_thread = NULL;
+   m_exit = false;
+   m_running = false;
+
+   m_periods = 0;
+   m_maxVoices = 0;
+   m_voiceFrames = 0;
+   m_mixUsec = 0;
+}
+
+SoundMixer::~SoundMixer()
+{
+   if (m_thread)
+   {
+      m_exit = true;
+      WaitForSingleObject(m_thread, INFINITE);
+      CloseHandle(m_thread);
+   }
+
+   if (m_periods > 0)
+      slintf("SoundMixer: %u periods of %u frames, %.1f us per period (%.2f%% of real time), %.1f voices average, %u max\n",
+         m_periods, m_periodFrames, (double)m_mixUsec / m_periods,
+         (double)m_mixUsec * m_sampleRate / ((double)m_periods * m_periodFrames * 10000.),
+         (double)m_voiceFrames / ((double)m_periods * m_periodFrames), m_maxVoices);
+
+   delete m_sink;
+
+   for (std::map<const PinSound*, Sample*>::iterator it = m_samples.begin(); it != m_samples.end(); ++it)
+      delete it->second;
+
+   _aligned_free(m_mix);
+   DeleteCriticalSection(&m_cs);
+}
+
+unsigned int WINAPI SoundMixer::ThreadStart(void *param)
+{
+   ((SoundMixer*)param)->Run();
+   return 0;
+}
+
+void SoundMixer::Start()
+{
+   if (m_thread)
+      return;
+
+   m_exit = false;
+   m_running = true;
+   m_thread = (HANDLE)_beginthreadex(NULL, 0, ThreadStart, this, 0, NULL);
+   if (m_thread)
+      SetThreadPriority(m_thread, THREAD_PRIORITY_HIGHEST);
+   else
+      m_running = false;
+}
+
+void SoundMixer::Run()
+{
+   // the sinks wait with Sleep(1), which is only precise enough for a period of a few ms with this
+   timeBeginPeriod(1);
+
+   while (!m_exit)
+   {
+      MixPeriod(m_out.data());
+      if (!m_sink->Write(m_out.data(), m_periodFrames))
+      {
+         slintf("SoundMixer: output failed, mixer stopped\n");
+         break;
+      }
+   }
+
+   timeEndPeriod(1);
+
+   // from now on Play() refuses all sounds, so they fall back to DirectSound buffers
+   EnterCriticalSection(&m_cs);
+   m_running = false;
+   m_voices.clear();
+   LeaveCriticalSection(&m_cs);
+}
+
+const SoundMixer::Sample *SoundMixer::GetSample(PinSound * const pps)
+{
+   std::map<const PinSound*, Sample*>::iterator it = m_samples.find(pps);
+   if (it != m_samples.end())
+      return it->second;
+
+   const WAVEFORMATEX &wfx = pps->m_wfx;
+   if (wfx.wFormatTag != WAVE_FORMAT_PCM || (wfx.nChannels != 1 && wfx.nChannels != 2) || (wfx.wBitsPerSample != 8 && wfx.wBitsPerSample != 16)
+      || wfx.nSamplesPerSec == 0 || pps->m_cdata <= 0)
+      return NULL;
+
+   Sample * const s = new Sample;
+   s->channels = wfx.nChannels;
+   s->rate = wfx.nSamplesPerSec;
+   s->frames = (unsigned int)pps->m_cdata / (wfx.wBitsPerSample / 8 * s->channels);
+   if (s->frames == 0)
+   {
+      delete s;
+      return NULL;
+   }
+   if (wfx.wBitsPerSample == 16 && pps->m_pdata)
+      s->data = (const short*)pps->m_pdata; // use the PinSound data as is, no copy
+   else
+   {
+      std::vector<char> tmp;
+      const char * const pcm = pps->GetPCM(tmp);
+      const unsigned int n = s->frames * s->channels;
+      s->converted.resize(n);
+      if (wfx.wBitsPerSample == 16)
+         memcpy(s->converted.data(), pcm, n * sizeof(short));
+      else
+         for (unsigned int i = 0; i < n; ++i)
+            s->converted[i] = (short)(((int)(unsigned char)pcm[i] - 128) << 8);
+      s->data = s->converted.data();
+   }
+
+   m_samples[pps] = s;
+   return s;
+}
+
+void SoundMixer::CalcGains(const SoundConfigTypes mode, const float volume, const float pan, const float front_rear_fade, float &gainL, float &gainR)
+{
+   // same dB curve as the DirectSound volume in PinSoundCopy::Play() (in 1/100 dB)
+   const float totalvolume = max(min(volume, 100.0f), 0.0f);
+   const float gain = (totalvolume == 0.0f) ? 0.0f : powf(10.0f, (logf(totalvolume)*(float)(1000.0 / log(10.0)) - 2000.0f) * (float)(1.0 / 2000.0));
+
+   if (mode == SNDCFG_SND3D2CH)
+   {
+      // DirectSound pan: attenuates the other side by pan*100 dB
+      const float p = max(min(pan, 1.0f), -1.0f);
+      gainL = gain * ((p > 0.f) ? powf(10.0f, -5.0f * p) : 1.0f);
+      gainR = gain * ((p < 0.f) ? powf(10.0f, 5.0f * p) : 1.0f);
+      return;
+   }
+
+   // 3D modes: position of the source like in PinSoundCopy::Play(), folded to the left/right angle as seen from the listener
+   const float x = PinDirectSound::PanTo3D(pan);
+   float z;
+   switch (mode)
+   {
+   case SNDCFG_SND3DALLREAR:      z = -PinDirectSound::PanTo3D(1.0f); break;
+   case SNDCFG_SND3DFRONTISFRONT: z = PinDirectSound::PanTo3D(front_rear_fade); break;
+   case SNDCFG_SND3DFRONTISREAR:  z = -PinDirectSound::PanTo3D(front_rear_fade); break;
+   case SNDCFG_SND3D6CH:
+   default:                       z = -((PinDirectSound::PanTo3D(front_rear_fade) + 3.0f) / 2.0f); break;
+   }
+   const float side = x / sqrtf(x*x + z*z); // sine of the angle to the source, -1 = left .. 1 = right
+   const float angle = (side + 1.0f) * (float)(M_PI / 4.0);
+   gainL = gain * cosf(angle);
+   gainR = gain * sinf(angle);
+}
+
+bool SoundMixer::Play(PinSound * const pps, const float volume, const float randompitch, const int pitch, const float pan, const float front_rear_fade, const bool loop, const bool usesame, const bool restart)
+{
+   EnterCriticalSection(&m_cs);
+
+   if (!m_running)
+   {
+      LeaveCriticalSection(&m_cs);
+      return false;
+   }
+
+   const Sample * const s = GetSample(pps);
+   if (s == NULL)
+   {
+      LeaveCriticalSection(&m_cs);
+      return false;
+   }
+
+   float gainL, gainR;
+   CalcGains(m_mode, volume, pan, front_rear_fade, gainL, gainR);
+
+   Voice *pv = NULL;
+   if (usesame)
+      for (size_t i = 0; i < m_voices.size(); ++i)
+         if (m_voices[i].pps == pps)
+         {
+            pv = &m_voices[i];
+            break;
+         }
+
+   if (pv == NULL)
+   {
+      if (m_voiceBudget > 0 && m_voices.size() >= m_voiceBudget)
+      {
+         // steal the quietest non-looping voice (oldest first), unless the new one would be even quieter
+         const float level = max(gainL, gainR);
+         Voice *victim = NULL;
+         float victimLevel = FLT_MAX;
+         for (size_t i = 0; i < m_voices.size(); ++i)
+         {
+            Voice &v = m_voices[i];
+            if (v.loop)
+               continue;
+            const float l = max(v.gainL, v.gainR);
+            if (l < victimLevel || (l == victimLevel && victim && (int)(v.serial - victim->serial) < 0))
+            {
+               victim = &v;
+               victimLevel = l;
+            }
+         }
+
+         m_steals++;
+         if (victim == NULL || victimLevel > level)
+         {
+            LeaveCriticalSection(&m_cs);
+            return true; // handled, just not audible
+         }
+         pv = victim;
+      }
+      else
+      {
+         m_voices.push_back(Voice());
+         pv = &m_voices.back();
+      }
+
+      pv->pps = pps;
+      pv->sample = s;
+      pv->pos = 0;
+      pv->serial = m_voiceSerial++;
+   }
+   else if (restart)
+      pv->pos = 0;
+
+   // pitch and random pitch like PinSoundCopy::Play()
+   double freq = (double)s->rate;
+   if (randompitch > 0.f)
+   {
+      freq += pitch;
+      const float rndh = rand_mt_01();
+      const float rndl = rand_mt_01();
+      freq += freq * randompitch * rndh * rndh - freq * randompitch * rndl * rndl * 0.5;
+   }
+   else
+      freq += pitch;
+   pv->step = (unsigned long long)(max(freq, 1.0) / m_sampleRate * 4294967296.0);
+
+   pv->gainL = gainL;
+   pv->gainR = gainR;
+   pv->loop = loop;
+
+   LeaveCriticalSection(&m_cs);
+   return true;
+}
+
+unsigned int SoundMixer::GetNumVoices()
+{
+   EnterCriticalSection(&m_cs);
+   const unsigned int voices = (unsigned int)m_voices.size();
+   LeaveCriticalSection(&m_cs);
+   return voices;
+}
+
+unsigned int SoundMixer::ResetSteals()
+{
+   EnterCriticalSection(&m_cs);
+   const unsigned int steals = m_steals;
+   m_steals = 0;
+   LeaveCriticalSection(&m_cs);
+   return steals;
+}
+
+void SoundMixer::Stop(const PinSound * const pps)
+{
+   EnterCriticalSection(&m_cs);
+   for (size_t i = 0; i < m_voices.size();)
+      if (m_voices[i].pps == pps)
+      {
+         m_voices[i] = m_voices.back();
+         m_voices.pop_back();
+      }
+      else
+         ++i;
+   LeaveCriticalSection(&m_cs);
+}
+
+void SoundMixer::StopAll()
+{
+   EnterCriticalSection(&m_cs);
+   m_voices.clear();
+   LeaveCriticalSection(&m_cs);
+}
+
+// adds count frames of the voice to mix, returns false once a non looping voice has ended
+bool SoundMixer::MixVoice(Voice &v, float * const mix, const unsigned int count)
+{
+   const Sample &s = *v.sample;
+   const short * const src = s.data;
+   const unsigned long long len = (unsigned long long)s.frames << 32;
+   const __m128 gainL = _mm_set1_ps(v.gainL);
+   const __m128 gainR = _mm_set1_ps(v.gainR);
+   const __m128 fracScale = _mm_set1_ps((float)(1.0 / 2147483648.0));
+
+   unsigned int i = 0;
+   while (i < count)
+   {
+      // 4 frames at once, as long as all 4 interpolation pairs are inside the sample
+      if (i + 4 <= count && v.pos + 3 * v.step + (1ull << 32) < len)
+      {
+         unsigned int idx[4];
+         __m128i frac;
+         {
+            unsigned long long p = v.pos;
+            int f[4];
+            for (int k = 0; k < 4; ++k, p += v.step)
+            {
+               idx[k] = (unsigned int)(p >> 32);
+               f[k] = (int)(((unsigned int)p) >> 1); // 31 bit, so it stays positive for the int conversion
+            }
+            frac = _mm_setr_epi32(f[0], f[1], f[2], f[3]);
+         }
+         const __m128 t = _mm_mul_ps(_mm_cvtepi32_ps(frac), fracScale);
+
+         __m128 l, r;
+         if (s.channels == 1)
+         {
+            const __m128 a = _mm_setr_ps(src[idx[0]], src[idx[1]], src[idx[2]], src[idx[3]]);
+            const __m128 b = _mm_setr_ps(src[idx[0] + 1], src[idx[1] + 1], src[idx[2] + 1], src[idx[3] + 1]);
+            const __m128 m = _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t));
+            l = _mm_mul_ps(m, gainL);
+            r = _mm_mul_ps(m, gainR);
+         }
+         else
+         {
+            const __m128 al = _mm_setr_ps(src[idx[0] * 2], src[idx[1] * 2], src[idx[2] * 2], src[idx[3] * 2]);
+            const __m128 bl = _mm_setr_ps(src[idx[0] * 2 + 2], src[idx[1] * 2 + 2], src[idx[2] * 2 + 2], src[idx[3] * 2 + 2]);
+            const __m128 ar = _mm_setr_ps(src[idx[0] * 2 + 1], src[idx[1] * 2 + 1], src[idx[2] * 2 + 1], src[idx[3] * 2 + 1]);
+            const __m128 br = _mm_setr_ps(src[idx[0] * 2 + 3], src[idx[1] * 2 + 3], src[idx[2] * 2 + 3], src[idx[3] * 2 + 3]);
+            l = _mm_mul_ps(_mm_add_ps(al, _mm_mul_ps(_mm_sub_ps(bl, al), t)), gainL);
+            r = _mm_mul_ps(_mm_add_ps(ar, _mm_mul_ps(_mm_sub_ps(br, ar), t)), gainR);
+         }
+
+         float * const dst = mix + i * 2;
+         _mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_unpacklo_ps(l, r)));
+         _mm_storeu_ps(dst + 4, _mm_add_ps(_mm_loadu_ps(dst + 4), _mm_unpackhi_ps(l, r)));
+
+         v.pos += 4 * v.step;
+         i += 4;
+         continue;
+      }
+
+      // single frames around the end of the sample
+      unsigned int idx = (unsigned int)(v.pos >> 32);
+      if (v.pos >= len)
+      {
+         if (!v.loop)
+            return false;
+         v.pos %= len;
+         idx = (unsigned int)(v.pos >> 32);
+      }
+      const unsigned int next = (idx + 1 < s.frames) ? idx + 1 : (v.loop ? 0 : idx);
+      const float t = (float)(unsigned int)v.pos * (float)(1.0 / 4294967296.0);
+      float l, r;
+      if (s.channels == 1)
+      {
+         const float m = (float)src[idx] + (float)(src[next] - src[idx]) * t;
+         l = m;
+         r = m;
+      }
+      else
+      {
+         l = (float)src[idx * 2] + (float)(src[next * 2] - src[idx * 2]) * t;
+         r = (float)src[idx * 2 + 1] + (float)(src[next * 2 + 1] - src[idx * 2 + 1]) * t;
+      }
+      mix[i * 2] += l * v.gainL;
+      mix[i * 2 + 1] += r * v.gainR;
+
+      v.pos += v.step;
+      ++i;
+   }
+
+   return true;
+}
+
+unsigned int SoundMixer::MixPeriod(short * const out)
+{
+   const unsigned long long start = usec();
+
+   memset(m_mix, 0, sizeof(float) * 2 * m_periodFrames);
+
+   EnterCriticalSection(&m_cs);
+   const unsigned int voices = (unsigned int)m_voices.size();
+   for (size_t i = 0; i < m_voices.size();)
+      if (!MixVoice(m_voices[i], m_mix, m_periodFrames))
+      {
+         m_voices[i] = m_voices.back();
+         m_voices.pop_back();
+      }
+      else
+         ++i;
+   LeaveCriticalSection(&m_cs);
+
+   // to 16 bit with saturation
+   for (unsigned int i = 0; i < m_periodFrames * 2; i += 8)
+   {
+      const __m128i a = _mm_cvtps_epi32(_mm_load_ps(m_mix + i));
+      const __m128i b = _mm_cvtps_epi32(_mm_load_ps(m_mix + i + 4));
+      _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(a, b));
+   }
+
+   m_periods++;
+   m_maxVoices = max(m_maxVoices, voices);
+   m_voiceFrames += (unsigned long long)voices * m_periodFrames;
+   m_mixUsec += usec() - start;
+
+   return voices;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <map>
+
+// Software mixer for table sounds: a thread mixes all active voices into a small ring buffer,
+// one period at a time, instead of a DirectSound buffer per PinSoundCopy.
+// Output is always 16 bit stereo, so the 3D sound modes are folded into the left/right balance.
+
+class SoundMixerSink
+{
+public:
+   virtual ~SoundMixerSink() {}
+
+   // false if the output could not be opened, the mixer should not be used then
+   virtual bool IsOpen() const = 0;
+
+   // queues one period of interleaved stereo frames, blocks until there is room for it
+   virtual bool Write(const short * const frames, const unsigned int count) = 0;
+};
+
+// DirectSound streaming buffer holding a few periods, so the period size sets the latency
+class DSoundMixerSink : public SoundMixerSink
+{
+public:
+   DSoundMixerSink(LPDIRECTSOUND pDS, const unsigned int sampleRate, const unsigned int periodFrames, const unsigned int numPeriods);
+   virtual ~DSoundMixerSink();
+
+   virtual bool IsOpen() const { return m_pDSBuffer != NULL; }
+   virtual bool Write(const short * const frames, const unsigned int count);
+
+private:
+   LPDIRECTSOUNDBUFFER m_pDSBuffer;
+   DWORD m_bufferBytes;
+   DWORD m_writePos;
+   DWORD m_prefilled;   // bytes written before playback was started
+   DWORD m_queued;      // bytes written but not played yet
+   DWORD m_lastPlayPos; // play cursor at the last Write()
+   unsigned int m_underruns;
+};
+
+// discards everything, for headless runs and benchmarks; paced to real time if requested, otherwise as fast as possible
+class NullMixerSink : public SoundMixerSink
+{
+public:
+   NullMixerSink(const unsigned int sampleRate, const bool realTime);
+
+   virtual bool IsOpen() const { return true; }
+   virtual bool Write(const short * const frames, const unsigned int count);
+
+private:
+   unsigned int m_sampleRate;
+   bool m_realTime;
+   unsigned long long m_startUsec;
+   unsigned long long m_frames;
+};
+
+// writes a .wav file, for headless tests of the mixed output
+class FileMixerSink : public SoundMixerSink
+{
+public:
+   FileMixerSink(const char * const szFilename, const unsigned int sampleRate, const bool realTime);
+   virtual ~FileMixerSink();
+
+   virtual bool IsOpen() const { return m_file != NULL; }
+   virtual bool Write(const short * const frames, const unsigned int count);
+
+private:
+   FILE *m_file;
+   unsigned int m_dataBytes;
+   NullMixerSink m_pacing;
+};
+
+class SoundMixer
+{
+public:
+   // the mixer owns sink, periodFrames is rounded up to a multiple of 4
+   SoundMixer(SoundMixerSink * const sink, const unsigned int sampleRate, const unsigned int periodFrames, const SoundConfigTypes mode);
+   ~SoundMixer();
+
+   void Start();
+
+   // returns false if the sound format can not be mixed or the mixer thread has stopped, so the caller can fall back to DirectSound
+   bool Play(PinSound * const pps, const float volume, const float randompitch, const int pitch, const float pan, const float front_rear_fade, const bool loop, const bool usesame, const bool restart);
+   void Stop(const PinSound * const pps);
+   void StopAll();
+
+   // mixes the next period into out (periodFrames interleaved stereo frames), returns the number of voices that were mixed
+   unsigned int MixPeriod(short * const out);
+
+   unsigned int GetPeriodFrames() const { return m_periodFrames; }
+
+   // at most maxVoices voices play at once (0 = unlimited), a new voice steals the quietest/oldest non-looping one
+   void SetVoiceBudget(const unsigned int maxVoices) { m_voiceBudget = maxVoices; }
+   unsigned int GetNumVoices();
+   // voices stolen or dropped since the last call
+   unsigned int ResetSteals();
+
+   // left/right gain of a voice, same volume and pan laws as PinSoundCopy::Play()
+   static void CalcGains(const SoundConfigTypes mode, const float volume, const float pan, const float front_rear_fade, float &gainL, float &gainR);
+
+private:
+   // PCM data of a sound as 16 bit, shared by all voices playing it
+   struct Sample
+   {
+      const short *data;
+      unsigned int frames;
+      unsigned int channels;
+      unsigned int rate;
+      std::vector<short> converted; // if the PinSound data can't be used directly (8 bit or packed)
+   };
+
+   struct Voice
+   {
+      const PinSound *pps;
+      const Sample *sample;
+      unsigned long long pos;  // 32.32 fixed point frame position
+      unsigned long long step; // 32.32 fixed point source frames per output frame
+      float gainL;
+      float gainR;
+      unsigned int serial; // play order, the oldest voice is stolen first on equal volume
+      bool loop;
+   };
+
+   const Sample *GetSample(PinSound * const pps);
+   static bool MixVoice(Voice &v, float * const mix, const unsigned int count);
+
+   static unsigned int WINAPI ThreadStart(void *param);
+   void Run();
+
+   SoundMixerSink *m_sink;
+   unsigned int m_sampleRate;
+   unsigned int m_periodFrames;
+   SoundConfigTypes m_mode;
+
+   std::map<const PinSound*, Sample*> m_samples;
+   std::vector<Voice> m_voices;
+   unsigned int m_voiceBudget;
+   unsigned int m_voiceSerial;
+   unsigned int m_steals;
+   CRITICAL_SECTION m_cs; // guards m_voices and m_samples, the mixer thread holds it while mixing a period
+
+   float *m_mix;              // period accumulation buffer, interleaved stereo
+   std::vector<short> m_out;
+
+   HANDLE m_thread;
+   volatile bool m_exit;
+   volatile bool m_running; // cleared by the mixer thread if the sink fails
+
+   // stats, logged on destruction
+   unsigned int m_periods;
+   unsigned int m_maxVoices;
+   unsigned long long m_voiceFrames;
+   unsigned long long m_mixUsec;
+};
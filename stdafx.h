@@ -20,6 +20,8 @@
 
 //#define ENABLE_TRACE // enables all TRACE_FUNCTION() calls to use D3DPERF_Begin/EndEvent
 
+//#define ENABLE_PROFILER // enables all PROFILE_ZONE() scopes (CPU timing of physics/scripts/rendering per thread, exported as Chrome trace JSON)
+
 //#define DEBUG_XXX // helps to detect out-of-bounds access, needs to link dbghelp.lib then
 //#define SLINTF    // enable debug console output
 
@@ -1242,9 +1242,9 @@ void Surface::Translate(const Vertex2D &pvOffset)
    IHaveDragPoints::TranslatePoints(pvOffset);
 }
 
-HRESULT Surface::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT Surface::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteBool(FID(HTEV), m_d.m_fHitEvent);
    bw.WriteBool(FID(DROP), m_d.m_fDroppable);
@@ -1279,11 +1279,11 @@ HRESULT Surface::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    bw.WriteString( FID( MAPH ), m_d.m_szPhysicsMaterial );
    bw.WriteBool( FID( OVPH ), m_d.m_fOverwritePhysics );
 
-   ISelect::SaveData(pstm, hcrypthash);
+   ISelect::SaveData(pstm, phashbuf);
 
    bw.WriteTag(FID(PNTS));
    HRESULT hr;
-   if (FAILED(hr = SavePointData(pstm, hcrypthash)))
+   if (FAILED(hr = SavePointData(pstm, phashbuf)))
       return hr;
 
    bw.WriteTag(FID(ENDB));
@@ -1296,10 +1296,10 @@ void Surface::ClearForOverwrite()
    ClearPointsForOverwrite();
 }
 
-HRESULT Surface::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT Surface::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
-   BiffReader br(pstm, this, pid, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, pid, version, phashbuf, hcryptkey);
 
    m_ptable = ptable;
 
@@ -469,9 +469,9 @@ STDMETHODIMP Textbox::put_Text(BSTR newVal)
    return S_OK;
 }
 
-HRESULT Textbox::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
+HRESULT Textbox::SaveData(IStream *pstm, HashBuffer *phashbuf)
 {
-   BiffWriter bw(pstm, hcrypthash);
+   BiffWriter bw(pstm, phashbuf);
 
    bw.WriteStruct(FID(VER1), &m_d.m_v1, sizeof(Vertex2D));
    bw.WriteStruct(FID(VER2), &m_d.m_v2, sizeof(Vertex2D));
@@ -486,7 +486,7 @@ HRESULT Textbox::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    bw.WriteBool(FID(TRNS), m_d.m_fTransparent);
    bw.WriteBool(FID(IDMD), m_d.m_IsDMD);
 
-   ISelect::SaveData(pstm, hcrypthash);
+   ISelect::SaveData(pstm, phashbuf);
 
    bw.WriteTag(FID(FONT));
    IPersistStream * ips;
@@ -499,11 +499,11 @@ HRESULT Textbox::SaveData(IStream *pstm, HCRYPTHASH hcrypthash)
    return S_OK;
 }
 
-HRESULT Textbox::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HCRYPTHASH hcrypthash, HCRYPTKEY hcryptkey)
+HRESULT Textbox::InitLoad(IStream *pstm, PinTable *ptable, int *pid, int version, HashBuffer *phashbuf, HCRYPTKEY hcryptkey)
 {
    SetDefaults(false);
 
-   BiffReader br(pstm, this, pid, version, hcrypthash, hcryptkey);
+   BiffReader br(pstm, this, pid, version, phashbuf, hcryptkey);
 
    m_ptable = ptable;
 
@@ -584,7 +584,7 @@ BOOL Textbox::LoadToken(int id, BiffReader *pbr)
       IPersistStream * ips;
       m_pIFont->QueryInterface(IID_IPersistStream, (void **)&ips);
 
-      ips->Load(pbr->m_pistream);
+      ips->Load(pbr->GetStream());
    }
    else
    {
@@ -0,0 +1,89 @@
+#include "StdAfx.h"
+
+#ifdef ENABLE_PROFILER
+
+#define PROFILER_RING_SIZE   (1 << 16) // zones per thread (power of 2)
+#define PROFILER_MAX_THREADS 64
+
+struct ProfileEvent
+{
+   const char *m_name;
+   LONGLONG m_start;
+   LONGLONG m_end;
+};
+
+struct ProfileRing
+{
+   ProfileEvent m_events[PROFILER_RING_SIZE];
+   volatile LONG m_head;  // number of events written so far (wraps), only written by the owning thread
+   DWORD m_threadID;
+};
+
+static ProfileRing * volatile s_rings[PROFILER_MAX_THREADS];
+static volatile LONG s_numRings = 0;
+static __declspec(thread) ProfileRing *t_ring = NULL;
+
+void Profiler::Record(const char * const name, const LONGLONG start, const LONGLONG end)
+{
+   ProfileRing *ring = t_ring;
+   if (ring == NULL)
+   {
+      // first zone of this thread: claim a slot, rings are never freed as the exporter may still read them
+      const LONG slot = InterlockedIncrement(&s_numRings) - 1;
+      if (slot >= PROFILER_MAX_THREADS)
+         return;
+      ring = new ProfileRing;
+      ring->m_head = 0;
+      ring->m_threadID = GetCurrentThreadId();
+      t_ring = ring;
+      s_rings[slot] = ring;
+   }
+
+   ProfileEvent &e = ring->m_events[ring->m_head & (PROFILER_RING_SIZE - 1)];
+   e.m_name = name;
+   e.m_start = start;
+   e.m_end = end;
+   _WriteBarrier();
+   ring->m_head = ring->m_head + 1; // publish
+}
+
+bool Profiler::Export(const char * const filename)
+{
+   FILE *f;
+   if (fopen_s(&f, filename, "w") != 0 || !f)
+      return false;
+
+   LARGE_INTEGER freq;
+   QueryPerformanceFrequency(&freq);
+   const double tick2usec = 1000000.0 / (double)freq.QuadPart;
+
+   // the owning threads keep on writing, so skip some of the oldest entries that may be overwritten while reading
+   const LONG margin = PROFILER_RING_SIZE / 16;
+
+   fprintf(f, "{\"traceEvents\":[\n");
+   bool first = true;
+   const LONG numRings = min(s_numRings, (LONG)PROFILER_MAX_THREADS);
+   for (LONG r = 0; r < numRings; ++r)
+   {
+      const ProfileRing * const ring = s_rings[r];
+      if (ring == NULL) // slot claimed, but not yet published
+         continue;
+
+      const LONG head = ring->m_head;
+      _ReadBarrier();
+      const LONG count = min(head, (LONG)PROFILER_RING_SIZE - margin);
+      for (LONG i = head - count; i != head; ++i)
+      {
+         const ProfileEvent &e = ring->m_events[i & (PROFILER_RING_SIZE - 1)];
+         fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", first ? "" : ",\n",
+            e.m_name, (unsigned int)ring->m_threadID, (double)e.m_start * tick2usec, (double)(e.m_end - e.m_start) * tick2usec);
+         first = false;
+      }
+   }
+   fprintf(f, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+   fclose(f);
+   return true;
+}
+
+#endif
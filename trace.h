@@ -31,3 +31,49 @@ public:
 #define TRACE_FUNCTION()
 
 #endif
+
+#ifdef ENABLE_PROFILER
+
+#define _PROFILE_CONCAT(a,b) a ## b
+#define PROFILE_CONCAT(a,b)  _PROFILE_CONCAT(a,b)
+
+#define PROFILE_ZONE(name)   ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+#define PROFILE_FUNCTION()   PROFILE_ZONE(__FUNCTION__)
+
+// CPU side scoped-zone profiler: each thread writes the finished zones into its own ring buffer (no locks, no allocations),
+// Export() writes the last PROFILER_RING_SIZE zones of each thread in the Chrome trace event format (chrome://tracing or ui.perfetto.dev)
+class Profiler
+{
+public:
+   // name must be a string literal (or otherwise outlive the profiler), start/end are QueryPerformanceCounter ticks
+   static void Record(const char * const name, const LONGLONG start, const LONGLONG end);
+
+   static bool Export(const char * const filename);
+};
+
+class ProfileZone
+{
+public:
+   ProfileZone(const char * const name) : m_name(name)
+   {
+      QueryPerformanceCounter(&m_start);
+   }
+
+   ~ProfileZone()
+   {
+      LARGE_INTEGER end;
+      QueryPerformanceCounter(&end);
+      Profiler::Record(m_name, m_start.QuadPart, end.QuadPart);
+   }
+
+private:
+   const char * const m_name;
+   LARGE_INTEGER m_start;
+};
+
+#else
+
+#define PROFILE_ZONE(name)
+#define PROFILE_FUNCTION()
+
+#endif
@@ -545,6 +545,9 @@ void VPinball::InitRegValues()
    else
       m_autosaveTime = -1;
 
+   m_saveCompressionLevel = clamp(GetRegIntWithDefault("Editor", "SaveCompressionLevel", 6), 0, 10);         // MZ_DEFAULT_LEVEL
+   m_autosaveCompressionLevel = clamp(GetRegIntWithDefault("Editor", "AutoSaveCompressionLevel", 1), 0, 10); // MZ_BEST_SPEED
+
    m_securitylevel = GetRegIntWithDefault("Player", "SecurityLevel", DEFAULT_SECURITY_LEVEL);
    DWORD type = REG_DWORD;
    hr = GetRegValue("Editor", "DefaultMaterialColor", &type, &g_pvp->dummyMaterial.m_cBase, 4);
@@ -21,7 +21,10 @@
 #include "AboutDialog.h"
 #include "DrawingOrderDialog.h"
 
-#define CURRENT_FILE_FORMAT_VERSION 1060
+#define CURRENT_FILE_FORMAT_VERSION 1063
+#define QUANTIZED_ANIMATION_FORMAT_VERSION 1063 // primitive animation frames stored quantized and delta coded (M3QS/M3QY/M3QX), older versions drop them
+#define CHUNKED_DEFLATE_FORMAT_VERSION 1062 // primitive meshes stored as chunked deflate (see ChunkedDeflate()), so they can be (de)compressed in parallel
+#define FAST_HASH_FORMAT_VERSION 1061 // XXH64 instead of MD2 for the table integrity hash
 #define NO_ENCRYPTION_FORMAT_VERSION 1050
 #define NEW_SOUND_FORMAT_VERSION 1031 // introduced surround option
 
@@ -168,6 +171,8 @@ public:
    STDMETHOD(QuitPlayer)(int CloseType);
 
    int m_autosaveTime;
+   int m_saveCompressionLevel;     // deflate level (0..10) of the mesh and image data for explicit saves
+   int m_autosaveCompressionLevel; // same for autosave (and undo/copy), trading file size for speed
    static bool m_open_minimized;
 
    HMENU GetMainMenu(int id);
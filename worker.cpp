@@ -119,3 +119,182 @@ void CompleteAutoSave(HANDLE hEvent, LPARAM lParam)
    delete[] wzT;
    delete pasp;
 }
+
+unsigned int GetNumCPUCores()
+{
+   static unsigned int num_cores = 0;
+   if (num_cores == 0)
+   {
+      SYSTEM_INFO sysInfo;
+      GetSystemInfo(&sysInfo);
+      num_cores = max((unsigned int)sysInfo.dwNumberOfProcessors, 1u);
+   }
+   return num_cores;
+}
+
+// Worker threads shared by all ParallelFor/ParallelJob calls. They are created on first use and kept
+// (blocked on the semaphore) until the process ends, so a call only costs a few synchronizations
+// instead of creating and joining a thread per band.
+class WorkerPool
+{
+public:
+   WorkerPool()
+   {
+      InitializeCriticalSection(&m_cs);
+      m_semaphore = CreateSemaphore(NULL, 0, LONG_MAX, NULL);
+      m_started = false;
+   }
+
+   void Submit(ParallelForBand * const bands, const unsigned int count)
+   {
+      EnterCriticalSection(&m_cs);
+      if (!m_started)
+      {
+         m_started = true;
+         const unsigned int num_threads = max(GetNumCPUCores() - 1, 1u); // the calling thread works, too
+         for (unsigned int i = 0; i < num_threads; ++i)
+         {
+            const HANDLE h = (HANDLE)_beginthreadex(NULL, 0, ThreadStart, this, 0, NULL);
+            if (h)
+               CloseHandle(h);
+         }
+      }
+      for (unsigned int i = 0; i < count; ++i)
+         m_queue.push_back(&bands[i]);
+      LeaveCriticalSection(&m_cs);
+      ReleaseSemaphore(m_semaphore, count, NULL);
+   }
+
+   // waits for all bands of the group, running the ones no worker has picked up yet on the calling thread
+   // (keeps nested calls from deadlocking and the caller busy while it waits)
+   void Wait(ParallelForGroup * const group)
+   {
+      for (;;)
+      {
+         ParallelForBand *band = NULL;
+         EnterCriticalSection(&m_cs);
+         for (std::vector<ParallelForBand*>::iterator it = m_queue.begin(); it != m_queue.end(); ++it)
+            if ((*it)->group == group)
+            {
+               band = *it;
+               m_queue.erase(it);
+               break;
+            }
+         LeaveCriticalSection(&m_cs);
+
+         if (!band)
+            break;
+         Run(band); // the worker that wakes up for it finds the queue one shorter, that's fine
+      }
+
+      // only the event tells that the workers are done with the group (and the bands), so it can go away
+      WaitForSingleObject(group->m_done, INFINITE);
+   }
+
+   static void Run(ParallelForBand * const band)
+   {
+      ParallelForGroup * const group = band->group;
+      band->func(band->param, band->begin, band->end);
+      if (InterlockedDecrement(&group->m_pending) == 0)
+         SetEvent(group->m_done);
+   }
+
+private:
+   static unsigned int WINAPI ThreadStart(void *param)
+   {
+      WorkerPool * const pool = (WorkerPool*)param;
+      for (;;)
+      {
+         WaitForSingleObject(pool->m_semaphore, INFINITE);
+
+         ParallelForBand *band = NULL;
+         EnterCriticalSection(&pool->m_cs);
+         if (!pool->m_queue.empty())
+         {
+            band = pool->m_queue.front();
+            pool->m_queue.erase(pool->m_queue.begin());
+         }
+         LeaveCriticalSection(&pool->m_cs);
+
+         if (band)
+            Run(band);
+      }
+      return 0;
+   }
+
+   CRITICAL_SECTION m_cs; // guards m_queue and m_started
+   std::vector<ParallelForBand*> m_queue;
+   HANDLE m_semaphore;    // one count per queued band
+   bool m_started;
+};
+
+static WorkerPool g_workerPool;
+
+static void SetupBands(std::vector<ParallelForBand> &bands, ParallelForGroup * const group, ParallelForFunc func, void * const param, const unsigned int count)
+{
+   const unsigned int num_bands = (unsigned int)bands.size();
+   for (unsigned int i = 0; i < num_bands; ++i)
+   {
+      bands[i].func = func;
+      bands[i].param = param;
+      bands[i].begin = (unsigned int)((unsigned long long)count * i / num_bands);
+      bands[i].end = (unsigned int)((unsigned long long)count * (i + 1) / num_bands);
+      bands[i].group = group;
+   }
+   group->m_pending = (LONG)num_bands;
+}
+
+void ParallelFor(ParallelForFunc func, void * const param, const unsigned int count, unsigned int num_bands)
+{
+   num_bands = min(num_bands, count);
+   if (num_bands <= 1)
+   {
+      func(param, 0, count);
+      return;
+   }
+
+   ParallelForGroup group;
+   group.m_done = CreateEvent(NULL, FALSE, FALSE, NULL);
+   std::vector<ParallelForBand> bands(num_bands);
+   SetupBands(bands, &group, func, param, count);
+
+   g_workerPool.Submit(&bands[1], num_bands - 1);
+
+   WorkerPool::Run(&bands[0]);
+   g_workerPool.Wait(&group);
+   CloseHandle(group.m_done);
+}
+
+ParallelJob::ParallelJob()
+{
+   m_group.m_pending = 0;
+   m_group.m_done = CreateEvent(NULL, FALSE, FALSE, NULL);
+   m_running = false;
+}
+
+ParallelJob::~ParallelJob()
+{
+   Wait();
+   CloseHandle(m_group.m_done);
+}
+
+void ParallelJob::Start(ParallelForFunc func, void * const param, const unsigned int count, unsigned int num_bands)
+{
+   Wait();
+
+   num_bands = max(min(num_bands, count), 1u);
+   m_bands.resize(num_bands);
+   SetupBands(m_bands, &m_group, func, param, count);
+
+   m_running = true;
+   g_workerPool.Submit(&m_bands[0], num_bands);
+}
+
+void ParallelJob::Wait()
+{
+   if (!m_running)
+      return;
+
+   g_workerPool.Wait(&m_group);
+   m_running = false;
+}
@@ -21,3 +21,47 @@ public:
 unsigned int WINAPI VPWorkerThreadStart(void *param);
 
 void CompleteAutoSave(HANDLE hEvent, LPARAM lParam);
+
+// number of logical processors, to size the ParallelFor bands
+unsigned int GetNumCPUCores();
+
+typedef void (*ParallelForFunc)(void *param, const unsigned int begin, const unsigned int end);
+
+// splits [0,count) into num_bands consecutive ranges and runs func on them in parallel,
+// the first one on the calling thread, returns when all are done
+void ParallelFor(ParallelForFunc func, void * const param, const unsigned int count, unsigned int num_bands);
+
+// bands of one ParallelFor/ParallelJob call, m_pending counts the ones not finished yet
+struct ParallelForGroup
+{
+   volatile LONG m_pending;
+   HANDLE m_done; // set when m_pending drops to 0
+};
+
+struct ParallelForBand
+{
+   ParallelForFunc func;
+   void *param;
+   unsigned int begin;
+   unsigned int end;
+   ParallelForGroup *group;
+};
+
+// same split as ParallelFor, but all bands run on other threads and Start() returns immediately,
+// so that the caller can continue with other work; Wait() (or the destructor) waits for them
+class ParallelJob
+{
+public:
+   ParallelJob();
+   ~ParallelJob();
+
+   void Start(ParallelForFunc func, void * const param, const unsigned int count, unsigned int num_bands);
+   void Wait();
+
+   bool IsRunning() const { return m_running; }
+
+private:
+   std::vector<ParallelForBand> m_bands;
+   ParallelForGroup m_group;
+   bool m_running;
+};